@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+
+#include <ecs/ecs.h>
+
+// ECS pool microbenchmarks. Exercises the transform pool through the public
+// API (add, overwrite, has, random get, dense iteration, remove, and
+// spawn/despawn churn) at several entity counts and prints ns/op plus the
+// bytes the pools hold afterwards as CSV. No GPU device is created.
+
+#define MIN_OPS 1000000 // small sizes repeat until at least this many ops
+#define CHURN_CYCLES 16
+
+static const Uint32 sizes[] = {1000, 100000, 1000000};
+#define SIZE_COUNT (sizeof (sizes) / sizeof (sizes[0]))
+
+static volatile float sink;
+
+static Uint32 rng_state = 0x9e3779b9u;
+static Uint32 next_random (void) {
+    // xorshift32
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void shuffle (Entity* entities, Uint32 n) {
+    for (Uint32 i = n - 1; i > 0; i--) {
+        Uint32 j = next_random () % (i + 1);
+        Entity tmp = entities[i];
+        entities[i] = entities[j];
+        entities[j] = tmp;
+    }
+}
+
+static void report (const char* name, Uint32 n, Uint64 ops, Uint64 ns) {
+    printf (
+        "%s,%u,%llu,%.2f,%llu\n", name, n, (unsigned long long) ops,
+        (double) ns / (double) ops, (unsigned long long) ecs_memory_usage ()
+    );
+}
+
+static Uint32 repeats (Uint32 n) {
+    return n >= MIN_OPS ? 1 : MIN_OPS / n;
+}
+
+static void add_one (Entity e) {
+    add_transform (
+        e, (vec3) {(float) e, 0.0f, 0.0f}, (vec3) {0.0f, 0.0f, 0.0f},
+        (vec3) {1.0f, 1.0f, 1.0f}
+    );
+}
+
+// fresh ECS holding entities 0..n-1, each with a transform
+static void populate (Entity* entities, Uint32 n) {
+    free_pools (NULL);
+    for (Uint32 i = 0; i < n; i++) {
+        entities[i] = create_entity ();
+        add_one (entities[i]);
+    }
+}
+
+static void bench_add (Entity* entities, Uint32 n) {
+    Uint32 reps = SDL_max (1u, repeats (n) / 10);
+    Uint64 ns = 0;
+    for (Uint32 r = 0; r < reps; r++) {
+        free_pools (NULL);
+        Uint64 start = SDL_GetTicksNS ();
+        for (Uint32 i = 0; i < n; i++) {
+            entities[i] = create_entity ();
+            add_one (entities[i]);
+        }
+        ns += SDL_GetTicksNS () - start;
+    }
+    report ("add", n, (Uint64) n * reps, ns);
+}
+
+static void bench_overwrite (Entity* entities, Uint32 n) {
+    populate (entities, n);
+    Uint32 reps = repeats (n);
+    Uint64 start = SDL_GetTicksNS ();
+    for (Uint32 r = 0; r < reps; r++) {
+        for (Uint32 i = 0; i < n; i++) add_one (entities[i]);
+    }
+    report ("overwrite", n, (Uint64) n * reps, SDL_GetTicksNS () - start);
+}
+
+static void bench_has (Entity* entities, Uint32 n) {
+    populate (entities, n);
+    shuffle (entities, n);
+    Uint32 reps = repeats (n);
+    Uint32 found = 0;
+    Uint64 start = SDL_GetTicksNS ();
+    for (Uint32 r = 0; r < reps; r++) {
+        for (Uint32 i = 0; i < n; i++) found += has_transform (entities[i]);
+    }
+    Uint64 ns = SDL_GetTicksNS () - start;
+    sink = (float) found;
+    report ("has_random", n, (Uint64) n * reps, ns);
+}
+
+static void bench_get (Entity* entities, Uint32 n) {
+    populate (entities, n);
+    shuffle (entities, n);
+    Uint32 reps = repeats (n);
+    float sum = 0.0f;
+    Uint64 start = SDL_GetTicksNS ();
+    for (Uint32 r = 0; r < reps; r++) {
+        for (Uint32 i = 0; i < n; i++) {
+            sum += get_transform (entities[i])->position.x;
+        }
+    }
+    Uint64 ns = SDL_GetTicksNS () - start;
+    sink = sum;
+    report ("get_random", n, (Uint64) n * reps, ns);
+}
+
+static void bench_iterate (Entity* entities, Uint32 n) {
+    populate (entities, n);
+    Uint32 reps = repeats (n);
+    float sum = 0.0f;
+    Uint64 start = SDL_GetTicksNS ();
+    for (Uint32 r = 0; r < reps; r++) {
+        Uint32 count;
+        TransformComponent* transforms = get_transform_array (&count);
+        for (Uint32 i = 0; i < count; i++) sum += transforms[i].position.x;
+    }
+    Uint64 ns = SDL_GetTicksNS () - start;
+    sink = sum;
+    report ("iterate", n, (Uint64) n * reps, ns);
+}
+
+static void bench_remove (Entity* entities, Uint32 n) {
+    Uint32 reps = SDL_max (1u, repeats (n) / 10);
+    Uint64 ns = 0;
+    for (Uint32 r = 0; r < reps; r++) {
+        populate (entities, n);
+        shuffle (entities, n);
+        Uint64 start = SDL_GetTicksNS ();
+        for (Uint32 i = 0; i < n; i++) remove_transform (entities[i]);
+        ns += SDL_GetTicksNS () - start;
+    }
+    report ("remove_random", n, (Uint64) n * reps, ns);
+}
+
+// spawn and destroy a tenth of the population per cycle; ids are never
+// reused, so the sparse maps keep growing and show up in the bytes column
+static void bench_churn (Entity* entities, Uint32 n) {
+    populate (entities, n);
+    Uint32 batch = SDL_max (1u, n / 10);
+    Entity* spawned = (Entity*) malloc (batch * sizeof (Entity));
+    if (!spawned) {
+        SDL_Log ("Failed to allocate churn batch");
+        return;
+    }
+    Uint64 start = SDL_GetTicksNS ();
+    for (Uint32 c = 0; c < CHURN_CYCLES; c++) {
+        for (Uint32 i = 0; i < batch; i++) {
+            spawned[i] = create_entity ();
+            add_one (spawned[i]);
+        }
+        for (Uint32 i = 0; i < batch; i++) destroy_entity (NULL, spawned[i]);
+    }
+    Uint64 ns = SDL_GetTicksNS () - start;
+    free (spawned);
+    report ("churn", n, (Uint64) batch * CHURN_CYCLES * 2, ns);
+}
+
+int main (int argc, char** argv) {
+    (void) argc;
+    (void) argv;
+#ifdef PROFILER_ENABLED
+    SDL_Log (
+        "Profiler zones are compiled in and add to create/destroy costs; "
+        "configure with -DENABLE_PROFILER=OFF for baseline numbers"
+    );
+#endif
+
+    Entity* entities =
+        (Entity*) malloc (sizes[SIZE_COUNT - 1] * sizeof (Entity));
+    if (!entities) {
+        SDL_Log ("Failed to allocate entity list");
+        return 1;
+    }
+
+    printf ("benchmark,entities,ops,ns_per_op,bytes\n");
+    for (Uint32 s = 0; s < SIZE_COUNT; s++) {
+        Uint32 n = sizes[s];
+        bench_add (entities, n);
+        bench_overwrite (entities, n);
+        bench_has (entities, n);
+        bench_get (entities, n);
+        bench_iterate (entities, n);
+        bench_remove (entities, n);
+        bench_churn (entities, n);
+    }
+
+    free_pools (NULL);
+    free (entities);
+    return 0;
+}
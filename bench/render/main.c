@@ -0,0 +1,693 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL3/SDL_main.h>
+
+#include <microui.h>
+
+#include <assets/asset_loader.h>
+#include <geometry/g_common.h>
+#include <geometry/icosahedron.h>
+#include <geometry/sphere.h>
+#include <gpu/draw_list.h>
+#include <gpu/staging_ring.h>
+#include <jobs/jobs.h>
+#include <material/depth_prepass.h>
+#include <material/m_common.h>
+#include <material/phong_material.h>
+#include <material/pipeline_cache.h>
+#include <profiler/gpu_timer.h>
+#include <profiler/profiler.h>
+#include <ui/ui.h>
+
+// Headless render benchmark. Renders scripted scenes into an offscreen
+// color + depth target for a fixed number of frames and reports per-phase
+// timings as CSV and/or JSON. No window or input is involved, so it runs
+// unattended, including on the lavapipe software Vulkan driver.
+
+#define DEFAULT_WIDTH 1280
+#define DEFAULT_HEIGHT 720
+#define DEFAULT_FRAMES 300
+#define WARMUP_FRAMES 30
+#define BENCH_FOV 70.0f
+#define BENCH_DT (1.0f / 60.0f) // fixed step so runs are reproducible
+#define MAX_ROWS 1024
+#define STREAM_DIVISOR 16 // streaming re-requests count / this meshes a frame
+
+typedef enum {
+    SCENE_ICOSAHEDRONS,
+    SCENE_LIGHTS,
+    SCENE_LABELS,
+    SCENE_STREAMING,
+} SceneKind;
+
+typedef struct {
+    const char* name;
+    SceneKind kind;
+    Uint32 count;
+    bool one_batch; // every mesh has the same state, so must draw in one batch
+} BenchScene;
+
+static BenchScene scenes[] = {
+    {"icosahedrons", SCENE_ICOSAHEDRONS, 1000, true},
+    {"lights", SCENE_LIGHTS, MAX_LIGHTS, true},
+    {"labels", SCENE_LABELS, 200, true},
+    {"streaming", SCENE_STREAMING, 256, false},
+};
+#define SCENE_COUNT (sizeof (scenes) / sizeof (scenes[0]))
+
+typedef enum {
+    PHASE_FRAME,
+    PHASE_UPDATE,
+    PHASE_RENDER,
+    PHASE_RECORD_MESH,
+    PHASE_RECORD_UI,
+    PHASE_GPU_WAIT,
+    PHASE_COUNT
+} BenchPhase;
+
+static const char* phase_names[PHASE_COUNT] = {
+    "frame", "update", "render_system", "record_mesh", "record_ui", "gpu_wait",
+};
+
+typedef struct {
+    const char* scene;
+    Uint32 count;
+    char source[32];
+    char name[96];
+    Uint32 samples;
+    float min_ms;
+    float avg_ms;
+    float p99_ms;
+    float max_ms;
+} BenchRow;
+
+typedef struct {
+    gpu_renderer renderer;
+    UIComponent* ui;
+    Entity camera;
+
+    // scripted motion
+    Entity* spinners;
+    Uint32 spinner_count;
+    Entity* lights;
+    Uint32 light_count;
+    Uint32 label_count;
+    Uint32 stream_count; // spinners whose meshes come through the loader
+    Uint32 stream_next;
+    float time;
+
+    Uint64* samples[PHASE_COUNT];
+    Uint32 frames;
+
+    BenchRow rows[MAX_ROWS];
+    Uint32 row_count;
+} Bench;
+
+static int compare_u64 (const void* a, const void* b) {
+    Uint64 x = *(const Uint64*) a;
+    Uint64 y = *(const Uint64*) b;
+    return (x > y) - (x < y);
+}
+
+static BenchRow* push_row (Bench* bench, const BenchScene* scene) {
+    if (bench->row_count >= MAX_ROWS) return NULL;
+    BenchRow* row = &bench->rows[bench->row_count++];
+    *row = (BenchRow) {.scene = scene->name, .count = scene->count};
+    return row;
+}
+
+// Returns 0 on success, 1 on failure
+static int create_headless_renderer (
+    gpu_renderer* renderer,
+    Uint32 width,
+    Uint32 height
+) {
+    // no window: render_system draws into renderer->color_texture, which it
+    // (re)creates along with the depth target on the first frame
+    renderer->window = NULL;
+    renderer->width = width;
+    renderer->height = height;
+    renderer->format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+
+    renderer->device =
+        SDL_CreateGPUDevice (SDL_GPU_SHADERFORMAT_SPIRV, false, NULL);
+    if (!renderer->device) {
+        SDL_Log ("Couldn't create SDL_GPU_DEVICE: %s", SDL_GetError ());
+        return 1;
+    }
+
+    renderer->white_texture = create_white_texture_array (renderer->device);
+    if (!renderer->white_texture) return 1; // logging handled inside
+
+    renderer->sampler =
+        create_texture_sampler (renderer->device, TEXTURE_ANISOTROPY);
+    if (!renderer->sampler)
+        return 1; // logging handled inside
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+static int spawn_icosahedrons (Bench* bench, Uint32 count, vec3 color) {
+    bench->spinners = (Entity*) malloc (count * sizeof (Entity));
+    if (!bench->spinners) {
+        SDL_Log ("Failed to allocate bench entities");
+        return 1;
+    }
+
+    // one mesh and one material for the lot, each instance shaded from its
+    // own color, so identical state draws as a single batch
+    SDL_GPUDevice* device = bench->renderer.device;
+    MeshComponent ico_mesh = create_icosahedron_mesh (0.5f, device);
+    if (!ico_mesh.vertex_buffer) return 1; // logging handled inside
+    MaterialComponent ico_material =
+        create_phong_material (color, SIDE_FRONT, &bench->renderer);
+    if (!ico_material.pipeline) {
+        release_mesh (device, &ico_mesh);
+        return 1; // logging handled inside
+    }
+
+    // cube grid in front of the camera
+    int side = (int) ceilf (cbrtf ((float) count));
+    float half = (float) (side - 1);
+    int failed = 0;
+    for (Uint32 i = 0; i < count; i++) {
+        int x = (int) i % side;
+        int y = ((int) i / side) % side;
+        int z = (int) i / (side * side);
+
+        // darker toward the back of the grid
+        float shade = 1.0f - 0.5f * (float) z / (float) side;
+        MeshComponent mesh;
+        MaterialComponent material;
+        failed = share_mesh (&ico_mesh, &mesh);
+        if (failed) break; // logging handled in share_mesh()
+        failed = share_material (
+            &ico_material, vec3_scale (color, shade), &material
+        );
+        if (failed) {
+            release_mesh (device, &mesh);
+            break; // logging handled in share_material()
+        }
+        Entity ico = create_entity ();
+        add_mesh (ico, mesh);
+        add_material (ico, material);
+        add_transform (
+            ico,
+            (vec3) {2.0f * (float) x - half, 2.0f * (float) y - half,
+                    2.0f * (float) z + 4.0f},
+            (vec3) {0.0f, 0.0f, 0.0f}, (vec3) {1.0f, 1.0f, 1.0f}
+        );
+        bench->spinners[bench->spinner_count++] = ico;
+    }
+    // the entities hold their own references now
+    release_mesh (device, &ico_mesh);
+    release_material (device, &ico_material);
+    return failed;
+}
+
+typedef struct {
+    float radius;
+    int segments;
+} SphereParams;
+
+// Returns 0 on success, 1 on failure
+// runs on an asset loader thread
+static int build_sphere (const void* params, MeshData* out) {
+    const SphereParams* sphere = (const SphereParams*) params;
+    return build_sphere_mesh (
+        sphere->radius, sphere->segments, sphere->segments / 2, 0.0f,
+        (float) M_PI * 2.0f, 0.0f, (float) M_PI, out
+    ); // logging handled in build_sphere_mesh()
+}
+
+// Returns 0 on success, 1 on failure
+// swaps the next few spinners' meshes for spheres alternating between a
+// coarse and a fine tessellation, so loads are always in flight
+static int stream_meshes (Bench* bench) {
+    Uint32 batch = SDL_max (bench->stream_count / STREAM_DIVISOR, 1);
+    for (Uint32 i = 0; i < batch && bench->stream_count; i++) {
+        Uint32 n = bench->stream_next++;
+        SphereParams params = {
+            .radius = 0.5f,
+            .segments = (n / bench->stream_count) % 2 ? 8 : 32,
+        };
+        if (load_mesh_async (
+                bench->spinners[n % bench->stream_count], build_sphere, &params,
+                sizeof (params)
+            ))
+            return 1; // logging handled in load_mesh_async()
+    }
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+static int spawn_scene (Bench* bench, const BenchScene* scene) {
+    bench->camera = create_entity ();
+    add_transform (
+        bench->camera, (vec3) {0.0f, 0.0f, 0.0f}, (vec3) {0.0f, 0.0f, 0.0f},
+        (vec3) {1.0f, 1.0f, 1.0f}
+    );
+    add_camera (bench->camera, BENCH_FOV, 0.01f, 1000.0f);
+    add_ui (bench->camera, bench->ui);
+
+    Entity ambient = create_entity ();
+    add_ambient_light (ambient, (vec3) {1.0f, 1.0f, 1.0f}, 0.1f);
+
+    switch (scene->kind) {
+    case SCENE_ICOSAHEDRONS:
+        if (spawn_icosahedrons (bench, scene->count, (vec3) {0.0f, 1.0f, 0.0f}))
+            return 1;
+        bench->light_count = 1;
+        break;
+    case SCENE_LIGHTS:
+        if (spawn_icosahedrons (bench, 64, (vec3) {1.0f, 1.0f, 1.0f}))
+            return 1;
+        bench->light_count = SDL_min (scene->count, MAX_LIGHTS);
+        break;
+    case SCENE_LABELS:
+        if (spawn_icosahedrons (bench, 1, (vec3) {0.0f, 1.0f, 0.0f}))
+            return 1;
+        bench->light_count = 1;
+        bench->label_count = scene->count;
+        break;
+    case SCENE_STREAMING:
+        if (spawn_icosahedrons (bench, scene->count, (vec3) {0.0f, 0.0f, 1.0f}))
+            return 1;
+        bench->light_count = 1;
+        bench->stream_count = scene->count;
+        break;
+    }
+
+    bench->lights = (Entity*) malloc (bench->light_count * sizeof (Entity));
+    if (!bench->lights) {
+        SDL_Log ("Failed to allocate bench lights");
+        return 1;
+    }
+    for (Uint32 i = 0; i < bench->light_count; i++) {
+        bench->lights[i] = create_entity ();
+        add_point_light (bench->lights[i], (vec3) {1.0f, 1.0f, 1.0f}, 1.0f);
+        add_transform (
+            bench->lights[i], (vec3) {2.0f, 2.0f, 2.0f},
+            (vec3) {0.0f, 0.0f, 0.0f}, (vec3) {1.0f, 1.0f, 1.0f}
+        );
+    }
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+static int update_scene (Bench* bench) {
+    bench->time += BENCH_DT;
+
+    if (stream_meshes (bench)) return 1;
+    asset_loader_update (bench->renderer.device);
+
+    for (Uint32 i = 0; i < bench->spinner_count; i++) {
+        TransformComponent* trans = get_transform (bench->spinners[i]);
+        vec3 rotation = euler_from_quat (trans->rotation);
+        rotation.x += 0.5f * BENCH_DT;
+        rotation.z += 1.0f * BENCH_DT;
+        trans->rotation = quat_from_euler (rotation);
+    }
+
+    // lights orbit the grid
+    for (Uint32 i = 0; i < bench->light_count; i++) {
+        float angle =
+            bench->time + 2.0f * (float) M_PI * (float) i / bench->light_count;
+        TransformComponent* trans = get_transform (bench->lights[i]);
+        trans->position = (vec3) {6.0f * cosf (angle), 2.0f,
+                                  6.0f + 6.0f * sinf (angle)};
+    }
+
+    UIComponent* ui = get_ui (bench->camera);
+    char buffer[32];
+    for (Uint32 i = 0; i < bench->label_count; i++) {
+        SDL_snprintf (buffer, sizeof (buffer), "label %u: %.2f", i, bench->time);
+        draw_text (
+            ui, bench->renderer.device, buffer, 5.0f + (float) (i % 8) * 150.0f,
+            5.0f + (float) (i / 8) * 14.0f, 1.0f, 1.0f, 1.0f, 1.0f
+        );
+    }
+    return 0;
+}
+
+static void record_phase (
+    Bench* bench,
+    const BenchScene* scene,
+    BenchPhase phase
+) {
+    Uint32 n = bench->frames;
+    if (n == 0) return;
+    Uint64* sorted = bench->samples[phase];
+    Uint64 sum = 0;
+    for (Uint32 i = 0; i < n; i++) sum += sorted[i];
+    qsort (sorted, n, sizeof (Uint64), compare_u64);
+    Uint32 p99 = (Uint32) ceilf ((float) n * 0.99f) - 1;
+
+    BenchRow* row = push_row (bench, scene);
+    if (!row) return;
+    SDL_strlcpy (row->source, "bench", sizeof (row->source));
+    SDL_strlcpy (row->name, phase_names[phase], sizeof (row->name));
+    row->samples = n;
+    row->min_ms = (float) sorted[0] / 1e6f;
+    row->avg_ms = (float) ((double) sum / (double) n / 1e6);
+    row->p99_ms = (float) sorted[p99] / 1e6f;
+    row->max_ms = (float) sorted[n - 1] / 1e6f;
+}
+
+// every profiler zone, GPU passes included (empty with ENABLE_PROFILER=OFF)
+static void record_zones (Bench* bench, const BenchScene* scene) {
+    const ProfilerZoneStats* stats;
+    Uint32 count = profiler_get_stats (&stats);
+    for (Uint32 i = 0; i < count; i++) {
+        BenchRow* row = push_row (bench, scene);
+        if (!row) return;
+        SDL_strlcpy (
+            row->source, profiler_thread_name (stats[i].thread),
+            sizeof (row->source)
+        );
+        if (stats[i].parent) {
+            SDL_snprintf (
+                row->name, sizeof (row->name), "%s/%s", stats[i].parent,
+                stats[i].name
+            );
+        } else {
+            SDL_strlcpy (row->name, stats[i].name, sizeof (row->name));
+        }
+        row->samples = stats[i].frames;
+        row->min_ms = stats[i].min_ms;
+        row->avg_ms = stats[i].avg_ms;
+        row->p99_ms = stats[i].p99_ms;
+        row->max_ms = stats[i].max_ms;
+    }
+}
+
+// Returns 0 on success, 1 on failure
+static int run_scene (Bench* bench, const BenchScene* scene, Uint32 frames) {
+    SDL_Log (
+        "Running scene %s (%u) for %u frames", scene->name, scene->count, frames
+    );
+    if (spawn_scene (bench, scene)) return 1;
+
+    profiler_reset ();
+    bench->frames = 0;
+    Uint32 sync_builds = 0;
+    for (Uint32 f = 0; f < WARMUP_FRAMES + frames; f++) {
+        Uint64 start = SDL_GetTicksNS ();
+        if (update_scene (bench)) return 1;
+        Uint64 updated = SDL_GetTicksNS ();
+
+        Uint64 prerender, preui, postrender;
+        if (render_system (
+                &bench->renderer, bench->camera, &prerender, &preui,
+                &postrender
+            ) != SDL_APP_CONTINUE) {
+            return 1; // logging handled in render_system
+        }
+        Uint64 rendered = SDL_GetTicksNS ();
+
+        // no swapchain to throttle us; wait so every frame is fully timed
+        PROFILE_BEGIN ("gpu wait");
+        SDL_WaitForGPUIdle (bench->renderer.device);
+        PROFILE_END ();
+        Uint64 end = SDL_GetTicksNS ();
+        PROFILE_FRAME_END ();
+
+        if (f + 1 == WARMUP_FRAMES) {
+            profiler_reset ();
+            sync_builds = render_pipeline_sync_builds ();
+        }
+        if (f < WARMUP_FRAMES) continue;
+        Uint32 i = bench->frames++;
+        bench->samples[PHASE_FRAME][i] = end - start;
+        bench->samples[PHASE_UPDATE][i] = updated - start;
+        bench->samples[PHASE_RENDER][i] = rendered - updated;
+        bench->samples[PHASE_RECORD_MESH][i] = preui - prerender;
+        bench->samples[PHASE_RECORD_UI][i] = postrender - preui;
+        bench->samples[PHASE_GPU_WAIT][i] = end - rendered;
+    }
+
+    Uint32 draws = draw_list_count ();
+    Uint32 batches = draw_list_batch_count ();
+    SDL_Log (
+        "Scene %s drew %u meshes in %u indirect draws (%.1f draws per batch) "
+        "from %u cached pipelines",
+        scene->name, draws, batches,
+        batches ? (double) draws / (double) batches : 0.0,
+        pipeline_cache_pipeline_count ()
+    );
+    // state sorting has to bring identical draws together however they were
+    // spawned
+    if (scene->one_batch && draws > 0 && batches != 1) {
+        SDL_Log (
+            "Scene %s split %u draws of one state into %u batches",
+            scene->name, draws, batches
+        );
+        return 1;
+    }
+    // removing meshes and materials must not drop the frame built ahead, or
+    // churn and streaming would quietly render without pipelining
+    sync_builds = render_pipeline_sync_builds () - sync_builds;
+    if (sync_builds > 0) {
+        SDL_Log (
+            "Scene %s built %u of %u frames without pipelining", scene->name,
+            sync_builds, frames
+        );
+        return 1;
+    }
+    for (int p = 0; p < PHASE_COUNT; p++) record_phase (bench, scene, p);
+    record_zones (bench, scene);
+    return 0;
+}
+
+static void end_scene (Bench* bench) {
+    // destroying the entities also cancels their streaming loads
+    free_pools (bench->renderer.device);
+    free (bench->spinners);
+    free (bench->lights);
+    bench->spinners = NULL;
+    bench->lights = NULL;
+    bench->spinner_count = 0;
+    bench->light_count = 0;
+    bench->label_count = 0;
+    bench->stream_count = 0;
+    bench->stream_next = 0;
+    bench->time = 0.0f;
+}
+
+// Returns 0 on success, 1 on failure
+static int write_csv (const Bench* bench, const char* path) {
+    FILE* file = path ? fopen (path, "w") : stdout;
+    if (!file) {
+        SDL_Log ("Failed to open %s for writing", path);
+        return 1;
+    }
+    fprintf (
+        file, "scene,count,source,phase,samples,min_ms,avg_ms,p99_ms,max_ms\n"
+    );
+    for (Uint32 i = 0; i < bench->row_count; i++) {
+        const BenchRow* row = &bench->rows[i];
+        fprintf (
+            file, "%s,%u,%s,%s,%u,%.4f,%.4f,%.4f,%.4f\n", row->scene,
+            row->count, row->source, row->name, row->samples, row->min_ms,
+            row->avg_ms, row->p99_ms, row->max_ms
+        );
+    }
+    if (path) fclose (file);
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+static int write_json (
+    const Bench* bench,
+    const char* path,
+    Uint32 width,
+    Uint32 height,
+    Uint32 frames
+) {
+    FILE* file = fopen (path, "w");
+    if (!file) {
+        SDL_Log ("Failed to open %s for writing", path);
+        return 1;
+    }
+    fprintf (
+        file, "{\"width\":%u,\"height\":%u,\"frames\":%u,\"rows\":[\n", width,
+        height, frames
+    );
+    for (Uint32 i = 0; i < bench->row_count; i++) {
+        const BenchRow* row = &bench->rows[i];
+        fprintf (
+            file,
+            "{\"scene\":\"%s\",\"count\":%u,\"source\":\"%s\",\"phase\":\"%s\","
+            "\"samples\":%u,\"min_ms\":%.4f,\"avg_ms\":%.4f,\"p99_ms\":%.4f,"
+            "\"max_ms\":%.4f}%s\n",
+            row->scene, row->count, row->source, row->name, row->samples,
+            row->min_ms, row->avg_ms, row->p99_ms, row->max_ms,
+            i + 1 < bench->row_count ? "," : ""
+        );
+    }
+    fprintf (file, "]}\n");
+    fclose (file);
+    return 0;
+}
+
+static void usage (const char* argv0) {
+    SDL_Log (
+        "usage: %s [--frames N] [--width W] [--height H] [--scene NAME] "
+        "[--count N] [--compact] [--depth-prepass] [--frames-in-flight N] "
+        "[--csv PATH] [--json PATH]",
+        argv0
+    );
+}
+
+int main (int argc, char** argv) {
+    Uint32 width = DEFAULT_WIDTH;
+    Uint32 height = DEFAULT_HEIGHT;
+    Uint32 frames = DEFAULT_FRAMES;
+    const char* only_scene = NULL;
+    int count_override = 0;
+    const char* csv_path = NULL;
+    const char* json_path = NULL;
+    bool depth_prepass = false;
+    Uint32 frames_in_flight = 0; // 0 renders without pipelining
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (has_value && SDL_strcmp (argv[i], "--frames") == 0) {
+            frames = (Uint32) SDL_atoi (argv[++i]);
+        } else if (has_value && SDL_strcmp (argv[i], "--width") == 0) {
+            width = (Uint32) SDL_atoi (argv[++i]);
+        } else if (has_value && SDL_strcmp (argv[i], "--height") == 0) {
+            height = (Uint32) SDL_atoi (argv[++i]);
+        } else if (has_value && SDL_strcmp (argv[i], "--scene") == 0) {
+            only_scene = argv[++i];
+        } else if (has_value && SDL_strcmp (argv[i], "--count") == 0) {
+            count_override = SDL_atoi (argv[++i]);
+        } else if (SDL_strcmp (argv[i], "--compact") == 0) {
+            set_mesh_vertex_layout (VERTEX_LAYOUT_COMPACT);
+        } else if (SDL_strcmp (argv[i], "--depth-prepass") == 0) {
+            depth_prepass = true;
+        } else if (
+            has_value && SDL_strcmp (argv[i], "--frames-in-flight") == 0
+        ) {
+            frames_in_flight = (Uint32) SDL_atoi (argv[++i]);
+        } else if (has_value && SDL_strcmp (argv[i], "--csv") == 0) {
+            csv_path = argv[++i];
+        } else if (has_value && SDL_strcmp (argv[i], "--json") == 0) {
+            json_path = argv[++i];
+        } else {
+            usage (argv[0]);
+            return 1;
+        }
+    }
+    if (frames == 0 || width == 0 || height == 0) {
+        usage (argv[0]);
+        return 1;
+    }
+
+    // the GPU device needs the video subsystem for its Vulkan loader, but
+    // never a display; the environment can still pick another driver
+    SDL_SetHint (SDL_HINT_VIDEO_DRIVER, "offscreen");
+    if (!SDL_Init (SDL_INIT_VIDEO)) {
+        SDL_Log ("Couldn't initialize SDL: %s", SDL_GetError ());
+        return 1;
+    }
+    if (!TTF_Init ()) {
+        SDL_Log ("Couldn't initialize SDL_ttf: %s", SDL_GetError ());
+        return 1;
+    }
+
+    Bench* bench = (Bench*) calloc (1, sizeof (Bench));
+    if (!bench) {
+        SDL_Log ("Failed to allocate bench state");
+        return 1;
+    }
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        bench->samples[p] = (Uint64*) malloc (frames * sizeof (Uint64));
+        if (!bench->samples[p]) {
+            SDL_Log ("Failed to allocate bench samples");
+            return 1;
+        }
+    }
+
+    if (create_headless_renderer (&bench->renderer, width, height)) return 1;
+    profiler_init ();
+    if (gpu_timer_init (bench->renderer.device)) return 1;
+    if (staging_ring_init (bench->renderer.device)) return 1;
+    if (draw_list_init (bench->renderer.device)) return 1;
+    if (depth_prepass) {
+        if (depth_prepass_init (&bench->renderer)) return 1;
+        bench->renderer.depth_prepass = true;
+    }
+    if (jobs_init (0)) return 1;
+    if (asset_loader_init (0)) return 1;
+    if (frames_in_flight > 0 &&
+        render_pipeline_init (&bench->renderer, frames_in_flight))
+        return 1;
+
+    // one UI for every scene; labels plus whatever microui queues
+    Uint32 max_labels = 0;
+    for (Uint32 s = 0; s < SCENE_COUNT; s++) {
+        if (count_override > 0) scenes[s].count = (Uint32) count_override;
+        if (scenes[s].kind == SCENE_LABELS)
+            max_labels = SDL_max (max_labels, scenes[s].count);
+    }
+    bench->ui = create_ui_component (
+        &bench->renderer, max_labels + 256, 255,
+        "./assets/NotoSans-Regular.ttf", 12.0f
+    );
+    if (!bench->ui) return 1; // logging handled inside function
+
+    int result = 0;
+    bool ran = false;
+    for (Uint32 s = 0; s < SCENE_COUNT; s++) {
+        if (only_scene && SDL_strcmp (only_scene, scenes[s].name) != 0)
+            continue;
+        ran = true;
+        result = run_scene (bench, &scenes[s], frames);
+        end_scene (bench);
+        if (result) break;
+    }
+    if (!ran) {
+        SDL_Log ("Unknown scene %s", only_scene);
+        result = 1;
+    }
+
+    if (!result) result = write_csv (bench, csv_path);
+    if (!result && json_path)
+        result = write_json (bench, json_path, width, height, frames);
+
+    render_pipeline_shutdown ();
+    asset_loader_shutdown ();
+    gpu_timer_shutdown ();
+    staging_ring_shutdown ();
+    draw_list_shutdown ();
+    depth_prepass_shutdown ();
+    jobs_shutdown ();
+    profiler_shutdown ();
+
+    SDL_GPUDevice* device = bench->renderer.device;
+    free (bench->ui->rects);
+    SDL_ReleaseGPUGraphicsPipeline (device, bench->ui->pipeline);
+    SDL_ReleaseGPUShader (device, bench->ui->vertex);
+    SDL_ReleaseGPUShader (device, bench->ui->fragment);
+    SDL_ReleaseGPUBuffer (device, bench->ui->vbo);
+    SDL_ReleaseGPUBuffer (device, bench->ui->ibo);
+    SDL_ReleaseGPUTexture (device, bench->ui->white_texture);
+    SDL_ReleaseGPUSampler (device, bench->ui->sampler);
+    TTF_CloseFont (bench->ui->font);
+    free (bench->ui);
+
+    SDL_ReleaseGPUTexture (device, bench->renderer.color_texture);
+    SDL_ReleaseGPUTexture (device, bench->renderer.depth_texture);
+    SDL_ReleaseGPUTexture (device, bench->renderer.white_texture);
+    SDL_ReleaseGPUSampler (device, bench->renderer.sampler);
+    SDL_DestroyGPUDevice (device);
+
+    for (int p = 0; p < PHASE_COUNT; p++) free (bench->samples[p]);
+    free (bench);
+    TTF_Quit ();
+    SDL_Quit ();
+    return result;
+}
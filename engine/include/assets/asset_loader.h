@@ -0,0 +1,56 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include <ecs/ecs.h>
+#include <geometry/g_common.h>
+
+// Background asset loading. Loader threads do the CPU side of a load
+// (decoding images, generating meshes) and hand the results back through a
+// lock-free queue; asset_loader_update() then uploads everything that has
+// finished in a single copy pass and attaches it to its entity. The GPU
+// device is only ever used by the thread calling asset_loader_update(), and
+// requests must be made from that same thread.
+//
+// Meshes are built in the generator layout current when the loader thread
+// runs, so call set_mesh_vertex_layout() before queueing any.
+
+#define ASSET_LOADER_MAX_THREADS 8
+
+// Returns 0 on success, 1 on failure
+// runs on a loader thread with the caller's copy of params
+typedef int (*MeshBuilder) (const void* params, MeshData* out);
+
+// Returns 0 on success, 1 on failure
+// num_threads of 0 uses one per logical core beyond the main thread's
+int asset_loader_init (Uint32 num_threads);
+// drops queued and finished loads that were never attached
+void asset_loader_shutdown (void);
+
+// Returns 0 on success, 1 on failure
+// the mesh replaces the entity's current one once it is uploaded; a mesh
+// load still pending for the entity is cancelled, so the newest one wins
+int load_mesh_async (
+    Entity e,
+    MeshBuilder build,
+    const void* params,
+    size_t params_size
+);
+
+// Returns 0 on success, 1 on failure
+// the texture goes into a texture array layer and replaces that of the
+// entity's material once it is uploaded; the material must exist by then (a
+// material without one draws white until it does). As with meshes, a texture
+// load still pending for the entity is cancelled
+int load_texture_async (Entity e, const char* path);
+
+// loads still on their way to e are discarded; the running loader also
+// registers it as a destroy_entity() callback
+void cancel_asset_loads (Entity e);
+
+// loads queued but not yet attached
+Uint32 asset_loader_pending (void);
+
+// call once per frame from the main thread
+void asset_loader_update (SDL_GPUDevice* device);
@@ -16,9 +16,16 @@ typedef enum {
     SIDE_DOUBLE,
 } MaterialSide;
 
+typedef enum {
+    VERTEX_LAYOUT_STANDARD, // 32 bytes: pos3, normal3, uv2 as f32
+    VERTEX_LAYOUT_COMPACT,  // 16 bytes: snorm16 pos4, octahedral snorm16
+                            // normal2, f16 uv2
+    VERTEX_LAYOUT_SEPARATE, // pos3, normal3, uv2 as f32 in three streams of
+                            // one buffer, as glTF stores them
+} VertexLayout;
+
+// per-frame uniforms shared by the vertex and fragment stages
 typedef struct {
-    vec4 color;
-    float model[16];
     float view[16];
     float proj[16];
     vec4 ambient_color[MAX_LIGHTS];     // RGB + Strength
@@ -27,6 +34,14 @@ typedef struct {
     vec4 camera_pos;
 } UBOData;
 
+// per-draw data, read by the vertex shaders as instance attributes
+typedef struct {
+    float model[16];
+    vec4 color;      // rgb, w: layer in the material's texture array
+    vec4 pos_scale;  // compact positions decode as snorm * scale + offset
+    vec4 pos_offset; // w: bounding sphere radius, for culling
+} ObjectData;
+
 typedef Uint32 Entity;
 
 typedef struct {
@@ -35,21 +50,53 @@ typedef struct {
     vec3 scale;
 } TransformComponent;
 
-typedef struct {
+// coarser levels take over each time the projected diameter halves below
+// this many pixels
+#define MESH_LOD_PIXELS 256.0f
+
+typedef struct MeshComponent MeshComponent;
+struct MeshComponent {
+    // both buffers are shared with other meshes (gpu/buffer_heap.h); the mesh
+    // starts at these byte offsets into them
     SDL_GPUBuffer* vertex_buffer;
+    Uint32 vertex_offset;
     Uint32 num_vertices;
     SDL_GPUBuffer* index_buffer;
+    Uint32 index_offset;
     Uint32 num_indices;
     SDL_GPUIndexElementSize index_size;
-} MeshComponent;
+    VertexLayout layout;
+    // separate layout: pos, normal, uv stream offsets past vertex_offset
+    Uint32 stream_offsets[3];
+    vec3 pos_scale; // dequantization for compact positions
+    vec3 pos_offset;
+    float radius; // bounding sphere around the local origin
+    Uint32 lod_count;
+    MeshComponent* lods; // coarser levels, each with no lods of its own
+    Uint32* refs; // copies sharing the buffers and lods, NULL for one
+};
+
+typedef struct TextureArray TextureArray; // material/texture_array.h
 
 typedef struct {
     vec3 color;
-    SDL_GPUTexture* texture;
+    TextureArray* texture_array; // NULL samples the renderer's white texture
+    Uint32 texture_layer;
+    // shaders and pipelines are references into material/pipeline_cache.h,
+    // so only the first material with the same state creates them
     SDL_GPUShader* vertex_shader;
     SDL_GPUShader* fragment_shader;
     SDL_GPUGraphicsPipeline* pipeline;
+    SDL_GPUShader* compact_vertex_shader; // for VERTEX_LAYOUT_COMPACT meshes
+    SDL_GPUGraphicsPipeline* compact_pipeline;
+    SDL_GPUGraphicsPipeline* separate_pipeline; // VERTEX_LAYOUT_SEPARATE
+    // the same three testing depth EQUAL without writing it, for after the
+    // depth pre-pass
+    SDL_GPUGraphicsPipeline* equal_pipeline;
+    SDL_GPUGraphicsPipeline* equal_compact_pipeline;
+    SDL_GPUGraphicsPipeline* equal_separate_pipeline;
     MaterialSide side;
+    bool blended; // see set_material_blended()
 } MaterialComponent;
 
 typedef struct {
@@ -67,6 +114,7 @@ typedef struct {
     SDL_FRect rect;
     SDL_FColor color;
     SDL_GPUTexture* texture;
+    SDL_Rect clip; // zero size for unclipped
 } UIRect;
 
 typedef struct {
@@ -104,11 +152,23 @@ typedef vec4 PointLightComponent; // position is another component
 Entity create_entity (void);
 void destroy_entity (SDL_GPUDevice* device, Entity e);
 
+#define MAX_DESTROY_CALLBACKS 8
+
+// runs for each entity destroy_entity() is about to strip, so modules that
+// hold on to entities (the asset loader) can let go of them
+typedef void (*DestroyCallback) (Entity e);
+
+// Returns 0 on success, 1 on failure
+int add_destroy_callback (DestroyCallback callback);
+void remove_destroy_callback (DestroyCallback callback);
+
 // Transforms
 void add_transform (Entity e, vec3 pos, vec3 rot, vec3 scale);
 TransformComponent* get_transform (Entity e);
 bool has_transform (Entity e);
 void remove_transform (Entity e);
+// dense view, valid until the next transform is added or removed
+TransformComponent* get_transform_array (Uint32* count);
 
 // Meshes
 void add_mesh (Entity e, MeshComponent mesh);
@@ -168,13 +228,20 @@ typedef struct {
     Uint32 height;
     Uint32 dwidth;
     Uint32 dheight;
+    SDL_GPUTexture* color_texture; // mesh pass target, blitted to swapchain
     SDL_GPUTexture* depth_texture;
-    SDL_GPUTexture* white_texture;
+    SDL_GPUTexture* white_texture; // from create_white_texture_array()
     SDL_GPUSampler* sampler;
     SDL_GPUTextureFormat format;
+    // lay down depth first so each pixel is shaded once; needs
+    // depth_prepass_init() and can change every frame
+    bool depth_prepass;
 } gpu_renderer;
 void fps_controller_event_system (SDL_Event* event);
 void fps_controller_update_system (float dt);
+// UI geometry, text and the draw list go up through the staging ring, so
+// staging_ring_init() and draw_list_init() must have been called on the
+// renderer's device
 SDL_AppResult render_system (
     gpu_renderer* renderer,
     Entity cam,
@@ -183,4 +250,24 @@ SDL_AppResult render_system (
     Uint64* postrender
 );
 
+// Returns 0 on success, 1 on failure
+// pipelines render_system(): each call builds the world's draws on a frame
+// thread while the main thread submits those built by the call before, so
+// what is drawn lags the world by one call. frames_in_flight (1 to 3) is how
+// many frames the GPU may queue before acquiring the swapchain waits.
+int render_pipeline_init (gpu_renderer* renderer, Uint32 frames_in_flight);
+void render_pipeline_shutdown (void);
+// drops the frame built ahead, so the next render_system() builds and draws
+// the world as it is; call before releasing GPU resources the world draws
+// with (texture arrays and set_material_blended() do it themselves).
+// Removed meshes and materials instead stay alive until the frame built
+// ahead has been submitted, so churn keeps pipelining.
+void render_pipeline_invalidate (void);
+// frames render_system() had to build on the main thread since
+// render_pipeline_init(), for statistics
+Uint32 render_pipeline_sync_builds (void);
+
+// bytes reserved by all component pools (dense data and entity maps)
+Uint64 ecs_memory_usage (void);
+
 void free_pools (SDL_GPUDevice* device);
\ No newline at end of file
@@ -8,4 +8,15 @@ MeshComponent create_capsule_mesh (
     int cap_segments,
     int radial_segments,
     SDL_GPUDevice* device
+);
+
+// create_capsule_mesh plus up to lod_count coarser levels, halving both
+// segment counts per level
+MeshComponent create_capsule_mesh_lods (
+    float radius,
+    float height,
+    int cap_segments,
+    int radial_segments,
+    int lod_count,
+    SDL_GPUDevice* device
 );
\ No newline at end of file
@@ -12,4 +12,19 @@ MeshComponent create_cylinder_mesh (
     float theta_start,
     float theta_length,
     SDL_GPUDevice* device
+);
+
+// create_cylinder_mesh plus up to lod_count coarser levels, halving both
+// segment counts per level
+MeshComponent create_cylinder_mesh_lods (
+    float radius_top,
+    float radius_bottom,
+    float height,
+    int radial_segments,
+    int height_segments,
+    bool open_ended,
+    float theta_start,
+    float theta_length,
+    int lod_count,
+    SDL_GPUDevice* device
 );
\ No newline at end of file
@@ -2,28 +2,211 @@
 
 #include <SDL3/SDL_gpu.h>
 
+#include <ecs/ecs.h>
+
+// VERTEX_LAYOUT_COMPACT vertex as it sits in the vertex buffer
+typedef struct {
+    Sint16 position[4]; // snorm, w unused
+    Sint16 normal[2];   // snorm octahedral
+    Uint16 uv[2];       // half float
+} CompactVertex;
+
+#define VERTEX_ATTRIBUTE_COUNT 3 // position, normal, uv
+
+// Returns the number of vertex buffers layout reads from and fills in their
+// descriptions and the attributes
+Uint32 get_vertex_layout (
+    VertexLayout layout,
+    SDL_GPUVertexAttribute attributes[VERTEX_ATTRIBUTE_COUNT],
+    SDL_GPUVertexBufferDescription buffers[VERTEX_ATTRIBUTE_COUNT]
+);
+
+#define OBJECT_ATTRIBUTE_COUNT 7 // model columns, color, pos scale and offset
+
+// describes ObjectData as per-instance attributes read from buffer slot,
+// at the locations after the vertex attributes
+void get_object_layout (
+    Uint32 slot,
+    SDL_GPUVertexAttribute attributes[OBJECT_ATTRIBUTE_COUNT],
+    SDL_GPUVertexBufferDescription* buffer
+);
+
+// read-only view of a whole file, memory mapped where the platform allows
+typedef struct {
+    const Uint8* data;
+    size_t size;
+    bool mapped; // mmap'd rather than read into memory
+} MappedFile;
+
+// Returns 0 on success, 1 on failure (not logged; a missing file is often
+// expected)
+int map_file (const char* path, MappedFile* file);
+void unmap_file (MappedFile* file);
+
+// layout used by the create_*_mesh generators, standard or compact;
+// standard by default
+void set_mesh_vertex_layout (VertexLayout layout);
+VertexLayout get_mesh_vertex_layout (void);
+
+// Returns 0 on success, 1 on failure
+// vertices are interleaved pos3, normal3, uv2 floats; they are encoded in the
+// generator layout and uploaded, filling in the mesh's vertex buffer, vertex
+// count, layout and position dequantization
+int upload_mesh_vertices (
+    SDL_GPUDevice* device,
+    const float* vertices,
+    Uint32 num_vertices,
+    MeshComponent* mesh
+);
+
+// geometry built on the CPU and ready to upload, e.g. on a loader thread;
+// mesh is complete except for its buffers
+typedef struct {
+    MeshComponent mesh;
+    void* vertices; // encoded in mesh.layout
+    Uint64 vertices_size;
+    void* indices;
+    Uint64 indices_size;
+} MeshData;
+
+// Returns 0 on success, 1 on failure
+// encodes vertices (as for upload_mesh_vertices) without touching the GPU;
+// takes ownership of both malloc'd arrays, freeing them on failure
+int make_mesh_data (
+    float* vertices,
+    Uint32 num_vertices,
+    void* indices,
+    Uint32 num_indices,
+    SDL_GPUIndexElementSize index_size,
+    MeshData* out
+);
+void free_mesh_data (MeshData* data);
+
+// Returns 0 on success, 1 on failure
+// the data stays owned by the caller
+int upload_mesh_data (
+    SDL_GPUDevice* device,
+    const MeshData* data,
+    MeshComponent* out
+);
+
+// levels[0] with the rest as its coarser LODs; levels that fail to upload
+// end the chain early, and a failed first level gives an empty mesh
+MeshComponent upload_mesh_levels (
+    SDL_GPUDevice* device,
+    const MeshData* levels,
+    Uint32 level_count
+);
+
 // Returns 0 on success, 1 on failure
+// places the data in the shared vertex heap, filling in the mesh's vertex
+// buffer and offset
 int upload_vertices (
     SDL_GPUDevice* device,
     const void* vertices,
     Uint64 vertices_size,
-    SDL_GPUBuffer** vbo_out
+    MeshComponent* mesh
 );
 
 // Returns 0 on success, 1 on failure
+// as upload_vertices(), for the index buffer and offset
 int upload_indices (
     SDL_GPUDevice* device,
     const void* indices,
     Uint64 indices_size,
-    SDL_GPUBuffer** ibo_out
+    MeshComponent* mesh
 );
 
+// hands the mesh's ranges back to the heaps; its lods are left alone
+void release_mesh_buffers (SDL_GPUDevice* device, MeshComponent* mesh);
+
+// Returns 0 on success, 1 on failure
+// copies mesh into out so both draw from the same buffers and lods, which
+// release_mesh() frees with the last copy. Main thread only
+int share_mesh (MeshComponent* mesh, MeshComponent* out);
+
+// releases the buffers and lods unless another copy still shares them
+void release_mesh (SDL_GPUDevice* device, MeshComponent* mesh);
+
+// bytes per vertex in layout's first stream
+Uint32 vertex_stride (VertexLayout layout);
+
+// Returns 0 on success, 1 on failure
+// appends lod as the next coarser level of mesh, taking ownership of its
+// buffers (released on failure)
+int add_mesh_lod (
+    SDL_GPUDevice* device,
+    MeshComponent* mesh,
+    MeshComponent lod
+);
+
+// 16-bit indices while every vertex is addressable, 32-bit beyond that
+SDL_GPUIndexElementSize choose_index_size (Uint32 num_vertices);
+Uint32 index_size_bytes (SDL_GPUIndexElementSize index_size);
+
+// Returns NULL on failure
+void* alloc_indices (Uint32 num_indices, SDL_GPUIndexElementSize index_size);
+
+static inline void set_index (
+    void* indices,
+    SDL_GPUIndexElementSize index_size,
+    Uint32 i,
+    Uint32 value
+) {
+    if (index_size == SDL_GPU_INDEXELEMENTSIZE_32BIT)
+        ((Uint32*) indices)[i] = value;
+    else
+        ((Uint16*) indices)[i] = (Uint16) value;
+}
+
+static inline Uint32 get_index (
+    const void* indices,
+    SDL_GPUIndexElementSize index_size,
+    Uint32 i
+) {
+    if (index_size == SDL_GPU_INDEXELEMENTSIZE_32BIT)
+        return ((const Uint32*) indices)[i];
+    return ((const Uint16*) indices)[i];
+}
+
+typedef enum {
+    NORMAL_WEIGHT_FACE,  // every adjacent face counts equally
+    NORMAL_WEIGHT_ANGLE, // faces weighted by their angle at the vertex
+} NormalWeighting;
+
+// runs on the job system when it is initialized
 void compute_vertex_normals (
     float* vertices,
     int num_vertices,
-    const Uint16* indices,
+    const void* indices,
+    SDL_GPUIndexElementSize index_size,
     int num_indices,
     int stride,
     int pos_offset,
-    int norm_offset
-);
\ No newline at end of file
+    int norm_offset,
+    NormalWeighting weighting
+);
+
+#define VERTEX_CACHE_SIZE 16 // post-transform cache entries assumed by ACMR
+
+// average cache miss ratio: transformed vertices per triangle with a FIFO
+// cache of VERTEX_CACHE_SIZE entries; 0.5 is ideal, 3.0 is no reuse
+float compute_acmr (
+    const void* indices,
+    SDL_GPUIndexElementSize index_size,
+    Uint32 num_indices,
+    Uint32 num_vertices
+);
+
+// Returns 0 on success, 1 on failure (buffers are left untouched)
+// reorders triangles for the post-transform vertex cache (Tipsify), then
+// renumbers vertices in first-use order for fetch locality; vertices are
+// interleaved floats of the given stride
+int optimize_mesh (
+    float* vertices,
+    Uint32 num_vertices,
+    int stride,
+    void* indices,
+    SDL_GPUIndexElementSize index_size,
+    Uint32 num_indices
+);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include <ecs/ecs.h>
+
+// Binary glTF 2.0 (.glb) loading. Triangle primitives with indices whose
+// position, normal and uv accessors are tightly packed floats are uploaded
+// straight from the mapped BIN chunk as VERTEX_LAYOUT_SEPARATE meshes, all
+// through one transfer buffer. Anything else (interleaved views, normalized
+// or missing attributes, 8-bit or no indices) is decoded into the generator
+// layout instead. Only the BIN chunk is read; external buffers, sparse
+// accessors and non-triangle primitives are skipped with a log.
+//
+// Node transforms are flattened into world space and mirrored along z into
+// the engine's left-handed axes, which also turns glTF's counter-clockwise
+// front faces clockwise without touching the index data.
+
+typedef struct {
+    MeshComponent mesh;
+    TransformComponent transform; // world space
+} GltfPrimitive;
+
+typedef struct {
+    GltfPrimitive* primitives; // one per primitive of every mesh node
+    Uint32 primitive_count;
+} GltfModel;
+
+// Returns 0 on success, 1 on failure
+// a mesh used by several nodes is uploaded once; the other nodes' primitives
+// are share_mesh() copies, so each can still be handed to add_mesh() and the
+// buffers go with the last of them
+int load_glb (SDL_GPUDevice* device, const char* path, GltfModel* out);
+
+// frees the primitive array only; the buffers belong to the meshes
+void free_gltf_model (GltfModel* model);
@@ -1,8 +1,20 @@
 #pragma once
 
 #include <ecs/ecs.h>
+#include <geometry/g_common.h>
 #include <math/matrix.h>
 
+// Returns 0 on success, 1 on failure
+// generates the mesh on the CPU only; safe to call off the main thread
+int build_lathe_mesh (
+    const vec2* path,
+    int path_length,
+    int segments,
+    float phi_start,
+    float phi_length,
+    MeshData* out
+);
+
 MeshComponent create_lathe_mesh (
     vec2* path,
     int path_length,
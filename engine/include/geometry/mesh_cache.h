@@ -0,0 +1,76 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <ecs/ecs.h>
+#include <geometry/g_common.h>
+
+// .amesh: a header, one entry per LOD level and the encoded vertex and index
+// blobs exactly as they go to the GPU, every section 16-byte aligned. Files
+// are mapped into memory and the blob region is copied into one transfer
+// buffer without being parsed. All fields are little-endian.
+
+#define AMESH_MAGIC 0x48534d41u // "AMSH"
+#define AMESH_VERSION 1
+#define AMESH_MAX_ATTRIBUTES 4
+#define AMESH_ALIGN 16
+
+typedef struct {
+    Uint32 format; // SDL_GPUVertexElementFormat
+    Uint32 offset;
+} AMeshAttribute;
+
+typedef struct {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 layout; // VertexLayout
+    Uint32 vertex_stride;
+    Uint32 attribute_count;
+    Uint32 level_count;
+    Uint32 reserved[2];
+    AMeshAttribute attributes[AMESH_MAX_ATTRIBUTES];
+    float bounds_min[3];
+    float radius;
+    float bounds_max[3];
+    Uint32 padding;
+} AMeshHeader;
+
+typedef struct {
+    Uint64 vertex_offset; // from the start of the file
+    Uint64 vertex_size;
+    Uint64 index_offset;
+    Uint64 index_size;
+    Uint32 num_vertices;
+    Uint32 num_indices;
+    Uint32 index_size_bits; // 16 or 32
+    Uint32 padding;
+    float pos_scale[4];
+    float pos_offset[4];
+} AMeshLevel;
+
+// "<dir>/<name>_<hash>.amesh" where the hash covers params, the generator
+// vertex layout and the format version; zero any padding in params
+void mesh_cache_path (
+    char* out,
+    size_t out_size,
+    const char* dir,
+    const char* name,
+    const void* params,
+    size_t params_size
+);
+
+// Returns 0 on success, 1 on failure (missing or stale files fail quietly)
+int load_mesh_cache (
+    SDL_GPUDevice* device,
+    const char* path,
+    MeshComponent* out
+);
+
+// Returns 0 on success, 1 on failure
+// writes a mesh as built on the CPU: levels[0] is the full mesh and the rest
+// its coarser LODs in order, all in the same interleaved layout
+int write_mesh_cache (
+    const char* path,
+    const MeshData* levels,
+    Uint32 level_count
+);
@@ -1,6 +1,20 @@
 #pragma once
 
 #include <ecs/ecs.h>
+#include <geometry/g_common.h>
+
+// Returns 0 on success, 1 on failure
+// generates the mesh on the CPU only; safe to call off the main thread
+int build_sphere_mesh (
+    float radius,
+    int width_segments,
+    int height_segments,
+    float phi_start,
+    float phi_length,
+    float theta_start,
+    float theta_length,
+    MeshData* out
+);
 
 MeshComponent create_sphere_mesh (
     float radius,
@@ -11,4 +25,18 @@ MeshComponent create_sphere_mesh (
     float theta_start,
     float theta_length,
     SDL_GPUDevice* device
+);
+
+// create_sphere_mesh plus up to lod_count coarser levels, halving both
+// segment counts per level
+MeshComponent create_sphere_mesh_lods (
+    float radius,
+    int width_segments,
+    int height_segments,
+    float phi_start,
+    float phi_length,
+    float theta_start,
+    float theta_length,
+    int lod_count,
+    SDL_GPUDevice* device
 );
\ No newline at end of file
@@ -1,6 +1,31 @@
 #pragma once
 
 #include <ecs/ecs.h>
+#include <geometry/g_common.h>
+
+// Returns 0 on success, 1 on failure
+// generates the mesh on the CPU only; safe to call off the main thread
+int build_torus_mesh (
+    float radius,
+    float tube_radius,
+    int radial_segments,
+    int tubular_segments,
+    float arc,
+    MeshData* out
+);
+
+// Returns the number of levels built, 0 on failure
+// build_torus_mesh plus up to lod_count coarser levels, halving both segment
+// counts per level; levels must hold lod_count + 1
+Uint32 build_torus_mesh_lods (
+    float radius,
+    float tube_radius,
+    int radial_segments,
+    int tubular_segments,
+    float arc,
+    int lod_count,
+    MeshData* levels
+);
 
 MeshComponent create_torus_mesh (
     float radius,
@@ -9,4 +34,16 @@ MeshComponent create_torus_mesh (
     int tubular_segments,
     float arc,
     SDL_GPUDevice* device
+);
+
+// create_torus_mesh plus up to lod_count coarser levels, halving both
+// segment counts per level
+MeshComponent create_torus_mesh_lods (
+    float radius,
+    float tube_radius,
+    int radial_segments,
+    int tubular_segments,
+    float arc,
+    int lod_count,
+    SDL_GPUDevice* device
 );
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+// Suballocates mesh geometry out of a few large GPU buffers so meshes share
+// bindings and creating one costs no driver allocation. Each heap block is a
+// buddy allocator: ranges are rounded up to a power of two no smaller than
+// BUFFER_HEAP_MIN_ALLOC and start at a multiple of their size, so an offset
+// divided by a vertex stride or index size is a whole base vertex or first
+// index. A block is released once its last range is freed. Main thread only.
+
+typedef enum {
+    BUFFER_HEAP_VERTEX,
+    BUFFER_HEAP_INDEX,
+    BUFFER_HEAP_COUNT,
+} BufferHeapKind;
+
+#define BUFFER_HEAP_MIN_ALLOC 256u
+#define BUFFER_HEAP_MAX_ORDER 16 // blocks of BUFFER_HEAP_MIN_ALLOC << 16
+#define BUFFER_HEAP_BLOCK_SIZE (BUFFER_HEAP_MIN_ALLOC << BUFFER_HEAP_MAX_ORDER)
+
+// Returns 0 on success, 1 on failure
+// size bytes at offset in buffer; ranges larger than a block get a buffer of
+// their own
+int buffer_heap_alloc (
+    SDL_GPUDevice* device,
+    BufferHeapKind kind,
+    Uint32 size,
+    SDL_GPUBuffer** buffer,
+    Uint32* offset
+);
+
+// buffer and offset as returned by buffer_heap_alloc()
+void buffer_heap_free (
+    SDL_GPUDevice* device,
+    BufferHeapKind kind,
+    SDL_GPUBuffer* buffer,
+    Uint32 offset
+);
+
+// GPU buffers currently backing the heap, for statistics
+Uint32 buffer_heap_block_count (BufferHeapKind kind);
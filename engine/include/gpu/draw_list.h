@@ -0,0 +1,108 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include <ecs/ecs.h>
+
+// The frame's mesh draws, submitted indirectly. Each draw's ObjectData goes
+// into an instance buffer and its arguments into an indirect buffer, both
+// rewritten every frame through the staging ring, so the CPU side of a draw
+// is filling in two records. Runs of draws that share a pipeline, texture and
+// heap blocks are issued with a single SDL_DrawGPUIndexedPrimitivesIndirect().
+//
+// Culling runs on the GPU: a compute pass tests every draw's bounding sphere
+// against the frustum and the last frame's depth pyramid (gpu/hiz.h), and
+// zeroes the instance count of those outside or hidden, so culled draws stay
+// in their batch but cost the GPU next to nothing. Meshes without an index
+// buffer are drawn directly rather than from the indirect buffer, so they are
+// never culled.
+//
+// draw_list_sort() radix sorts the list into two queues: opaque draws front
+// to back, so near surfaces reject what lies behind them before it is shaded,
+// then blended draws back to front, so they composite correctly.
+//
+// The per-draw CPU work (sort keys, gathering the records, finding batches)
+// fans out over the job pool (jobs/jobs.h): drawing splits the list into
+// chunks whose batches are found in parallel, then replays them into the
+// render pass in order.
+//
+// There are two lists: draw_list_reset(), the adding calls and
+// draw_list_sort() fill one, the rest upload and draw the other, and
+// draw_list_swap() hands the filled list over. So the next frame's list can
+// be built on one other thread while the main thread draws this one, with
+// draw_list_set() spreading the filling over jobs; everything else is main
+// thread only.
+
+typedef enum {
+    DRAW_QUEUE_OPAQUE,
+    DRAW_QUEUE_BLENDED, // after every opaque draw; never in the pre-pass
+} DrawQueue;
+
+// Returns 0 on success, 1 on failure
+// without shaders/draw_cull.comp.spv draws are never culled
+int draw_list_init (SDL_GPUDevice* device);
+void draw_list_shutdown (void);
+
+// empties the list being built for a new frame
+void draw_list_reset (void);
+
+// Returns 0 on success, 1 on failure
+// mesh is the level to draw and is copied, but its buffers, like pipeline
+// and texture, must live until the list is drawn; depth_pipeline draws it in
+// the depth pre-pass, NULL leaves it out
+int draw_list_add (
+    SDL_GPUGraphicsPipeline* pipeline,
+    SDL_GPUGraphicsPipeline* depth_pipeline,
+    SDL_GPUTexture* texture,
+    const MeshComponent* mesh,
+    const ObjectData* object,
+    DrawQueue queue
+);
+
+// Returns 0 on success, 1 on failure
+// makes room for count draws past those added so far, which draw_list_set()
+// may then fill from any thread; until draw_list_keep() takes them they are
+// not in the list, and another reserve or add drops them
+int draw_list_reserve (Uint32 count);
+
+// fills reserved slot, 0 being the first, as draw_list_add() would
+void draw_list_set (
+    Uint32 slot,
+    SDL_GPUGraphicsPipeline* pipeline,
+    SDL_GPUGraphicsPipeline* depth_pipeline,
+    SDL_GPUTexture* texture,
+    const MeshComponent* mesh,
+    const ObjectData* object,
+    DrawQueue queue
+);
+
+// appends reserved slots [slot, slot + count) to the list; calls must go in
+// increasing slot order without overlapping, and skipped slots are dropped
+void draw_list_keep (Uint32 slot, Uint32 count);
+
+// orders the draws added so far by their depth under view; opaque draws at
+// about the same depth are grouped by state so they still batch
+void draw_list_sort (mat4 view);
+
+// makes the list just built the one drawn; the one drawn before is built
+// over next
+void draw_list_swap (void);
+
+// Returns 0 on success, 1 on failure
+// stages the records in sorted order; call before staging_ring_flush()
+int draw_list_upload (void);
+
+// records the culling pass on cmd, which must not be in a pass; after
+// staging_ring_flush() has recorded the upload
+void draw_list_cull (SDL_GPUCommandBuffer* cmd, mat4 view_proj);
+
+// records the depth pre-pass in pass, ahead of draw_list_draw()
+void draw_list_draw_depth (SDL_GPURenderPass* pass);
+
+// records the draws in pass, sampling each batch's texture with sampler
+void draw_list_draw (SDL_GPURenderPass* pass, SDL_GPUSampler* sampler);
+
+// draws and indirect draw calls recorded by the last draw_list_draw()
+Uint32 draw_list_count (void);
+Uint32 draw_list_batch_count (void);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include <math/matrix.h>
+
+// Hierarchical-Z pyramid of the last frame's depth: every level holds the
+// farthest depth under each of its texels, halving down to 1x1. The draw
+// list's culling pass tests each draw's bounds, projected with the camera the
+// depth was drawn from, against the level where they span a couple of texels,
+// and drops draws lying wholly behind it. Built right after the mesh pass, so
+// anything that comes into view from behind an occluder shows up one frame
+// late.
+//
+// A compute pass cannot read the texture it writes, so even levels live in
+// one texture and odd levels in another, each at its own mip. Owned by the
+// draw list, which initializes it. Main thread only.
+
+typedef struct {
+    SDL_GPUTextureSamplerBinding levels[2]; // even and odd levels
+    Uint32 width; // of level 0
+    Uint32 height;
+    Uint32 level_count; // 0 until a pyramid has been built
+    mat4 view_proj; // the camera the depth was drawn from
+} HizPyramid;
+
+// Returns 0 on success, 1 on failure
+// without shaders/hiz_reduce.comp.spv the pyramid is never built
+int hiz_init (SDL_GPUDevice* device);
+void hiz_shutdown (void);
+
+// Returns 0 on success, 1 on failure
+// records the reduction of depth, width x height and drawn from view_proj,
+// on cmd, which must not be in a pass; depth needs the sampler usage
+int hiz_build (
+    SDL_GPUCommandBuffer* cmd,
+    SDL_GPUTexture* depth,
+    Uint32 width,
+    Uint32 height,
+    mat4 view_proj
+);
+
+// NULL before hiz_init()
+const HizPyramid* hiz_pyramid (void);
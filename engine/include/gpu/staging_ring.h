@@ -0,0 +1,41 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+// Upload space for data that changes every frame. Each of the last
+// STAGING_RING_FRAMES frames owns a set of persistent transfer buffers that
+// are bump allocated from, so a buffer is only written again once the GPU
+// has long finished with it. Buffers are mapped with cycling on, which keeps
+// even a frame that comes round early from overwriting one still in flight.
+// A frame that outgrows its space gets another buffer, kept from then on, so
+// steady-state frames create none.
+//
+// Uploads are queued with their destination and recorded in one copy pass
+// by staging_ring_flush(). Main thread only.
+
+#define STAGING_RING_FRAMES 3
+#define STAGING_CHUNK_SIZE (4u * 1024u * 1024u)
+
+// Returns 0 on success, 1 on failure
+int staging_ring_init (SDL_GPUDevice* device);
+void staging_ring_shutdown (void);
+
+// Returns NULL on failure
+// size bytes to fill before the next flush, which copies them to offset in
+// buffer; cycle is passed on to SDL_UploadToGPUBuffer()
+void* staging_upload_buffer (
+    SDL_GPUBuffer* buffer,
+    Uint32 offset,
+    Uint32 size,
+    bool cycle
+);
+
+// Returns NULL on failure
+// size bytes of tightly packed rows (or blocks) for region
+void* staging_upload_texture (const SDL_GPUTextureRegion* region, Uint32 size);
+
+// Returns 0 on success, 1 on failure
+// records this frame's uploads on cmd, which must not be in a pass, and
+// moves on to the next frame's buffers
+int staging_ring_flush (SDL_GPUCommandBuffer* cmd);
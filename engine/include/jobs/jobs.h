@@ -0,0 +1,28 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Fork-join worker pool for data-parallel loops. The calling thread works
+// alongside the workers and jobs_parallel_for() returns once every batch is
+// done. Loops submitted from different threads at once share the workers,
+// up to four in flight. Without jobs_init(), or when called from inside
+// another job, loops simply run on the calling thread.
+
+#define JOBS_MAX_WORKERS 32
+
+// processes items [start, end)
+typedef void (*JobFunc) (void* data, Uint32 start, Uint32 end);
+
+// Returns 0 on success, 1 on failure
+// num_workers of 0 uses one worker per logical core beyond the caller's
+int jobs_init (Uint32 num_workers);
+void jobs_shutdown (void);
+Uint32 jobs_worker_count (void);
+
+// splits [0, count) into batches of at least min_batch items
+void jobs_parallel_for (
+    Uint32 count,
+    Uint32 min_batch,
+    JobFunc func,
+    void* data
+);
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+// Block-compression encoders for 4x4 RGBA8 texel blocks, row-major. They aim
+// for reasonable quality at offline-tool speed: endpoints come from the
+// block's principal axis and are refined once by least squares.
+
+#define BC_BLOCK_TEXELS 16
+
+// 8 bytes, opaque four-colour mode; alpha is ignored
+void encode_bc1_block (const Uint8 rgba[BC_BLOCK_TEXELS * 4], Uint8 out[8]);
+
+// 16 bytes: interpolated alpha followed by a four-colour BC1 block
+void encode_bc3_block (const Uint8 rgba[BC_BLOCK_TEXELS * 4], Uint8 out[16]);
+
+// 16 bytes, mode 6 only: one RGBA subset with 4-bit indices
+void encode_bc7_block (const Uint8 rgba[BC_BLOCK_TEXELS * 4], Uint8 out[16]);
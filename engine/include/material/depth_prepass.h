@@ -0,0 +1,23 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include <ecs/ecs.h>
+
+// Position-only pipelines for the depth pre-pass, shared by every material
+// since the pass needs nothing but where surfaces are. With
+// gpu_renderer.depth_prepass set, render_system draws depth with these
+// first, then shades with the materials' equal_* pipelines, so each pixel
+// runs the fragment shader once however many surfaces cover it. Main thread
+// only.
+
+// Returns 0 on success, 1 on failure
+// pipelines draw into renderer->format color targets; a missing layout's
+// shader only leaves those meshes out of the pre-pass
+int depth_prepass_init (gpu_renderer* renderer);
+void depth_prepass_shutdown (void);
+
+// NULL if the pre-pass cannot draw meshes of this layout and side
+SDL_GPUGraphicsPipeline*
+depth_prepass_pipeline (VertexLayout layout, MaterialSide side);
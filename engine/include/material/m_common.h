@@ -14,7 +14,38 @@ SDL_GPUShader* load_shader (
     Uint32 storage_texture_count
 );
 
+// Returns NULL on failure
+// info gives the resource counts and thread group size; the code, format and
+// entrypoint come from filename as for load_shader()
+SDL_GPUComputePipeline* load_compute_pipeline (
+    SDL_GPUDevice* device,
+    const char* filename,
+    SDL_GPUComputePipelineCreateInfo info
+);
+
+#define TEXTURE_MAX_LOD 1000.0f // no clamp on the mip chain
+#define TEXTURE_ANISOTROPY 8.0f
+
+// levels in a full mip chain down to 1x1
+Uint32 mip_level_count (Uint32 width, Uint32 height);
+// usage for a sampled texture whose levels SDL_GenerateMipmapsForGPUTexture()
+// fills in
+SDL_GPUTextureUsageFlags mip_texture_usage (Uint32 num_levels);
+
+// Returns NULL on failure
+// max_anisotropy of 1 or less disables anisotropic filtering
+SDL_GPUSampler*
+create_texture_sampler (SDL_GPUDevice* device, float max_anisotropy);
+
+// loads with a full mip chain generated on the GPU; .atex files from texconv
+// are uploaded as stored instead
 SDL_GPUTexture* load_texture (SDL_GPUDevice* device, const char* bmp_file_path);
+// also reports how the texture was created when info is not NULL
+SDL_GPUTexture* load_texture_with_info (
+    SDL_GPUDevice* device,
+    const char* bmp_file_path,
+    SDL_GPUTextureCreateInfo* info
+);
 
 int set_vertex_shader (
     gpu_renderer* renderer,
@@ -22,6 +53,13 @@ int set_vertex_shader (
     const char* filepath
 );
 
+// vertex shader for VERTEX_LAYOUT_COMPACT meshes drawn with this material
+int set_compact_vertex_shader (
+    gpu_renderer* renderer,
+    MaterialComponent* mat,
+    const char* filepath
+);
+
 int set_fragment_shader (
     gpu_renderer* renderer,
     MaterialComponent* mat,
@@ -30,10 +68,52 @@ int set_fragment_shader (
     Uint32 uniform_buffer_count
 );
 
-SDL_GPUTexture* create_white_texture (SDL_GPUDevice* device);
+typedef enum {
+    MESH_DEPTH_LESS,  // test and write depth, as without a pre-pass
+    MESH_DEPTH_ONLY,  // the depth pre-pass: write depth, leave color alone
+    MESH_DEPTH_EQUAL, // after the pre-pass: shade only the visible surface
+    MESH_DEPTH_BLENDED, // alpha blend over what is drawn, testing depth only
+} MeshDepthMode;
+
+// the cull mode drawing side of a surface
+SDL_GPUCullMode side_cull_mode (MaterialSide side);
 
-static int build_pipeline (
+// Returns NULL on failure
+// draws layout meshes with per-draw ObjectData into a target_format color
+// target over the D24 depth buffer
+SDL_GPUGraphicsPipeline* create_mesh_pipeline (
     SDL_GPUDevice* device,
+    SDL_GPUShader* vertex_shader,
+    SDL_GPUShader* fragment_shader,
+    SDL_GPUTextureFormat target_format,
+    VertexLayout layout,
+    SDL_GPUCullMode cull_mode,
+    MeshDepthMode depth_mode
+);
+
+// Returns 0 on success, 1 on failure
+// rebuilds mat's pipelines to alpha blend, taking alpha from its texture, and
+// draw after every opaque material; blended materials skip the depth pre-pass
+int set_material_blended (
+    gpu_renderer* renderer,
     MaterialComponent* mat,
-    SDL_GPUTextureFormat swapchain_format
-);
\ No newline at end of file
+    bool blended
+);
+
+// Returns 0 on success, 1 on failure
+// out draws like mat in another color, taking its own references on mat's
+// cached shaders and pipelines, so every copy batches with the others.
+// Textured materials own their layer and cannot be shared
+int share_material (
+    const MaterialComponent* mat,
+    vec3 color,
+    MaterialComponent* out
+);
+
+// gives back mat's texture layer and its pipeline cache references
+void release_material (SDL_GPUDevice* device, MaterialComponent* mat);
+
+SDL_GPUTexture* create_white_texture (SDL_GPUDevice* device);
+// single layer 2D array for gpu_renderer.white_texture; material shaders
+// sample arrays
+SDL_GPUTexture* create_white_texture_array (SDL_GPUDevice* device);
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include <ecs/ecs.h>
+#include <material/m_common.h>
+
+// Shaders and mesh pipelines shared by every material asking for the same
+// ones. Materials that differ only by color or texture layer then bind the
+// same pipeline, which is what lets the draw list batch their draws. Each
+// entry is reference counted: every get or retain takes a reference, given
+// back with the matching release, and the last one releases the GPU object.
+// A cached pipeline also holds a reference on its shaders, so their pointers
+// stay unique keys. Main thread only.
+
+// Returns NULL on failure
+// as load_shader(), one shader per file, stage and resource counts
+SDL_GPUShader* pipeline_cache_shader (
+    SDL_GPUDevice* device,
+    const char* filename,
+    SDL_GPUShaderStage stage,
+    Uint32 sampler_count,
+    Uint32 uniform_buffer_count,
+    Uint32 storage_buffer_count,
+    Uint32 storage_texture_count
+);
+void pipeline_cache_retain_shader (SDL_GPUShader* shader);
+void pipeline_cache_release_shader (
+    SDL_GPUDevice* device,
+    SDL_GPUShader* shader
+);
+
+// Returns NULL on failure
+// as create_mesh_pipeline(), one pipeline per set of arguments
+SDL_GPUGraphicsPipeline* pipeline_cache_pipeline (
+    SDL_GPUDevice* device,
+    SDL_GPUShader* vertex_shader,
+    SDL_GPUShader* fragment_shader,
+    SDL_GPUTextureFormat target_format,
+    VertexLayout layout,
+    SDL_GPUCullMode cull_mode,
+    MeshDepthMode depth_mode
+);
+void pipeline_cache_retain_pipeline (SDL_GPUGraphicsPipeline* pipeline);
+void pipeline_cache_release_pipeline (
+    SDL_GPUDevice* device,
+    SDL_GPUGraphicsPipeline* pipeline
+);
+
+// distinct pipelines currently cached, for statistics
+Uint32 pipeline_cache_pipeline_count (void);
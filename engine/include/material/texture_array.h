@@ -0,0 +1,53 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include <ecs/ecs.h>
+
+// Material textures live in layers of shared 2D array textures, one set of
+// arrays per size, format and level count. Materials hold an array and a
+// layer; the layer goes to the shaders in the per-draw uniforms, so draws
+// that differ only by texture keep the same sampler binding.
+
+// arrays start this small and double as layers are added
+#define TEXTURE_ARRAY_MIN_LAYERS 4
+// a full array is left alone and another one is started
+#define TEXTURE_ARRAY_MAX_LAYERS 256
+
+struct TextureArray {
+    SDL_GPUTexture* texture; // SDL_GPU_TEXTURETYPE_2D_ARRAY
+    SDL_GPUTextureFormat format;
+    Uint32 width;
+    Uint32 height;
+    Uint32 num_levels;
+    Uint32 capacity; // layers in texture
+    Uint32 live;     // layers in use
+    bool* used;      // one per layer
+};
+
+// Returns 0 on success, 1 on failure
+// copies every level of texture (described by info) into a free layer and
+// points the material at it, releasing the material's previous layer; takes
+// ownership of texture even on failure
+int add_texture_layer (
+    SDL_GPUDevice* device,
+    SDL_GPUTexture* texture,
+    const SDL_GPUTextureCreateInfo* info,
+    MaterialComponent* mat
+);
+
+// frees the layer; the array is released with its last layer
+void remove_texture_layer (
+    SDL_GPUDevice* device,
+    TextureArray* array,
+    Uint32 layer
+);
+
+// Returns 0 on success, 1 on failure
+// load_texture() followed by add_texture_layer()
+int load_material_texture (
+    SDL_GPUDevice* device,
+    MaterialComponent* mat,
+    const char* path
+);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include <geometry/g_common.h>
+
+// .atex: a header, one entry per mip level and the level data exactly as it
+// goes to the GPU (4x4 blocks for the BC formats), every section 16-byte
+// aligned. Written offline by texconv; load_texture() recognizes the magic
+// and uploads the levels without decoding them. All fields are little-endian.
+
+#define ATEX_MAGIC 0x58455441u // "ATEX"
+#define ATEX_VERSION 1
+#define ATEX_MAX_LEVELS 16
+#define ATEX_ALIGN 16
+
+typedef enum {
+    TEXTURE_FILE_RGBA8,
+    TEXTURE_FILE_BC1, // opaque
+    TEXTURE_FILE_BC3, // interpolated alpha
+    TEXTURE_FILE_BC7,
+    TEXTURE_FILE_FORMAT_COUNT,
+} TextureFileFormat;
+
+typedef struct {
+    Uint32 magic;
+    Uint32 version;
+    Uint32 format; // TextureFileFormat
+    Uint32 width;
+    Uint32 height;
+    Uint32 level_count;
+    Uint32 reserved[2];
+} ATexHeader;
+
+typedef struct {
+    Uint64 offset; // from the start of the file
+    Uint64 size;
+} ATexLevel;
+
+// bytes in one level of the given size
+Uint64 texture_level_size (
+    TextureFileFormat format,
+    Uint32 width,
+    Uint32 height
+);
+
+bool is_texture_file (const MappedFile* file);
+// reads only the magic, so other image files are not mapped just to check
+bool is_texture_file_path (const char* path);
+
+// Returns NULL on failure
+// logs and fails when the device cannot sample the file's format; info
+// receives the texture's create info when not NULL
+SDL_GPUTexture* upload_texture_file (
+    SDL_GPUDevice* device,
+    const MappedFile* file,
+    const char* name,
+    SDL_GPUTextureCreateInfo* info
+);
+
+// Returns 0 on success, 1 on failure
+// rgba is width * height ABGR8888 texels; the mip chain is box filtered down
+// to 1x1 unless mips is false, and blocks are encoded on the job system
+int write_texture_file (
+    const char* path,
+    TextureFileFormat format,
+    const Uint8* rgba,
+    Uint32 width,
+    Uint32 height,
+    bool mips
+);
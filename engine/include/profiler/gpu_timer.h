@@ -0,0 +1,38 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+// SDL_gpu does not expose timestamp queries on any backend, so GPU time is
+// measured from fences instead: every timed command buffer is submitted with
+// a fence, and a watcher thread stamps the moment each fence signals. A pass
+// is charged from max(its submit, the previous completion) to its own
+// completion, which is its GPU busy time as long as submissions are serial.
+// Results are reported to the profiler as zones on a "GPU" thread.
+
+#define GPU_TIMER_QUEUE_SIZE 16 // command buffers in flight, power of two
+
+#ifdef PROFILER_ENABLED
+
+// Returns 0 on success, 1 on failure
+int gpu_timer_init (SDL_GPUDevice* device);
+void gpu_timer_shutdown (void);
+
+// drop-in for SDL_SubmitGPUCommandBuffer; name must outlive the frame
+bool gpu_timer_submit (SDL_GPUCommandBuffer* cmd, const char* name);
+
+#else
+
+static inline int gpu_timer_init (SDL_GPUDevice* device) {
+    (void) device;
+    return 0;
+}
+static inline void gpu_timer_shutdown (void) {
+}
+static inline bool
+gpu_timer_submit (SDL_GPUCommandBuffer* cmd, const char* name) {
+    (void) name;
+    return SDL_SubmitGPUCommandBuffer (cmd);
+}
+
+#endif
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <microui.h>
+
+// Zones are recorded into a per-thread ring buffer and folded into a rolling
+// window of per-frame totals by profiler_frame_end(). Build with
+// ENABLE_PROFILER=OFF to compile every macro below down to nothing.
+
+#define PROFILER_MAX_THREADS 16
+#define PROFILER_MAX_ZONES 256
+#define PROFILER_MAX_DEPTH 32
+#define PROFILER_RING_SIZE 8192 // events per thread, power of two
+#define PROFILER_HISTORY 120    // frames in the rolling window
+#define PROFILER_TRACE_EVENTS 65536 // raw events kept for export, power of two
+#define PROFILER_TRACE_FRAMES 8     // frames written per trace dump
+
+typedef struct {
+    const char* name;
+    const char* parent; // NULL for root zones
+    Uint32 depth;
+    Uint32 thread;
+    Uint32 calls;  // calls during the last frame the zone ran
+    Uint32 frames; // frames in the window
+    float last_ms; // total time during the last frame the zone ran
+    float min_ms;
+    float avg_ms;
+    float max_ms;
+    float p99_ms;
+} ProfilerZoneStats;
+
+#ifdef PROFILER_ENABLED
+
+void profiler_init (void);
+void profiler_shutdown (void);
+
+// forget all zones and pending events, keeping registered threads
+void profiler_reset (void);
+
+// optional; threads are registered on their first zone otherwise
+void profiler_register_thread (const char* name);
+const char* profiler_thread_name (Uint32 thread);
+
+void profiler_begin_zone (const char* name);
+void profiler_end_zone (void);
+
+// records a zone timed elsewhere (e.g. on the GPU) as a child of the calling
+// thread's innermost open zone
+void profiler_record_zone (const char* name, Uint64 start_ns, Uint64 end_ns);
+
+// call once per frame from the main thread
+void profiler_frame_end (void);
+
+// stats are recomputed lazily; the pointer is valid until the next frame end
+Uint32 profiler_get_stats (const ProfilerZoneStats** out);
+
+// must be called between mu_begin() and mu_end()
+void profiler_draw_ui (mu_Context* ctx);
+
+// writes the last PROFILER_TRACE_FRAMES frames as Chrome Trace Event JSON,
+// loadable in Perfetto or chrome://tracing; events lost to full rings since
+// the last reset are counted in each thread's metadata and logged
+// Returns 0 on success, 1 on failure
+int profiler_dump_trace (const char* path);
+
+// dump automatically whenever a frame takes longer than threshold_ms, to
+// "<path_prefix>_<frame>.json"; a threshold of 0 disables it
+void profiler_set_trace_threshold (float threshold_ms, const char* path_prefix);
+
+static inline void profiler_scope_cleanup (int* scope) {
+    (void) scope;
+    profiler_end_zone ();
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER (a, b)
+
+// closes automatically at the end of the enclosing block (GNU C cleanup)
+#define PROFILE_ZONE(name)                                                     \
+    __attribute__ ((cleanup (profiler_scope_cleanup))) int PROFILE_CONCAT (    \
+        profile_zone_, __LINE__                                                \
+    ) = (profiler_begin_zone (name), 0)
+#define PROFILE_BEGIN(name) profiler_begin_zone (name)
+#define PROFILE_END() profiler_end_zone ()
+#define PROFILE_FRAME_END() profiler_frame_end ()
+
+#else
+
+static inline void profiler_init (void) {
+}
+static inline void profiler_shutdown (void) {
+}
+static inline void profiler_reset (void) {
+}
+static inline void profiler_register_thread (const char* name) {
+    (void) name;
+}
+static inline const char* profiler_thread_name (Uint32 thread) {
+    (void) thread;
+    return "";
+}
+static inline void profiler_begin_zone (const char* name) {
+    (void) name;
+}
+static inline void profiler_end_zone (void) {
+}
+static inline void
+profiler_record_zone (const char* name, Uint64 start_ns, Uint64 end_ns) {
+    (void) name;
+    (void) start_ns;
+    (void) end_ns;
+}
+static inline void profiler_frame_end (void) {
+}
+static inline Uint32 profiler_get_stats (const ProfilerZoneStats** out) {
+    *out = NULL;
+    return 0;
+}
+static inline void profiler_draw_ui (mu_Context* ctx) {
+    (void) ctx;
+}
+static inline int profiler_dump_trace (const char* path) {
+    (void) path;
+    return 1;
+}
+static inline void
+profiler_set_trace_threshold (float threshold_ms, const char* path_prefix) {
+    (void) threshold_ms;
+    (void) path_prefix;
+}
+
+#define PROFILE_ZONE(name) ((void) 0)
+#define PROFILE_BEGIN(name) ((void) 0)
+#define PROFILE_END() ((void) 0)
+#define PROFILE_FRAME_END() ((void) 0)
+
+#endif
@@ -2,11 +2,12 @@
 
 layout(location = 0) in vec3 fragColor;
 layout (location = 1) in vec2 TexCoord;
+layout (location = 2) flat in float Layer;
 
-layout (set = 2, binding = 0) uniform sampler2D texture1;
+layout (set = 2, binding = 0) uniform sampler2DArray texture1;
 
 layout (location = 0) out vec4 outColor;
 
 void main() {
-    outColor = texture(texture1, TexCoord) * vec4(fragColor, 1.0);
+    outColor = texture(texture1, vec3(TexCoord, Layer)) * vec4(fragColor, 1.0);
 } 
\ No newline at end of file
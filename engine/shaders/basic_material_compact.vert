@@ -0,0 +1,36 @@
+#version 450
+
+// VERTEX_LAYOUT_COMPACT input: snorm16 position relative to the mesh bounds,
+// snorm16 octahedral normal, half float texcoord
+layout (location = 0) in vec4 aPos;
+layout (location = 1) in vec2 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+// per-draw ObjectData, one record per instance
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in vec4 aColor; // rgb, w: texture array layer
+layout (location = 8) in vec4 aPosScale;
+layout (location = 9) in vec4 aPosOffset;
+
+layout (location = 0) out vec3 fragColor;
+layout (location = 1) out vec2 TexCoord;
+layout (location = 2) flat out float Layer;
+
+layout(std140, set = 1, binding = 0) uniform UBO {
+    mat4 view;
+    mat4 projection;
+    vec4 ambient_color[64];
+    vec4 pointLightPos[64];
+    vec4 pointLightColor[64];
+    vec4 viewPos;
+} ubo;
+
+// matches the depth pre-pass exactly
+invariant gl_Position;
+
+void main() {
+    vec3 pos = aPos.xyz * aPosScale.xyz + aPosOffset.xyz;
+    gl_Position = ubo.projection * ubo.view * aModel * vec4(pos, 1.0);
+    fragColor = aColor.rgb;
+    TexCoord = aTexCoord;
+    Layer = aColor.w;
+}
\ No newline at end of file
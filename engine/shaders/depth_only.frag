@@ -0,0 +1,6 @@
+#version 450
+
+// The depth pre-pass only writes depth; its pipelines mask off color.
+
+void main() {
+}
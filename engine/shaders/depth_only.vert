@@ -0,0 +1,20 @@
+#version 450
+
+// Position-only vertex shader for the depth pre-pass, for
+// VERTEX_LAYOUT_STANDARD and _SEPARATE meshes. gl_Position must come out
+// bit-identical to the material shaders' so their EQUAL depth test passes.
+
+layout(location = 0) in vec3 aPos;
+// per-draw ObjectData, one record per instance
+layout(location = 3) in mat4 aModel;
+
+layout(std140, set = 1, binding = 0) uniform UBO {
+    mat4 view;
+    mat4 projection;
+} ubo;
+
+invariant gl_Position;
+
+void main() {
+    gl_Position = ubo.projection * ubo.view * aModel * vec4(aPos, 1.0);
+}
@@ -4,14 +4,13 @@ layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 TexCoord;
 layout(location = 2) in vec3 Normal;
 layout(location = 3) in vec3 FragPos;
+layout(location = 4) flat in float Layer;
 
-layout(set = 2, binding = 0) uniform sampler2D texture1;
+layout(set = 2, binding = 0) uniform sampler2DArray texture1;
 
 layout(location = 0) out vec4 outColor;
 
 layout(std140, set = 3, binding = 0) uniform UBO {
-    vec4 color;
-    mat4 model;
     mat4 view;
     mat4 projection;
     vec4 ambient_color[64];
@@ -21,7 +20,7 @@ layout(std140, set = 3, binding = 0) uniform UBO {
 } ubo;
 
 void main() {
-    vec4 texColor = texture(texture1, TexCoord);
+    vec4 texColor = texture(texture1, vec3(TexCoord, Layer));
     vec3 objectColor = texColor.rgb * fragColor;
     vec3 view_xyz = vec3(ubo.viewPos.x, ubo.viewPos.y, ubo.viewPos.z);
     vec3 norm = normalize(Normal);
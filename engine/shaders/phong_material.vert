@@ -3,15 +3,19 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec2 aTexCoord;
+// per-draw ObjectData, one record per instance
+layout(location = 3) in mat4 aModel;
+layout(location = 7) in vec4 aColor; // rgb, w: texture array layer
+layout(location = 8) in vec4 aPosScale;
+layout(location = 9) in vec4 aPosOffset;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 TexCoord;
 layout(location = 2) out vec3 Normal;  // Pass transformed normal
 layout(location = 3) out vec3 FragPos;  // Pass world-space position for light calc
+layout(location = 4) flat out float Layer;
 
 layout(std140, set = 1, binding = 0) uniform UBO {
-    vec4 color;
-    mat4 model;
     mat4 view;
     mat4 projection;
     vec4 ambient_color[64];
@@ -20,10 +24,14 @@ layout(std140, set = 1, binding = 0) uniform UBO {
     vec4 viewPos;
 } ubo;
 
+// matches the depth pre-pass exactly
+invariant gl_Position;
+
 void main() {
-    gl_Position = ubo.projection * ubo.view * ubo.model * vec4(aPos, 1.0);
-    fragColor = ubo.color.rgb;
+    gl_Position = ubo.projection * ubo.view * aModel * vec4(aPos, 1.0);
+    fragColor = aColor.rgb;
     TexCoord = aTexCoord;
-    FragPos = vec3(ubo.model * vec4(aPos, 1.0));  // World pos
-    Normal = mat3(transpose(inverse(ubo.model))) * aNormal;  // Transform normal (normal matrix)
+    Layer = aColor.w;
+    FragPos = vec3(aModel * vec4(aPos, 1.0));  // World pos
+    Normal = mat3(transpose(inverse(aModel))) * aNormal;  // Transform normal (normal matrix)
 }
\ No newline at end of file
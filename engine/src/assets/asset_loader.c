@@ -0,0 +1,549 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3_image/SDL_image.h>
+
+#include <assets/asset_loader.h>
+#include <gpu/buffer_heap.h>
+#include <material/m_common.h>
+#include <material/texture_array.h>
+#include <profiler/profiler.h>
+
+#define ASSET_UPLOAD_ALIGN 16 // offset of each upload in the transfer buffer
+#define ASSET_UPLOAD_BUDGET (64u * 1024u * 1024u) // bytes per update
+
+typedef enum {
+    ASSET_MESH,
+    ASSET_TEXTURE,
+} AssetKind;
+
+typedef struct AssetLoad AssetLoad;
+struct AssetLoad {
+    AssetLoad* next; // request queue, result stack, then ready list
+    AssetKind kind;
+    Entity entity;
+    SDL_AtomicInt cancelled;
+    bool failed;
+
+    MeshBuilder build;
+    void* params;
+    MeshData mesh; // mesh.mesh gets the buffers on upload
+
+    char* path;
+    SDL_Surface* surface; // ABGR8888
+    SDL_GPUTexture* texture;
+    Uint32 num_levels; // mips generated on upload when more than one
+
+    Uint32 offset; // in the transfer buffer
+};
+
+static SDL_Thread* threads[ASSET_LOADER_MAX_THREADS];
+static Uint32 thread_count = 0;
+
+// request FIFO, shared with the loader threads under lock
+static SDL_Mutex* lock = NULL;
+static SDL_Condition* wake = NULL;
+static AssetLoad* queue_head = NULL;
+static AssetLoad* queue_tail = NULL;
+static bool quitting = false;
+
+// finished loads: a lock-free stack pushed by the loader threads and taken
+// whole by asset_loader_update()
+static void* results = NULL;
+
+// main thread only: finished loads waiting for upload budget, in request
+// order, and every load not yet attached
+static AssetLoad* ready_head = NULL;
+static AssetLoad* ready_tail = NULL;
+static AssetLoad** live = NULL;
+static Uint32 live_count = 0;
+static Uint32 live_capacity = 0;
+
+static void free_load (AssetLoad* load) {
+    free (load->params);
+    free_mesh_data (&load->mesh);
+    free (load->path);
+    if (load->surface) SDL_DestroySurface (load->surface);
+    free (load);
+}
+
+static int decode_texture (AssetLoad* load) {
+    SDL_Surface* surface = IMG_Load (load->path);
+    if (!surface) {
+        SDL_Log ("Failed to load texture %s: %s", load->path, SDL_GetError ());
+        return 1;
+    }
+    load->surface = SDL_ConvertSurface (surface, SDL_PIXELFORMAT_ABGR8888);
+    SDL_DestroySurface (surface);
+    if (!load->surface) {
+        SDL_Log ("Failed to convert surface format: %s", SDL_GetError ());
+        return 1;
+    }
+    return 0;
+}
+
+static void run_load (AssetLoad* load) {
+    if (SDL_GetAtomicInt (&load->cancelled)) return;
+    PROFILE_ZONE ("asset_load");
+    if (load->kind == ASSET_MESH)
+        load->failed = load->build (load->params, &load->mesh) != 0;
+    else
+        load->failed = decode_texture (load) != 0;
+}
+
+static void push_result (AssetLoad* load) {
+    void* head;
+    do {
+        head = SDL_GetAtomicPointer (&results);
+        load->next = (AssetLoad*) head;
+    } while (!SDL_CompareAndSwapAtomicPointer (&results, head, load));
+}
+
+static int SDLCALL loader_main (void* data) {
+    (void) data;
+    profiler_register_thread ("Loader");
+
+    SDL_LockMutex (lock);
+    for (;;) {
+        while (!quitting && !queue_head) SDL_WaitCondition (wake, lock);
+        if (quitting) break;
+        AssetLoad* load = queue_head;
+        queue_head = load->next;
+        if (!queue_head) queue_tail = NULL;
+        SDL_UnlockMutex (lock);
+
+        run_load (load);
+        push_result (load);
+
+        SDL_LockMutex (lock);
+    }
+    SDL_UnlockMutex (lock);
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+int asset_loader_init (Uint32 num_threads) {
+    if (num_threads == 0) {
+        int cores = SDL_GetNumLogicalCPUCores ();
+        num_threads = cores > 1 ? (Uint32) cores - 1 : 1;
+    }
+    num_threads = SDL_min (num_threads, ASSET_LOADER_MAX_THREADS);
+
+    lock = SDL_CreateMutex ();
+    wake = SDL_CreateCondition ();
+    if (!lock || !wake) {
+        SDL_Log ("Failed to create asset loader locks: %s", SDL_GetError ());
+        asset_loader_shutdown ();
+        return 1;
+    }
+
+    // loads still on their way to a destroyed entity would attach to it
+    if (add_destroy_callback (cancel_asset_loads)) {
+        asset_loader_shutdown (); // logging handled in add_destroy_callback()
+        return 1;
+    }
+    quitting = false;
+    for (Uint32 i = 0; i < num_threads; i++) {
+        threads[i] = SDL_CreateThread (loader_main, "asset_loader", NULL);
+        if (!threads[i]) {
+            SDL_Log ("Failed to create asset loader: %s", SDL_GetError ());
+            asset_loader_shutdown ();
+            return 1;
+        }
+        thread_count++;
+    }
+    return 0;
+}
+
+void asset_loader_shutdown (void) {
+    remove_destroy_callback (cancel_asset_loads);
+    if (lock) {
+        SDL_LockMutex (lock);
+        quitting = true;
+        SDL_BroadcastCondition (wake);
+        SDL_UnlockMutex (lock);
+    }
+    for (Uint32 i = 0; i < thread_count; i++) SDL_WaitThread (threads[i], NULL);
+    thread_count = 0;
+
+    // every load is still in the live list wherever it was queued
+    for (Uint32 i = 0; i < live_count; i++) free_load (live[i]);
+    free (live);
+    live = NULL;
+    live_count = 0;
+    live_capacity = 0;
+    queue_head = queue_tail = NULL;
+    ready_head = ready_tail = NULL;
+    SDL_SetAtomicPointer (&results, NULL);
+
+    if (wake) SDL_DestroyCondition (wake);
+    if (lock) SDL_DestroyMutex (lock);
+    wake = NULL;
+    lock = NULL;
+}
+
+// loads of kind still on their way to e; a newer request replaces whatever
+// they would attach, and with several loader threads they may finish later
+static void supersede (Entity e, AssetKind kind) {
+    for (Uint32 i = 0; i < live_count; i++)
+        if (live[i]->entity == e && live[i]->kind == kind)
+            SDL_SetAtomicInt (&live[i]->cancelled, 1);
+}
+
+// Returns 0 on success, 1 on failure (the load is freed either way on failure)
+static int submit (AssetLoad* load) {
+    if (thread_count == 0) {
+        SDL_Log ("Asset loader is not running");
+        free_load (load);
+        return 1;
+    }
+    if (live_count == live_capacity) {
+        Uint32 capacity = live_capacity ? live_capacity * 2 : 64;
+        AssetLoad** grown =
+            (AssetLoad**) realloc (live, capacity * sizeof (AssetLoad*));
+        if (!grown) {
+            SDL_Log ("Failed to grow asset load list");
+            free_load (load);
+            return 1;
+        }
+        live = grown;
+        live_capacity = capacity;
+    }
+    supersede (load->entity, load->kind);
+    live[live_count++] = load;
+
+    SDL_LockMutex (lock);
+    if (queue_tail)
+        queue_tail->next = load;
+    else
+        queue_head = load;
+    queue_tail = load;
+    SDL_SignalCondition (wake);
+    SDL_UnlockMutex (lock);
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+int load_mesh_async (
+    Entity e,
+    MeshBuilder build,
+    const void* params,
+    size_t params_size
+) {
+    AssetLoad* load = (AssetLoad*) calloc (1, sizeof (AssetLoad));
+    if (!load) {
+        SDL_Log ("Failed to allocate mesh load");
+        return 1;
+    }
+    load->kind = ASSET_MESH;
+    load->entity = e;
+    load->build = build;
+    if (params_size > 0) {
+        load->params = malloc (params_size);
+        if (!load->params) {
+            SDL_Log ("Failed to allocate mesh load parameters");
+            free (load);
+            return 1;
+        }
+        memcpy (load->params, params, params_size);
+    }
+    return submit (load); // logging handled in submit()
+}
+
+// Returns 0 on success, 1 on failure
+int load_texture_async (Entity e, const char* path) {
+    AssetLoad* load = (AssetLoad*) calloc (1, sizeof (AssetLoad));
+    if (!load) {
+        SDL_Log ("Failed to allocate texture load");
+        return 1;
+    }
+    load->kind = ASSET_TEXTURE;
+    load->entity = e;
+    load->path = SDL_strdup (path);
+    if (!load->path) {
+        SDL_Log ("Failed to allocate texture load path");
+        free (load);
+        return 1;
+    }
+    return submit (load); // logging handled in submit()
+}
+
+void cancel_asset_loads (Entity e) {
+    for (Uint32 i = 0; i < live_count; i++)
+        if (live[i]->entity == e) SDL_SetAtomicInt (&live[i]->cancelled, 1);
+}
+
+Uint32 asset_loader_pending (void) {
+    return live_count;
+}
+
+static void retire (AssetLoad* load) {
+    for (Uint32 i = 0; i < live_count; i++) {
+        if (live[i] == load) {
+            live[i] = live[--live_count];
+            break;
+        }
+    }
+    free_load (load);
+}
+
+static Uint64 upload_size (const AssetLoad* load) {
+    if (load->kind == ASSET_TEXTURE)
+        return (Uint64) load->surface->w * load->surface->h * 4;
+    Uint64 vertices_size = (load->mesh.vertices_size + ASSET_UPLOAD_ALIGN - 1) &
+                           ~(Uint64) (ASSET_UPLOAD_ALIGN - 1);
+    return vertices_size + load->mesh.indices_size;
+}
+
+static void release_resources (SDL_GPUDevice* device, AssetLoad* load) {
+    release_mesh_buffers (device, &load->mesh.mesh);
+    if (load->texture) SDL_ReleaseGPUTexture (device, load->texture);
+    load->texture = NULL;
+}
+
+static SDL_GPUTextureCreateInfo texture_info (const AssetLoad* load) {
+    Uint32 width = (Uint32) load->surface->w;
+    Uint32 height = (Uint32) load->surface->h;
+    Uint32 num_levels = mip_level_count (width, height);
+    return (SDL_GPUTextureCreateInfo) {
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+        .width = width,
+        .height = height,
+        .layer_count_or_depth = 1,
+        .num_levels = num_levels,
+        .usage = mip_texture_usage (num_levels)
+    };
+}
+
+// Returns 0 on success, 1 on failure
+static int create_resources (SDL_GPUDevice* device, AssetLoad* load) {
+    if (load->kind == ASSET_TEXTURE) {
+        SDL_GPUTextureCreateInfo tex_info = texture_info (load);
+        load->texture = SDL_CreateGPUTexture (device, &tex_info);
+        if (!load->texture) {
+            SDL_Log ("Failed to create texture: %s", SDL_GetError ());
+            return 1;
+        }
+        load->num_levels = tex_info.num_levels;
+        return 0;
+    }
+
+    MeshComponent* mesh = &load->mesh.mesh;
+    if (buffer_heap_alloc (
+            device, BUFFER_HEAP_VERTEX, (Uint32) load->mesh.vertices_size,
+            &mesh->vertex_buffer, &mesh->vertex_offset
+        ) ||
+        buffer_heap_alloc (
+            device, BUFFER_HEAP_INDEX, (Uint32) load->mesh.indices_size,
+            &mesh->index_buffer, &mesh->index_offset
+        )) {
+        release_resources (device, load);
+        return 1; // logging handled in buffer_heap_alloc()
+    }
+    return 0;
+}
+
+static void copy_load (Uint8* dst, const AssetLoad* load) {
+    if (load->kind == ASSET_TEXTURE) {
+        const SDL_Surface* surface = load->surface;
+        size_t row_size = (size_t) surface->w * 4;
+        for (int y = 0; y < surface->h; y++)
+            memcpy (
+                dst + y * row_size,
+                (const Uint8*) surface->pixels + (size_t) y * surface->pitch,
+                row_size
+            );
+        return;
+    }
+    Uint64 index_offset = upload_size (load) - load->mesh.indices_size;
+    memcpy (dst, load->mesh.vertices, load->mesh.vertices_size);
+    memcpy (dst + index_offset, load->mesh.indices, load->mesh.indices_size);
+}
+
+static void record_upload (
+    SDL_GPUCopyPass* copy_pass,
+    SDL_GPUTransferBuffer* trans_buf,
+    const AssetLoad* load
+) {
+    if (load->kind == ASSET_TEXTURE) {
+        SDL_GPUTextureTransferInfo src_info = {
+            .transfer_buffer = trans_buf,
+            .offset = load->offset,
+            .pixels_per_row = (Uint32) load->surface->w,
+            .rows_per_layer = (Uint32) load->surface->h,
+        };
+        SDL_GPUTextureRegion dst_region = {
+            .texture = load->texture,
+            .w = (Uint32) load->surface->w,
+            .h = (Uint32) load->surface->h,
+            .d = 1,
+        };
+        SDL_UploadToGPUTexture (copy_pass, &src_info, &dst_region, false);
+        return;
+    }
+
+    SDL_GPUTransferBufferLocation src_loc = {
+        .transfer_buffer = trans_buf, .offset = load->offset
+    };
+    SDL_GPUBufferRegion dst_reg = {
+        .buffer = load->mesh.mesh.vertex_buffer,
+        .offset = load->mesh.mesh.vertex_offset,
+        .size = (Uint32) load->mesh.vertices_size
+    };
+    SDL_UploadToGPUBuffer (copy_pass, &src_loc, &dst_reg, false);
+
+    src_loc.offset += (Uint32) (upload_size (load) - load->mesh.indices_size);
+    dst_reg.buffer = load->mesh.mesh.index_buffer;
+    dst_reg.offset = load->mesh.mesh.index_offset;
+    dst_reg.size = (Uint32) load->mesh.indices_size;
+    SDL_UploadToGPUBuffer (copy_pass, &src_loc, &dst_reg, false);
+}
+
+// Returns 0 on success, 1 on failure
+// uploads every load in [first, last] that has resources in one copy pass
+static int upload_batch (
+    SDL_GPUDevice* device,
+    AssetLoad* first,
+    AssetLoad* last,
+    Uint32 size
+) {
+    SDL_GPUTransferBufferCreateInfo trans_info = {
+        .size = size, .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
+    };
+    SDL_GPUTransferBuffer* trans_buf =
+        SDL_CreateGPUTransferBuffer (device, &trans_info);
+    if (!trans_buf) {
+        SDL_Log ("Failed to create transfer buffer: %s", SDL_GetError ());
+        return 1;
+    }
+
+    Uint8* data = (Uint8*) SDL_MapGPUTransferBuffer (device, trans_buf, false);
+    if (!data) {
+        SDL_Log ("Failed to map transfer buffer: %s", SDL_GetError ());
+        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+        return 1;
+    }
+    for (AssetLoad* load = first; load != last->next; load = load->next)
+        if (!load->failed) copy_load (data + load->offset, load);
+    SDL_UnmapGPUTransferBuffer (device, trans_buf);
+
+    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (device);
+    if (!cmd) {
+        SDL_Log ("Failed to acquire command buffer: %s", SDL_GetError ());
+        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+        return 1;
+    }
+
+    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass (cmd);
+    if (!copy_pass) {
+        SDL_Log ("Failed to begin copy pass: %s", SDL_GetError ());
+        SDL_SubmitGPUCommandBuffer (cmd);
+        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+        return 1;
+    }
+    for (AssetLoad* load = first; load != last->next; load = load->next)
+        if (!load->failed) record_upload (copy_pass, trans_buf, load);
+    SDL_EndGPUCopyPass (copy_pass);
+
+    // fill in the mip chains from the uploaded top levels
+    for (AssetLoad* load = first; load != last->next; load = load->next)
+        if (!load->failed && load->texture && load->num_levels > 1)
+            SDL_GenerateMipmapsForGPUTexture (cmd, load->texture);
+    SDL_SubmitGPUCommandBuffer (cmd);
+
+    SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+    return 0;
+}
+
+static void attach (SDL_GPUDevice* device, AssetLoad* load) {
+    if (load->kind == ASSET_MESH) {
+        remove_mesh (device, load->entity);
+        add_mesh (load->entity, load->mesh.mesh);
+        load->mesh.mesh.vertex_buffer = NULL; // now owned by the entity
+        load->mesh.mesh.index_buffer = NULL;
+        return;
+    }
+
+    MaterialComponent* mat = get_material (load->entity);
+    if (!mat) {
+        SDL_Log (
+            "Entity %u has no material for texture %s", load->entity, load->path
+        );
+        release_resources (device, load);
+        return;
+    }
+    // the mip chain is copied into a layer of the matching texture array
+    SDL_GPUTextureCreateInfo tex_info = texture_info (load);
+    add_texture_layer (device, load->texture, &tex_info, mat);
+    load->texture = NULL; // logging handled in add_texture_layer()
+}
+
+void asset_loader_update (SDL_GPUDevice* device) {
+    // the stack is newest first; reverse it onto the ready list so loads are
+    // attached in the order they finished. That differs from request order
+    // across loader threads, which is why submit() cancels superseded loads
+    AssetLoad* list = (AssetLoad*) SDL_SetAtomicPointer (&results, NULL);
+    AssetLoad* fifo = NULL;
+    AssetLoad* fifo_tail = list;
+    while (list) {
+        AssetLoad* next = list->next;
+        list->next = fifo;
+        fifo = list;
+        list = next;
+    }
+    if (fifo) {
+        if (ready_tail)
+            ready_tail->next = fifo;
+        else
+            ready_head = fifo;
+        ready_tail = fifo_tail;
+    }
+    if (!ready_head) return;
+
+    PROFILE_ZONE ("asset_loader_update");
+
+    // create resources and lay out the transfer buffer up to the budget; the
+    // first load always goes so that oversized ones still make progress
+    AssetLoad* first = ready_head;
+    AssetLoad* last = NULL;
+    Uint64 size = 0;
+    for (AssetLoad* load = first; load; load = load->next) {
+        if (SDL_GetAtomicInt (&load->cancelled)) load->failed = true;
+        if (!load->failed) {
+            Uint64 load_size = upload_size (load);
+            Uint64 end = (size + ASSET_UPLOAD_ALIGN - 1) &
+                         ~(Uint64) (ASSET_UPLOAD_ALIGN - 1);
+            if (last && end + load_size > ASSET_UPLOAD_BUDGET) break;
+            if (end + load_size > SDL_MAX_UINT32) {
+                SDL_Log ("Asset for entity %u is too large", load->entity);
+                load->failed = true;
+            } else if (create_resources (device, load)) {
+                load->failed = true; // logging handled in create_resources()
+            } else {
+                load->offset = (Uint32) end;
+                size = end + load_size;
+            }
+        }
+        last = load;
+    }
+
+    ready_head = last->next;
+    if (!ready_head) ready_tail = NULL;
+
+    if (size > 0 && upload_batch (device, first, last, (Uint32) size)) {
+        // logging handled in upload_batch()
+        for (AssetLoad* load = first; load != last->next; load = load->next) {
+            release_resources (device, load);
+            load->failed = true;
+        }
+    }
+
+    AssetLoad* end = last->next;
+    for (AssetLoad* load = first; load != end;) {
+        AssetLoad* next = load->next;
+        if (!load->failed) attach (device, load);
+        retire (load);
+        load = next;
+    }
+}
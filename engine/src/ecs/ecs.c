@@ -2,10 +2,38 @@
 #include <stdlib.h>
 
 #include <ecs/ecs.h>
+#include <geometry/g_common.h>
+#include <gpu/draw_list.h>
+#include <gpu/hiz.h>
+#include <gpu/staging_ring.h>
+#include <jobs/jobs.h>
+#include <material/depth_prepass.h>
+#include <material/m_common.h>
+#include <material/texture_array.h>
+#include <profiler/gpu_timer.h>
+#include <profiler/profiler.h>
 #include <ui/ui.h>
 
+#define BUILD_CHUNK 256 // meshes per draw list building job
+
 static Uint32 next_entity_id = 0;
 
+static DestroyCallback destroy_callbacks[MAX_DESTROY_CALLBACKS];
+static Uint32 destroy_callback_count = 0;
+
+// drawn_packet was built ahead and is waiting to be submitted
+static bool packet_ahead = false;
+
+// meshes and materials removed while a packet was ahead; it may draw with
+// them, so they are released once it has been submitted
+static MeshComponent* retired_meshes = NULL;
+static Uint32 retired_mesh_count = 0;
+static Uint32 retired_mesh_capacity = 0;
+static MaterialComponent* retired_materials = NULL;
+static Uint32 retired_material_count = 0;
+static Uint32 retired_material_capacity = 0;
+static SDL_GPUDevice* retired_device = NULL;
+
 typedef struct {
     void* data;
     Uint32* entity_to_index;
@@ -129,6 +157,8 @@ Entity create_entity (void) {
 }
 
 void destroy_entity (SDL_GPUDevice* device, Entity e) {
+    for (Uint32 i = 0; i < destroy_callback_count; i++)
+        destroy_callbacks[i] (e);
     remove_transform (e);
     remove_mesh (device, e);
     remove_material (device, e);
@@ -137,6 +167,80 @@ void destroy_entity (SDL_GPUDevice* device, Entity e) {
     remove_billboard (e);
     remove_ambient_light (e);
     remove_point_light (e);
+    remove_ui (e);
+}
+
+// Returns 0 on success, 1 on failure
+int add_destroy_callback (DestroyCallback callback) {
+    if (destroy_callback_count == MAX_DESTROY_CALLBACKS) {
+        SDL_Log ("Too many entity destroy callbacks");
+        return 1;
+    }
+    destroy_callbacks[destroy_callback_count++] = callback;
+    return 0;
+}
+
+void remove_destroy_callback (DestroyCallback callback) {
+    for (Uint32 i = 0; i < destroy_callback_count; i++) {
+        if (destroy_callbacks[i] == callback) {
+            destroy_callbacks[i] = destroy_callbacks[--destroy_callback_count];
+            return;
+        }
+    }
+}
+
+// Returns true if mesh is kept for release_retired(), false if the caller
+// has to release it now
+static bool retire_mesh (SDL_GPUDevice* device, const MeshComponent* mesh) {
+    if (!packet_ahead) return false;
+    if (retired_mesh_count == retired_mesh_capacity) {
+        Uint32 new_cap = retired_mesh_capacity ? retired_mesh_capacity * 2 : 64;
+        MeshComponent* grown = (MeshComponent*) realloc (
+            retired_meshes, new_cap * sizeof (MeshComponent)
+        );
+        if (!grown) {
+            SDL_Log ("Failed to grow retired meshes");
+            return false;
+        }
+        retired_meshes = grown;
+        retired_mesh_capacity = new_cap;
+    }
+    retired_meshes[retired_mesh_count++] = *mesh;
+    retired_device = device;
+    return true;
+}
+
+// Returns true if mat is kept for release_retired(), false if the caller
+// has to release it now
+static bool
+retire_material (SDL_GPUDevice* device, const MaterialComponent* mat) {
+    if (!packet_ahead) return false;
+    if (retired_material_count == retired_material_capacity) {
+        Uint32 new_cap =
+            retired_material_capacity ? retired_material_capacity * 2 : 64;
+        MaterialComponent* grown = (MaterialComponent*) realloc (
+            retired_materials, new_cap * sizeof (MaterialComponent)
+        );
+        if (!grown) {
+            SDL_Log ("Failed to grow retired materials");
+            return false;
+        }
+        retired_materials = grown;
+        retired_material_capacity = new_cap;
+    }
+    retired_materials[retired_material_count++] = *mat;
+    retired_device = device;
+    return true;
+}
+
+// once no packet can draw with them
+static void release_retired (void) {
+    for (Uint32 i = 0; i < retired_mesh_count; i++)
+        release_mesh (retired_device, &retired_meshes[i]);
+    for (Uint32 i = 0; i < retired_material_count; i++)
+        release_material (retired_device, &retired_materials[i]);
+    retired_mesh_count = 0;
+    retired_material_count = 0;
 }
 
 // Transforms
@@ -153,6 +257,10 @@ TransformComponent* get_transform (Entity e) {
 bool has_transform (Entity e) {
     return pool_has (&transform_pool, e);
 }
+TransformComponent* get_transform_array (Uint32* count) {
+    *count = transform_pool.count;
+    return (TransformComponent*) transform_pool.data;
+}
 void remove_transform (Entity e) {
     pool_remove (&transform_pool, e, sizeof (TransformComponent));
 }
@@ -169,11 +277,9 @@ bool has_mesh (Entity e) {
 }
 void remove_mesh (SDL_GPUDevice* device, Entity e) {
     MeshComponent* mesh = get_mesh (e);
-    if (mesh) {
-        if (mesh->vertex_buffer)
-            SDL_ReleaseGPUBuffer (device, mesh->vertex_buffer);
-        if (mesh->index_buffer)
-            SDL_ReleaseGPUBuffer (device, mesh->index_buffer);
+    if (mesh && !retire_mesh (device, mesh)) {
+        render_pipeline_invalidate (); // it may be in the frame built ahead
+        release_mesh (device, mesh);
     }
     pool_remove (&mesh_pool, e, sizeof (MeshComponent));
 }
@@ -192,14 +298,9 @@ bool has_material (Entity e) {
 }
 void remove_material (SDL_GPUDevice* device, Entity e) {
     MaterialComponent* mat = get_material (e);
-    if (mat) {
-        if (mat->texture) SDL_ReleaseGPUTexture (device, mat->texture);
-        if (mat->pipeline)
-            SDL_ReleaseGPUGraphicsPipeline (device, mat->pipeline);
-        if (mat->vertex_shader)
-            SDL_ReleaseGPUShader (device, mat->vertex_shader);
-        if (mat->fragment_shader)
-            SDL_ReleaseGPUShader (device, mat->fragment_shader);
+    if (mat && !retire_material (device, mat)) {
+        render_pipeline_invalidate (); // it may be in the frame built ahead
+        release_material (device, mat);
     }
     pool_remove (&material_pool, e, sizeof (MaterialComponent));
 }
@@ -377,58 +478,360 @@ void fps_controller_update_system (float dt) {
     }
 }
 
-SDL_AppResult render_system (
+// (re)create the offscreen color target and depth buffer to match the
+// swapchain. Returns 0 on success, 1 on failure
+static int resize_render_targets (gpu_renderer* renderer) {
+    if (renderer->color_texture && renderer->dwidth == renderer->width &&
+        renderer->dheight == renderer->height) {
+        return 0;
+    }
+
+    if (renderer->depth_texture)
+        SDL_ReleaseGPUTexture (renderer->device, renderer->depth_texture);
+    SDL_GPUTextureCreateInfo depth_info = {
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = SDL_GPU_TEXTUREFORMAT_D24_UNORM,
+        .width = renderer->width,
+        .height = renderer->height,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+        // sampled to build the depth pyramid
+        .usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET |
+                 SDL_GPU_TEXTUREUSAGE_SAMPLER
+    };
+    renderer->depth_texture = SDL_CreateGPUTexture (renderer->device, &depth_info);
+    if (!renderer->depth_texture) {
+        SDL_Log ("Failed to recreate depth texture: %s", SDL_GetError ());
+        return 1;
+    }
+
+    // the mesh pass renders here so it can be submitted (and timed) on its own
+    // command buffer; the UI pass blits it to the swapchain
+    if (renderer->color_texture)
+        SDL_ReleaseGPUTexture (renderer->device, renderer->color_texture);
+    SDL_GPUTextureCreateInfo color_info = {
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = renderer->format,
+        .width = renderer->width,
+        .height = renderer->height,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+        .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET |
+                 SDL_GPU_TEXTUREUSAGE_SAMPLER
+    };
+    renderer->color_texture = SDL_CreateGPUTexture (renderer->device, &color_info);
+    if (!renderer->color_texture) {
+        SDL_Log ("Failed to create color target: %s", SDL_GetError ());
+        return 1;
+    }
+
+    renderer->dwidth = renderer->width;
+    renderer->dheight = renderer->height;
+    return 0;
+}
+
+// turn queued microui commands into rects, tagging each with the clip rect
+// that was active when it was queued
+static void ui_collect_rects (gpu_renderer* renderer, UIComponent* ui) {
+    PROFILE_ZONE ("ui_collect_rects");
+    SDL_Rect clip = {0};
+    mu_Command* mu_command = NULL;
+    while (mu_next_command (&ui->context, &mu_command)) {
+        Uint32 before = ui->rect_count;
+        switch (mu_command->type) {
+        case MU_COMMAND_TEXT:
+            draw_text (
+                ui, renderer->device, mu_command->text.str,
+                (float) mu_command->text.pos.x, (float) mu_command->text.pos.y,
+                (float) mu_command->text.color.r / 255.0f,
+                (float) mu_command->text.color.g / 255.0f,
+                (float) mu_command->text.color.b / 255.0f,
+                (float) mu_command->text.color.a / 255.0f
+            );
+            break;
+        case MU_COMMAND_RECT:
+            draw_rectangle (
+                ui, (float) mu_command->rect.rect.x,
+                (float) mu_command->rect.rect.y,
+                (float) mu_command->rect.rect.w,
+                (float) mu_command->rect.rect.h,
+                (float) mu_command->rect.color.r / 255.0f,
+                (float) mu_command->rect.color.g / 255.0f,
+                (float) mu_command->rect.color.b / 255.0f,
+                (float) mu_command->rect.color.a / 255.0f
+            );
+            break;
+        case MU_COMMAND_CLIP:
+            if (mu_command->clip.rect.w <= 0 || mu_command->clip.rect.h <= 0) {
+                clip = (SDL_Rect) {0};
+            } else {
+                clip = (SDL_Rect) {
+                    mu_command->clip.rect.x, mu_command->clip.rect.y,
+                    mu_command->clip.rect.w, mu_command->clip.rect.h
+                };
+            }
+            break;
+        default:
+            break;
+        }
+        if (ui->rect_count > before) ui->rects[ui->rect_count - 1].clip = clip;
+    }
+}
+
+// release text textures now (keep white texture); releases are deferred
+// until the command buffer completes
+static void ui_clear_rects (gpu_renderer* renderer, UIComponent* ui) {
+    for (Uint32 r = 0; r < ui->rect_count; r++) {
+        UIRect* rect = &ui->rects[r];
+        if (rect->texture != ui->white_texture) {
+            SDL_ReleaseGPUTexture (renderer->device, rect->texture);
+            rect->texture = ui->white_texture;
+        }
+    }
+    ui->rect_count = 0;
+}
+
+// stage every UI component's rects into its vertex/index buffers; the copies
+// are recorded by the next staging_ring_flush()
+static void ui_upload (gpu_renderer* renderer) {
+    PROFILE_ZONE ("ui_upload");
+    const Uint32 vsize = 40 * sizeof (float);
+    const Uint32 isize = 6 * sizeof (Uint32);
+    float rx = (float) renderer->width;
+    float ry = (float) renderer->height;
+    for (Uint32 i = 0; i < ui_pool.count; i++) {
+        UIComponent* ui = &((UIComponent*) ui_pool.data)[i];
+        if (ui->rect_count == 0) continue;
+        Uint8* verts_map = (Uint8*) staging_upload_buffer (
+            ui->vbo, 0, ui->rect_count * vsize, true
+        );
+        Uint32* inds = (Uint32*) staging_upload_buffer (
+            ui->ibo, 0, ui->rect_count * isize, true
+        );
+        if (!verts_map || !inds) {
+            // logging handled in staging_upload_buffer()
+            ui_clear_rects (renderer, ui);
+            continue;
+        }
+
+        for (Uint32 r = 0; r < ui->rect_count; r++) {
+            UIRect* rect = &ui->rects[r];
+            float x1 = rect->rect.x;
+            float y1 = rect->rect.y;
+            float x2 = rect->rect.x + rect->rect.w;
+            float y2 = rect->rect.y + rect->rect.h;
+            SDL_FColor col = rect->color;
+            float verts[40] = {
+                x1, y2, rx, ry, col.r, col.g, col.b, col.a, 0.0f, 1.0f,
+                x2, y2, rx, ry, col.r, col.g, col.b, col.a, 1.0f, 1.0f,
+                x1, y1, rx, ry, col.r, col.g, col.b, col.a, 0.0f, 0.0f,
+                x2, y1, rx, ry, col.r, col.g, col.b, col.a, 1.0f, 0.0f,
+            };
+            memcpy (verts_map + r * vsize, verts, vsize);
+        }
+        for (Uint32 r = 0; r < ui->rect_count; r++) {
+            Uint32 base = r * 4;
+            inds[r * 6 + 0] = base + 0;
+            inds[r * 6 + 1] = base + 1;
+            inds[r * 6 + 2] = base + 2;
+            inds[r * 6 + 3] = base + 1;
+            inds[r * 6 + 4] = base + 3;
+            inds[r * 6 + 5] = base + 2;
+        }
+    }
+}
+
+static void ui_draw (
     gpu_renderer* renderer,
-    Entity cam,
-    Uint64* prerender,
-    Uint64* preui,
-    Uint64* postrender
+    SDL_GPURenderPass* pass,
+    UIComponent* ui
 ) {
-    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (renderer->device);
-    SDL_GPUTexture* swapchain;
-    if (!SDL_WaitAndAcquireGPUSwapchainTexture (
-            cmd, renderer->window, &swapchain, &renderer->width,
-            &renderer->height
-        )) {
-        SDL_Log ("Failed to get swapchain texture: %s", SDL_GetError ());
-        return SDL_APP_FAILURE;
-    }
-    if (swapchain == NULL) {
-        SDL_Log ("Failed to get swapchain texture: %s", SDL_GetError ());
-        SDL_SubmitGPUCommandBuffer (cmd);
-        return SDL_APP_FAILURE;
-    }
-
-    if (renderer->dwidth != renderer->width ||
-        renderer->dheight != renderer->height) {
-        if (renderer->depth_texture)
-            SDL_ReleaseGPUTexture (renderer->device, renderer->depth_texture);
-        SDL_GPUTextureCreateInfo depth_info = {
-            .type = SDL_GPU_TEXTURETYPE_2D,
-            .format = SDL_GPU_TEXTUREFORMAT_D24_UNORM,
-            .width = renderer->width,
-            .height = renderer->height,
-            .layer_count_or_depth = 1,
-            .num_levels = 1,
-            .usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET
-        };
-        renderer->depth_texture =
-            SDL_CreateGPUTexture (renderer->device, &depth_info);
-        if (!renderer->depth_texture) {
-            SDL_Log ("Failed to recreate depth texture: %s", SDL_GetError ());
-            SDL_SubmitGPUCommandBuffer (cmd);
-            return SDL_APP_FAILURE;
+    SDL_Rect full = {0, 0, (int) renderer->width, (int) renderer->height};
+    SDL_BindGPUGraphicsPipeline (pass, ui->pipeline);
+    SDL_GPUBufferBinding vbind = {.buffer = ui->vbo, .offset = 0};
+    SDL_BindGPUVertexBuffers (pass, 0, &vbind, 1);
+    SDL_GPUBufferBinding ibind = {.buffer = ui->ibo, .offset = 0};
+    SDL_BindGPUIndexBuffer (pass, &ibind, SDL_GPU_INDEXELEMENTSIZE_32BIT);
+
+    for (Uint32 r = 0; r < ui->rect_count; r++) {
+        UIRect* rect = &ui->rects[r];
+
+        SDL_Rect scissor = full;
+        if (rect->clip.w > 0 && rect->clip.h > 0 &&
+            !SDL_GetRectIntersection (&rect->clip, &full, &scissor)) {
+            continue; // clipped away entirely
         }
-        renderer->dwidth = renderer->width;
-        renderer->dheight = renderer->height;
+        SDL_SetGPUScissor (pass, &scissor);
+
+        SDL_GPUTextureSamplerBinding tex_bind = {
+            .texture = rect->texture,
+            .sampler = ui->sampler
+        };
+        SDL_BindGPUFragmentSamplers (pass, 0, &tex_bind, 1);
+        SDL_DrawGPUIndexedPrimitives (pass, 6, 1, r * 6, 0, 0);
+    }
+    SDL_SetGPUScissor (pass, &full);
+    ui_clear_rects (renderer, ui);
+}
+
+// level whose detail suits the mesh's projected diameter; pixels_per_unit
+// is the screen height in pixels covered by one unit at distance one
+static const MeshComponent* select_mesh_lod (
+    const MeshComponent* mesh,
+    const TransformComponent* trans,
+    vec3 camera_pos,
+    float pixels_per_unit
+) {
+    if (mesh->lod_count == 0) return mesh;
+
+    float scale = SDL_max (
+        SDL_max (fabsf (trans->scale.x), fabsf (trans->scale.y)),
+        fabsf (trans->scale.z)
+    );
+    vec3 offset = vec3_sub (trans->position, camera_pos);
+    float distance = sqrtf (vec3_dot (offset, offset));
+    float radius = mesh->radius * scale;
+    if (distance <= radius) return mesh;
+
+    float pixels = 2.0f * radius * pixels_per_unit / distance;
+    Uint32 level = 0;
+    for (float cutoff = MESH_LOD_PIXELS; pixels < cutoff; cutoff *= 0.5f) {
+        if (level == mesh->lod_count) break;
+        level++;
     }
+    return level == 0 ? mesh : &mesh->lods[level - 1];
+}
+
+// what the world looks like to the renderer for one frame: everything
+// submit_packet() needs besides the draw list and the UI
+typedef struct {
+    bool valid; // false without an active camera
+    UBOData ubo;
+    mat4 view_proj;
+} RenderPacket;
+
+// built into one while the other is submitted, swapped with the draw lists
+static RenderPacket packets[2];
+static RenderPacket* built_packet = &packets[0];
+static RenderPacket* drawn_packet = &packets[1];
+
+// pipelining, when render_pipeline_init() has started the frame thread
+static SDL_Thread* frame_thread = NULL;
+static SDL_Semaphore* build_start = NULL;
+static SDL_Semaphore* build_done = NULL;
+static SDL_AtomicInt frame_thread_running;
+static Uint32 sync_builds = 0; // frames built on the main thread meanwhile
+
+// the frame thread's next build, written before build_start is signaled
+static const gpu_renderer* build_renderer = NULL;
+static Entity build_cam = 0;
+static Uint32 build_width = 0;
+static Uint32 build_height = 0;
+
+// shared by the draw list building jobs
+typedef struct {
+    const gpu_renderer* renderer;
+    const TransformComponent* cam_trans;
+    float pixels_per_unit;
+} BuildJob;
+
+// draws found by each chunk, kept from its first slot
+static Uint32* build_chunk_counts = NULL;
+static Uint32 build_chunk_capacity = 0;
+
+// Returns true if mesh i of the pool draws, into reserved slot
+static bool build_draw (const BuildJob* job, Uint32 i, Uint32 slot) {
+    Entity e = mesh_pool.index_to_entity[i];
+    MeshComponent* mesh = &((MeshComponent*) mesh_pool.data)[i];
+    if (!mesh->vertex_buffer) return false;
+    MaterialComponent* mat = get_material (e);
+    TransformComponent* trans = get_transform (e);
+    if (!mat || !trans) return false;
+    const MeshComponent* level = select_mesh_lod (
+        mesh, trans, job->cam_trans->position, job->pixels_per_unit
+    );
+    SDL_GPUGraphicsPipeline* pipeline = mat->pipeline;
+    SDL_GPUGraphicsPipeline* equal_pipeline = mat->equal_pipeline;
+    if (level->layout == VERTEX_LAYOUT_COMPACT) {
+        pipeline = mat->compact_pipeline;
+        equal_pipeline = mat->equal_compact_pipeline;
+    } else if (level->layout == VERTEX_LAYOUT_SEPARATE) {
+        pipeline = mat->separate_pipeline;
+        equal_pipeline = mat->equal_separate_pipeline;
+    }
+    if (!pipeline) return false;
+    // pre-passed draws must shade with the EQUAL test, or they would fail
+    // against their own depth
+    SDL_GPUGraphicsPipeline* depth_pipeline = NULL;
+    if (job->renderer->depth_prepass && equal_pipeline)
+        depth_pipeline = depth_prepass_pipeline (level->layout, mat->side);
+    if (depth_pipeline) pipeline = equal_pipeline;
+
+    mat4 model;
+    mat4_identity (model);
+    if (has_billboard (e)) {
+        mat4_translate (model, trans->position);
+        mat4_rotate_quat (model, job->cam_trans->rotation);
+        mat4_rotate_y (model, (float) M_PI);
+        mat4_scale (model, trans->scale);
+    } else {
+        mat4_translate (model, trans->position);
+        mat4_rotate_quat (model, trans->rotation);
+        mat4_scale (model, trans->scale);
+    }
+
+    ObjectData object;
+    memcpy (object.model, model, sizeof (mat4));
+    object.color = (vec4) {mat->color.x, mat->color.y, mat->color.z,
+                           (float) mat->texture_layer};
+    object.pos_scale = (vec4) {level->pos_scale.x, level->pos_scale.y,
+                               level->pos_scale.z, 0.0f};
+    object.pos_offset = (vec4) {level->pos_offset.x, level->pos_offset.y,
+                                level->pos_offset.z, level->radius};
+    SDL_GPUTexture* texture = mat->texture_array
+                                  ? mat->texture_array->texture
+                                  : job->renderer->white_texture;
+    DrawQueue queue = mat->blended ? DRAW_QUEUE_BLENDED : DRAW_QUEUE_OPAQUE;
+    draw_list_set (
+        slot, pipeline, depth_pipeline, texture, level, &object, queue
+    );
+    return true;
+}
+
+// fills chunks [start, end) of the mesh pool into the reserved draw list
+// slots; chunk c's draws go from its first mesh's slot on
+static void build_draws_job (void* data, Uint32 start, Uint32 end) {
+    const BuildJob* job = (const BuildJob*) data;
+    for (Uint32 chunk = start; chunk < end; chunk++) {
+        Uint32 first = chunk * BUILD_CHUNK;
+        Uint32 last = SDL_min (first + BUILD_CHUNK, mesh_pool.count);
+        Uint32 slot = first;
+        for (Uint32 i = first; i < last; i++)
+            if (build_draw (job, i, slot)) slot++;
+        build_chunk_counts[chunk] = slot - first;
+    }
+}
+
+// fills built_packet and the draw list being built from the world; reads
+// components only, so it may run on the frame thread while the main thread
+// submits. width and height are the target's, which the main thread may be
+// changing in renderer meanwhile.
+static void build_packet (
+    const gpu_renderer* renderer,
+    Entity cam,
+    Uint32 width,
+    Uint32 height
+) {
+    PROFILE_ZONE ("build packet");
+    RenderPacket* packet = built_packet;
+    draw_list_reset ();
 
     TransformComponent* cam_trans = get_transform (cam);
     CameraComponent* cam_comp = get_camera (cam);
     if (!cam_trans || !cam_comp) {
         SDL_Log ("No active camera entity");
-        SDL_SubmitGPUCommandBuffer (cmd);
-        return SDL_APP_CONTINUE;
+        packet->valid = false;
+        return;
     }
 
     mat4 view;
@@ -438,48 +841,33 @@ SDL_AppResult render_system (
     mat4_translate (view, vec3_scale (cam_trans->position, -1.0f));
 
     mat4 proj;
-    float aspect = (float) renderer->width / (float) renderer->height;
+    float aspect = (float) width / (float) height;
+    float fov = cam_comp->fov * (float) M_PI / 180.0f;
     mat4_perspective (
-        proj, cam_comp->fov * (float) M_PI / 180.0f, aspect,
-        cam_comp->near_clip, cam_comp->far_clip
+        proj, fov, aspect, cam_comp->near_clip, cam_comp->far_clip
     );
-
-    SDL_GPUColorTargetInfo color_target_info = {
-        .texture = swapchain,
-        .clear_color = {0.0f, 0.0f, 0.0f, 1.0f},
-        .load_op = SDL_GPU_LOADOP_CLEAR,
-        .store_op = SDL_GPU_STOREOP_STORE
-    };
-
-    SDL_GPUDepthStencilTargetInfo depth_target_info = {
-        .texture = renderer->depth_texture,
-        .load_op = SDL_GPU_LOADOP_CLEAR,
-        .store_op = SDL_GPU_STOREOP_STORE,
-        .cycle = false,
-        .clear_depth = 1.0f
-    };
-
-    SDL_GPURenderPass* pass =
-        SDL_BeginGPURenderPass (cmd, &color_target_info, 1, &depth_target_info);
-    SDL_GPUViewport viewport = {
-        0.0f, 0.0f, (float) renderer->width, (float) renderer->height,
-        0.0f, 1.0f
-    };
-    SDL_SetGPUViewport (pass, &viewport);
-
+    float pixels_per_unit = (float) height / (2.0f * tanf (fov * 0.5f));
+
+    // per-frame uniforms hold for every draw in the command buffer
+    UBOData* ubo = &packet->ubo;
+    *ubo = (UBOData) {0};
+    memcpy (ubo->view, view, sizeof (mat4));
+    memcpy (ubo->proj, proj, sizeof (mat4));
+    ubo->camera_pos = (vec4) {cam_trans->position.x, cam_trans->position.y,
+                              cam_trans->position.z, 0.0f};
+    mat4_multiply (packet->view_proj, proj, view);
+
+    PROFILE_BEGIN ("gather lights");
     int ambient_idx = 0;
-    vec4 ambient_colors[MAX_LIGHTS] = {0};
     for (Uint32 i = 0; i < ambient_light_pool.count; i++) {
         if (ambient_idx >= MAX_LIGHTS) break;
         AmbientLightComponent light =
             ((AmbientLightComponent*) ambient_light_pool.data)[i];
         if (light.w <= 0.0f) continue;
-        ambient_colors[ambient_idx++] = light;
+        ubo->ambient_color[ambient_idx++] = light;
     }
 
     int point_idx = 0;
-    vec4 light_positions[MAX_LIGHTS] = {0};
-    vec4 light_colors[MAX_LIGHTS] = {0};
     for (Uint32 i = 0; i < point_light_pool.count; i++) {
         if (point_idx >= MAX_LIGHTS) break;
         Entity e = point_light_pool.index_to_entity[i];
@@ -488,229 +876,325 @@ SDL_AppResult render_system (
         if (light.w <= 0.0f) continue;
         TransformComponent* trans = get_transform (e);
         if (!trans) continue;
-        light_positions[point_idx] =
+        ubo->point_light_pos[point_idx] =
             (vec4) {trans->position.x, trans->position.y, trans->position.z,
                     0.0f};
-        light_colors[point_idx] = light;
+        ubo->point_light_color[point_idx] = light;
         point_idx++;
     }
-
-    *prerender = SDL_GetTicksNS ();
-    for (Uint32 i = 0; i < mesh_pool.count; i++) {
-        Entity e = mesh_pool.index_to_entity[i];
-        MeshComponent* mesh = &((MeshComponent*) mesh_pool.data)[i];
-        if (!mesh->vertex_buffer) continue;
-        MaterialComponent* mat = get_material (e);
-        TransformComponent* trans = get_transform (e);
-        if (!mat || !mat->pipeline || !trans) continue;
-
-        mat4 model;
-        mat4_identity (model);
-        if (has_billboard (e)) {
-            mat4_translate (model, trans->position);
-            mat4_rotate_quat (model, cam_trans->rotation);
-            mat4_rotate_y (model, (float) M_PI);
-            mat4_scale (model, trans->scale);
+    PROFILE_END ();
+
+    PROFILE_BEGIN ("build draw list");
+    // at most one draw per mesh, so every chunk has slots for all of its
+    // meshes; the chunks' draws then close up in pool order
+    Uint32 chunk_count = (mesh_pool.count + BUILD_CHUNK - 1) / BUILD_CHUNK;
+    if (chunk_count > build_chunk_capacity) {
+        Uint32* grown = (Uint32*) realloc (
+            build_chunk_counts, chunk_count * sizeof (Uint32)
+        );
+        if (!grown) {
+            SDL_Log ("Failed to grow draw list build chunks");
+            chunk_count = 0;
         } else {
-            mat4_translate (model, trans->position);
-            mat4_rotate_quat (model, trans->rotation);
-            mat4_scale (model, trans->scale);
+            build_chunk_counts = grown;
+            build_chunk_capacity = chunk_count;
         }
+    }
+    if (chunk_count && !draw_list_reserve (mesh_pool.count)) {
+        BuildJob job = {
+            .renderer = renderer,
+            .cam_trans = cam_trans,
+            .pixels_per_unit = pixels_per_unit
+        };
+        jobs_parallel_for (chunk_count, 1, build_draws_job, &job);
+        for (Uint32 c = 0; c < chunk_count; c++)
+            draw_list_keep (c * BUILD_CHUNK, build_chunk_counts[c]);
+    }
+    draw_list_sort (view);
+    PROFILE_END ();
+    packet->valid = true;
+}
 
-        UBOData ubo = {0};
-        memcpy (ubo.model, model, sizeof (mat4));
-        memcpy (ubo.view, view, sizeof (mat4));
-        memcpy (ubo.proj, proj, sizeof (mat4));
-        memcpy (
-            ubo.point_light_pos, light_positions, point_idx * sizeof (vec4)
-        );
-        memcpy (ubo.point_light_color, light_colors, point_idx * sizeof (vec4));
-        memcpy (ubo.ambient_color, ambient_colors, ambient_idx * sizeof (vec4));
+static void swap_packets (void) {
+    RenderPacket* built = built_packet;
+    built_packet = drawn_packet;
+    drawn_packet = built;
+    draw_list_swap ();
+}
 
-        ubo.color = (vec4) {mat->color.x, mat->color.y, mat->color.z, 1.0f};
-        ubo.camera_pos = (vec4) {cam_trans->position.x, cam_trans->position.y,
-                                 cam_trans->position.z, 0.0f};
+static int SDLCALL frame_thread_main (void* data) {
+    (void) data;
+    profiler_register_thread ("Frame");
 
-        SDL_BindGPUGraphicsPipeline (pass, mat->pipeline);
-        SDL_PushGPUVertexUniformData (cmd, 0, &ubo, sizeof (UBOData));
-        SDL_PushGPUFragmentUniformData (cmd, 0, &ubo, sizeof (UBOData));
+    for (;;) {
+        SDL_WaitSemaphore (build_start);
+        if (!SDL_GetAtomicInt (&frame_thread_running)) break;
+        build_packet (build_renderer, build_cam, build_width, build_height);
+        SDL_SignalSemaphore (build_done);
+    }
+    return 0;
+}
 
-        SDL_GPUTextureSamplerBinding tex_bind = {
-            .texture = mat->texture ? mat->texture : renderer->white_texture,
-            .sampler = renderer->sampler
-        };
-        SDL_BindGPUFragmentSamplers (pass, 0, &tex_bind, 1);
+int render_pipeline_init (gpu_renderer* renderer, Uint32 frames_in_flight) {
+    if (frame_thread) {
+        SDL_Log ("Render pipelining already initialized");
+        return 1;
+    }
+    if (!SDL_SetGPUAllowedFramesInFlight (
+            renderer->device, SDL_clamp (frames_in_flight, 1u, 3u)
+        )) {
+        SDL_Log ("Failed to set frames in flight: %s", SDL_GetError ());
+        return 1;
+    }
 
-        SDL_GPUBufferBinding vbo_binding = {
-            .buffer = mesh->vertex_buffer,
-            .offset = 0
-        };
-        SDL_BindGPUVertexBuffers (pass, 0, &vbo_binding, 1);
+    sync_builds = 0;
+    build_start = SDL_CreateSemaphore (0);
+    build_done = SDL_CreateSemaphore (0);
+    if (!build_start || !build_done) {
+        SDL_Log ("Failed to create frame semaphores: %s", SDL_GetError ());
+        render_pipeline_shutdown ();
+        return 1;
+    }
+    SDL_SetAtomicInt (&frame_thread_running, 1);
+    frame_thread = SDL_CreateThread (frame_thread_main, "frame", NULL);
+    if (!frame_thread) {
+        SDL_Log ("Failed to create frame thread: %s", SDL_GetError ());
+        render_pipeline_shutdown ();
+        return 1;
+    }
+    return 0;
+}
 
-        if (mesh->index_buffer) {
-            SDL_GPUBufferBinding ibo_binding = {
-                .buffer = mesh->index_buffer,
-                .offset = 0
-            };
-            SDL_BindGPUIndexBuffer (pass, &ibo_binding, mesh->index_size);
-            SDL_DrawGPUIndexedPrimitives (pass, mesh->num_indices, 1, 0, 0, 0);
-        } else {
-            SDL_DrawGPUPrimitives (pass, mesh->num_vertices, 1, 0, 0);
-        }
+void render_pipeline_shutdown (void) {
+    if (frame_thread) {
+        SDL_SetAtomicInt (&frame_thread_running, 0);
+        SDL_SignalSemaphore (build_start);
+        SDL_WaitThread (frame_thread, NULL);
     }
+    if (build_start) SDL_DestroySemaphore (build_start);
+    if (build_done) SDL_DestroySemaphore (build_done);
+    frame_thread = NULL;
+    build_start = NULL;
+    build_done = NULL;
+    render_pipeline_invalidate ();
+}
 
-    // draw queued texts
-    *preui = SDL_GetTicksNS ();
-    for (int i = 0; i < ui_pool.count; i++) {
-        UIComponent* ui = &((UIComponent*) ui_pool.data)[i];
+void render_pipeline_invalidate (void) {
+    packet_ahead = false;
+    release_retired ();
+}
 
-        bool scissor_enabled = false;
-        mu_Command* mu_command = NULL;
-        while (mu_next_command (&ui->context, &mu_command)) {
-            switch (mu_command->type) {
-            case MU_COMMAND_TEXT:
-                draw_text (
-                    ui, renderer->device, mu_command->text.str,
-                    (float) mu_command->text.pos.x,
-                    (float) mu_command->text.pos.y,
-                    (float) mu_command->text.color.r / 255.0f,
-                    (float) mu_command->text.color.g / 255.0f,
-                    (float) mu_command->text.color.b / 255.0f,
-                    (float) mu_command->text.color.a / 255.0f
-                );
-                break;
-            case MU_COMMAND_RECT:
-                draw_rectangle (
-                    ui, (float) mu_command->rect.rect.x,
-                    (float) mu_command->rect.rect.y,
-                    (float) mu_command->rect.rect.w,
-                    (float) mu_command->rect.rect.h,
-                    (float) mu_command->rect.color.r / 255.0f,
-                    (float) mu_command->rect.color.g / 255.0f,
-                    (float) mu_command->rect.color.b / 255.0f,
-                    (float) mu_command->rect.color.a / 255.0f
-                );
-                break;
-            case MU_COMMAND_CLIP:
-                if (mu_command->clip.rect.w <= 0 ||
-                    mu_command->clip.rect.h <= 0) {
-                    if (scissor_enabled) {
-                        SDL_SetGPUScissor (pass, NULL);
-                        scissor_enabled = false;
-                    }
-                } else {
-                    SDL_Rect scissor = {
-                        (int) mu_command->clip.rect.x,
-                        (int) mu_command->clip.rect.y,
-                        (int) mu_command->clip.rect.w,
-                        (int) mu_command->clip.rect.h,
-                    };
-                    SDL_SetGPUScissor (pass, &scissor);
-                    scissor_enabled = true;
-                }
-                break;
-            default:
-                break;
-            }
+Uint32 render_pipeline_sync_builds (void) {
+    return sync_builds;
+}
+
+// records and submits drawn_packet and the draw list being drawn, with the
+// UI as it is now
+static SDL_AppResult submit_packet (
+    gpu_renderer* renderer,
+    Uint64* preui,
+    Uint64* postrender
+) {
+    PROFILE_ZONE ("submit packet");
+    RenderPacket* packet = drawn_packet;
+
+    // the swapchain is acquired on the UI command buffer, which presents it
+    SDL_GPUCommandBuffer* ui_cmd = SDL_AcquireGPUCommandBuffer (renderer->device);
+    SDL_GPUTexture* swapchain = NULL;
+    if (renderer->window) {
+        PROFILE_BEGIN ("acquire swapchain");
+        bool acquired = SDL_WaitAndAcquireGPUSwapchainTexture (
+            ui_cmd, renderer->window, &swapchain, &renderer->width,
+            &renderer->height
+        );
+        PROFILE_END ();
+        if (!acquired) {
+            SDL_Log ("Failed to get swapchain texture: %s", SDL_GetError ());
+            return SDL_APP_FAILURE;
+        }
+        if (swapchain == NULL) {
+            SDL_Log ("Failed to get swapchain texture: %s", SDL_GetError ());
+            SDL_SubmitGPUCommandBuffer (ui_cmd);
+            return SDL_APP_FAILURE;
         }
-        if (scissor_enabled) SDL_SetGPUScissor (pass, NULL);
+    }
 
-        if (ui->rect_count == 0) continue;
-        SDL_BindGPUGraphicsPipeline (pass, ui->pipeline);
+    if (resize_render_targets (renderer)) {
+        SDL_SubmitGPUCommandBuffer (ui_cmd);
+        return SDL_APP_FAILURE; // logging handled in resize_render_targets
+    }
 
-        for (int r = 0; r < ui->rect_count; r++) {
-            UIRect* rect = &ui->rects[r];
+    // headless renderers draw the UI straight onto the offscreen target
+    if (!renderer->window) swapchain = renderer->color_texture;
 
-            float rx = (float) renderer->width;
-            float ry = (float) renderer->height;
-            float x1 = rect->rect.x;
-            float y1 = rect->rect.y;
-            float x2 = rect->rect.x + rect->rect.w;
-            float y2 = rect->rect.y + rect->rect.h;
-            SDL_FColor col = rect->color;
-            float verts[40] = {
-                x1, y2, rx, ry, col.r, col.g, col.b, col.a, 0.0f, 1.0f,
-                x2, y2, rx, ry, col.r, col.g, col.b, col.a, 1.0f, 1.0f,
-                x1, y1, rx, ry, col.r, col.g, col.b, col.a, 0.0f, 0.0f,
-                x2, y1, rx, ry, col.r, col.g, col.b, col.a, 1.0f, 0.0f,
-            };
-            uint32_t inds[6] = {0, 1, 2, 1, 3, 2};
+    if (!packet->valid) {
+        SDL_SubmitGPUCommandBuffer (ui_cmd);
+        return SDL_APP_CONTINUE; // logging handled in build_packet()
+    }
 
-            uint32_t vsize = sizeof (verts);
-            uint32_t isize = sizeof (inds);
+    // everything staged this frame (UI geometry, text, draws) goes up ahead
+    // of the mesh pass, whose command buffer is submitted before the UI one
+    PROFILE_BEGIN ("stage uploads");
+    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (renderer->device);
+    for (Uint32 i = 0; i < ui_pool.count; i++) {
+        ui_collect_rects (renderer, &((UIComponent*) ui_pool.data)[i]);
+    }
+    ui_upload (renderer);
+    draw_list_upload (); // logging handled in draw_list_upload()
+    staging_ring_flush (cmd); // logging handled in staging_ring_flush()
+    PROFILE_END ();
 
-            SDL_GPUTransferBufferCreateInfo vtinfo = {
-                .size = vsize,
-                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
-            };
-            SDL_GPUTransferBuffer* vtbuf =
-                SDL_CreateGPUTransferBuffer (renderer->device, &vtinfo);
-            void* vmap =
-                SDL_MapGPUTransferBuffer (renderer->device, vtbuf, false);
-            memcpy (vmap, verts, vsize);
-            SDL_UnmapGPUTransferBuffer (renderer->device, vtbuf);
-
-            SDL_GPUTransferBufferCreateInfo itinfo = {
-                .size = isize,
-                .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
-            };
-            SDL_GPUTransferBuffer* itbuf =
-                SDL_CreateGPUTransferBuffer (renderer->device, &itinfo);
-            void* imap =
-                SDL_MapGPUTransferBuffer (renderer->device, itbuf, false);
-            memcpy (imap, inds, isize);
-            SDL_UnmapGPUTransferBuffer (renderer->device, itbuf);
-
-            SDL_GPUCopyPass* copy = SDL_BeginGPUCopyPass (cmd);
-            SDL_GPUTransferBufferLocation vsrc = {
-                .transfer_buffer = vtbuf,
-                .offset = 0
-            };
-            SDL_GPUBufferRegion vdst =
-                {.buffer = ui->vbo, .offset = 0, .size = vsize};
-            SDL_UploadToGPUBuffer (copy, &vsrc, &vdst, false);
-            SDL_GPUTransferBufferLocation isrc = {
-                .transfer_buffer = itbuf,
-                .offset = 0
-            };
-            SDL_GPUBufferRegion idst =
-                {.buffer = ui->ibo, .offset = 0, .size = isize};
-            SDL_UploadToGPUBuffer (copy, &isrc, &idst, false);
-            SDL_EndGPUCopyPass (copy);
-            SDL_ReleaseGPUTransferBuffer (renderer->device, vtbuf);
-            SDL_ReleaseGPUTransferBuffer (renderer->device, itbuf);
-
-            SDL_GPUTextureSamplerBinding tex_bind = {
-                .texture = rect->texture,
-                .sampler = ui->sampler
-            };
-            SDL_BindGPUFragmentSamplers (pass, 0, &tex_bind, 1);
+    draw_list_cull (cmd, packet->view_proj);
 
-            SDL_GPUBufferBinding vbind = {.buffer = ui->vbo, .offset = 0};
-            SDL_BindGPUVertexBuffers (pass, 0, &vbind, 1);
-            SDL_GPUBufferBinding ibind = {.buffer = ui->ibo, .offset = 0};
-            SDL_BindGPUIndexBuffer (
-                pass, &ibind, SDL_GPU_INDEXELEMENTSIZE_32BIT
-            );
-            SDL_DrawGPUIndexedPrimitives (pass, 6, 1, 0, 0, 0);
+    PROFILE_BEGIN ("mesh pass");
+    SDL_GPUColorTargetInfo color_target_info = {
+        .texture = renderer->color_texture,
+        .clear_color = {0.0f, 0.0f, 0.0f, 1.0f},
+        .load_op = SDL_GPU_LOADOP_CLEAR,
+        .store_op = SDL_GPU_STOREOP_STORE
+    };
 
-            // If this was a text texture, release it now (keep white texture)
-            if (rect->texture != ui->white_texture) {
-                SDL_ReleaseGPUTexture (renderer->device, rect->texture);
-                rect->texture = ui->white_texture;
-            }
-        }
+    SDL_GPUDepthStencilTargetInfo depth_target_info = {
+        .texture = renderer->depth_texture,
+        .load_op = SDL_GPU_LOADOP_CLEAR,
+        .store_op = SDL_GPU_STOREOP_STORE,
+        .cycle = false,
+        .clear_depth = 1.0f
+    };
+
+    SDL_GPURenderPass* pass =
+        SDL_BeginGPURenderPass (cmd, &color_target_info, 1, &depth_target_info);
+    SDL_GPUViewport viewport = {
+        0.0f, 0.0f, (float) renderer->width, (float) renderer->height,
+        0.0f, 1.0f
+    };
+    SDL_SetGPUViewport (pass, &viewport);
+
+    SDL_PushGPUVertexUniformData (cmd, 0, &packet->ubo, sizeof (UBOData));
+    SDL_PushGPUFragmentUniformData (cmd, 0, &packet->ubo, sizeof (UBOData));
 
-        ui->rect_count = 0;
+    draw_list_draw_depth (pass);
+    draw_list_draw (pass, renderer->sampler);
+
+    SDL_EndGPURenderPass (pass);
+    // the UI pass drops the depth, so the pyramid is built from it now
+    hiz_build (
+        cmd, renderer->depth_texture, renderer->width, renderer->height,
+        packet->view_proj
+    ); // logging handled in hiz_build()
+    gpu_timer_submit (cmd, "mesh pass");
+    PROFILE_END ();
+
+    // draw queued texts
+    *preui = SDL_GetTicksNS ();
+    PROFILE_BEGIN ("ui pass");
+    if (swapchain != renderer->color_texture) {
+        SDL_GPUBlitInfo blit = {
+            .source = {
+                .texture = renderer->color_texture,
+                .w = renderer->width,
+                .h = renderer->height
+            },
+            .destination = {
+                .texture = swapchain,
+                .w = renderer->width,
+                .h = renderer->height
+            },
+            .load_op = SDL_GPU_LOADOP_DONT_CARE,
+            .filter = SDL_GPU_FILTER_NEAREST
+        };
+        SDL_BlitGPUTexture (ui_cmd, &blit);
+    }
+
+    SDL_GPUColorTargetInfo ui_target_info = {
+        .texture = swapchain,
+        .load_op = SDL_GPU_LOADOP_LOAD,
+        .store_op = SDL_GPU_STOREOP_STORE
+    };
+    SDL_GPUDepthStencilTargetInfo ui_depth_info = {
+        .texture = renderer->depth_texture,
+        .load_op = SDL_GPU_LOADOP_LOAD,
+        .store_op = SDL_GPU_STOREOP_DONT_CARE,
+        .cycle = false
+    };
+    SDL_GPURenderPass* ui_pass =
+        SDL_BeginGPURenderPass (ui_cmd, &ui_target_info, 1, &ui_depth_info);
+    SDL_SetGPUViewport (ui_pass, &viewport);
+    for (Uint32 i = 0; i < ui_pool.count; i++) {
+        UIComponent* ui = &((UIComponent*) ui_pool.data)[i];
+        if (ui->rect_count == 0) continue;
+        ui_draw (renderer, ui_pass, ui);
     }
+    SDL_EndGPURenderPass (ui_pass);
+    PROFILE_END ();
     *postrender = SDL_GetTicksNS ();
 
-    SDL_EndGPURenderPass (pass);
-    SDL_SubmitGPUCommandBuffer (cmd);
+    PROFILE_BEGIN ("submit");
+    gpu_timer_submit (ui_cmd, "ui pass");
+    PROFILE_END ();
     return SDL_APP_CONTINUE;
 }
 
+SDL_AppResult render_system (
+    gpu_renderer* renderer,
+    Entity cam,
+    Uint64* prerender,
+    Uint64* preui,
+    Uint64* postrender
+) {
+    PROFILE_ZONE ("render_system");
+    *prerender = SDL_GetTicksNS ();
+
+    if (frame_thread && packet_ahead) {
+        // build this frame on the frame thread while the last one is submitted
+        build_renderer = renderer;
+        build_cam = cam;
+        build_width = renderer->width;
+        build_height = renderer->height;
+        SDL_SignalSemaphore (build_start);
+        SDL_AppResult result = submit_packet (renderer, preui, postrender);
+        PROFILE_BEGIN ("wait for frame thread");
+        SDL_WaitSemaphore (build_done);
+        PROFILE_END ();
+        swap_packets ();
+        // removed before this call, so only in the packet just submitted
+        release_retired ();
+        return result;
+    }
+
+    if (frame_thread) sync_builds++;
+    build_packet (renderer, cam, renderer->width, renderer->height);
+    swap_packets ();
+    // when pipelining, this frame is submitted again while the next is built,
+    // which is where the one call of lag comes from
+    packet_ahead = frame_thread != NULL;
+    return submit_packet (renderer, preui, postrender);
+}
+
+static Uint64 pool_memory (const GenericPool* pool, Uint64 component_size) {
+    return (Uint64) pool->data_capacity * (component_size + sizeof (Uint32)) +
+           (Uint64) pool->entity_capacity * sizeof (Uint32);
+}
+
+Uint64 ecs_memory_usage (void) {
+    return pool_memory (&transform_pool, sizeof (TransformComponent)) +
+           pool_memory (&mesh_pool, sizeof (MeshComponent)) +
+           pool_memory (&material_pool, sizeof (MaterialComponent)) +
+           pool_memory (&camera_pool, sizeof (CameraComponent)) +
+           pool_memory (
+               &fps_controller_pool, sizeof (FpsCameraControllerComponent)
+           ) +
+           pool_memory (&billboard_pool, 0) +
+           pool_memory (&ambient_light_pool, sizeof (AmbientLightComponent)) +
+           pool_memory (&point_light_pool, sizeof (PointLightComponent)) +
+           pool_memory (&ui_pool, sizeof (UIComponent));
+}
+
 void free_pools (SDL_GPUDevice* device) {
+    PROFILE_ZONE ("free_pools");
+    // the whole world goes, so the packet ahead is dropped rather than kept
+    // drawing it
+    render_pipeline_invalidate ();
     // Destroy all entities to release resources (e.g., GPU buffers)
     for (Uint32 i = 0; i < next_entity_id; i++) {
         destroy_entity (device, i);
@@ -748,4 +1232,31 @@ void free_pools (SDL_GPUDevice* device) {
     free (point_light_pool.data);
     free (point_light_pool.entity_to_index);
     free (point_light_pool.index_to_entity);
+
+    free (ui_pool.data);
+    free (ui_pool.entity_to_index);
+    free (ui_pool.index_to_entity);
+
+    // leave the ECS empty and reusable
+    transform_pool = (GenericPool) {0};
+    mesh_pool = (GenericPool) {0};
+    material_pool = (GenericPool) {0};
+    camera_pool = (GenericPool) {0};
+    fps_controller_pool = (GenericPool) {0};
+    billboard_pool = (GenericPool) {0};
+    ambient_light_pool = (GenericPool) {0};
+    point_light_pool = (GenericPool) {0};
+    ui_pool = (GenericPool) {0};
+    next_entity_id = 0;
+
+    free (build_chunk_counts);
+    build_chunk_counts = NULL;
+    build_chunk_capacity = 0;
+
+    free (retired_meshes);
+    free (retired_materials);
+    retired_meshes = NULL;
+    retired_materials = NULL;
+    retired_mesh_capacity = 0;
+    retired_material_capacity = 0;
 }
\ No newline at end of file
@@ -1,9 +1,11 @@
 #include <ecs/ecs.h>
 #include <geometry/box.h>
 #include <geometry/g_common.h>
+#include <profiler/profiler.h>
 
 MeshComponent
 create_box_mesh (float l, float w, float h, SDL_GPUDevice* device) {
+    PROFILE_ZONE ("create_box_mesh");
     MeshComponent out_mesh = {0};
 
     float wx = w / 2.0f;
@@ -58,25 +60,24 @@ create_box_mesh (float l, float w, float h, SDL_GPUDevice* device) {
         20, 23, 22, 22, 21, 20
     };
 
-    compute_vertex_normals (vertices, 24, indices, 36, 8, 0, 3);
+    compute_vertex_normals (
+        vertices, 24, indices, SDL_GPU_INDEXELEMENTSIZE_16BIT, 36, 8, 0, 3,
+        NORMAL_WEIGHT_FACE
+    );
 
-    SDL_GPUBuffer* vbo = NULL;
-    Uint64 vertices_size = sizeof (vertices);
-    int vbo_failed = upload_vertices (device, vertices, vertices_size, &vbo);
-    if (vbo_failed)
-        return (MeshComponent) {0}; // logging handled in upload_vertices()
+    int vbo_failed = upload_mesh_vertices (device, vertices, 24, &out_mesh);
+    if (vbo_failed) {
+        // logging handled in upload_mesh_vertices()
+        return (MeshComponent) {0};
+    }
 
-    SDL_GPUBuffer* ibo = NULL;
     Uint64 indices_size = sizeof (indices);
-    int ibo_failed = upload_indices (device, indices, indices_size, &ibo);
+    int ibo_failed = upload_indices (device, indices, indices_size, &out_mesh);
     if (ibo_failed) {
-        SDL_ReleaseGPUBuffer (device, vbo);
+        release_mesh_buffers (device, &out_mesh);
         return (MeshComponent) {0}; // logging handled in upload_indices()
     }
 
-    out_mesh.vertex_buffer = vbo;
-    out_mesh.num_vertices = 24;
-    out_mesh.index_buffer = ibo;
     out_mesh.num_indices = 36;
     out_mesh.index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
 
@@ -2,7 +2,9 @@
 #include <stdlib.h>
 
 #include <ecs/ecs.h>
+#include <geometry/g_common.h>
 #include <geometry/lathe.h>
+#include <profiler/profiler.h>
 
 MeshComponent create_capsule_mesh (
     float radius,
@@ -11,6 +13,7 @@ MeshComponent create_capsule_mesh (
     int radial_segments,
     SDL_GPUDevice* device
 ) {
+    PROFILE_ZONE ("create_capsule_mesh");
     MeshComponent out_mesh = {0};
     if (cap_segments < 1) cap_segments = 1;
 
@@ -49,4 +52,29 @@ MeshComponent create_capsule_mesh (
     );
     free (points);
     return out_mesh;
+}
+
+MeshComponent create_capsule_mesh_lods (
+    float radius,
+    float height,
+    int cap_segments,
+    int radial_segments,
+    int lod_count,
+    SDL_GPUDevice* device
+) {
+    MeshComponent mesh = create_capsule_mesh (
+        radius, height, cap_segments, radial_segments, device
+    );
+    for (int i = 0; i < lod_count && mesh.vertex_buffer; i++) {
+        if (cap_segments <= 1 && radial_segments <= 3) break;
+        cap_segments = SDL_max (cap_segments / 2, 1);
+        radial_segments = SDL_max (radial_segments / 2, 3);
+
+        MeshComponent lod = create_capsule_mesh (
+            radius, height, cap_segments, radial_segments, device
+        );
+        if (add_mesh_lod (device, &mesh, lod))
+            break; // logging handled in the generator or add_mesh_lod()
+    }
+    return mesh;
 }
\ No newline at end of file
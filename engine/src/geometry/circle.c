@@ -3,9 +3,11 @@
 
 #include <geometry/circle.h>
 #include <geometry/g_common.h>
+#include <profiler/profiler.h>
 
 MeshComponent
 create_circle_mesh (float radius, int segments, SDL_GPUDevice* device) {
+    PROFILE_ZONE ("create_circle_mesh");
     MeshComponent null_mesh = (MeshComponent) {0};
     if (segments < 3) {
         SDL_Log ("Circle must have at least 3 segments");
@@ -14,13 +16,8 @@ create_circle_mesh (float radius, int segments, SDL_GPUDevice* device) {
 
     int num_vertices = segments + 1; // Center + ring
     int num_indices = segments * 3;  // One triangle per segment
-
-    // Check for Uint16 overflow (max 65535 verts); extend to Uint32 if needed
-    // later
-    if (num_vertices > 65535) {
-        SDL_Log ("Circle mesh too large for Uint16 indices");
-        return null_mesh;
-    }
+    SDL_GPUIndexElementSize index_size =
+        choose_index_size ((Uint32) num_vertices);
 
     float* vertices = (float*) malloc (
         num_vertices * 8 * sizeof (float)
@@ -30,7 +27,7 @@ create_circle_mesh (float radius, int segments, SDL_GPUDevice* device) {
         return null_mesh;
     }
 
-    Uint16* indices = (Uint16*) malloc (num_indices * sizeof (Uint16));
+    void* indices = alloc_indices ((Uint32) num_indices, index_size);
     if (!indices) {
         SDL_Log ("Failed to allocate indices for circle mesh");
         free (vertices);
@@ -69,37 +66,40 @@ create_circle_mesh (float radius, int segments, SDL_GPUDevice* device) {
     // Indices (clockwise winding for consistency with other geometries)
     int index_idx = 0;
     for (int i = 0; i < segments; i++) {
-        indices[index_idx++] = 0;                // Center
-        indices[index_idx++] = (Uint16) (i + 1); // Current ring vertex
-        indices[index_idx++] =
-            (Uint16) ((i + 1) % segments + 1); // Next ring vertex (wrap around)
+        Uint32 current = (Uint32) (i + 1);               // Current ring vertex
+        Uint32 next = (Uint32) ((i + 1) % segments + 1); // Next (wrap around)
+        set_index (indices, index_size, index_idx++, 0); // Center
+        set_index (indices, index_size, index_idx++, current);
+        set_index (indices, index_size, index_idx++, next);
     }
 
+    // on failure the buffers keep generation order; logging handled inside
+    optimize_mesh (
+        vertices, (Uint32) num_vertices, 8, indices, index_size,
+        (Uint32) num_indices
+    );
+
     // Upload to GPU
-    SDL_GPUBuffer* vbo = NULL;
-    Uint64 vertices_size = num_vertices * 8 * sizeof (float);
-    int vbo_failed = upload_vertices (device, vertices, vertices_size, &vbo);
+    MeshComponent out_mesh = {0};
+    int vbo_failed = upload_mesh_vertices (
+        device, vertices, (Uint32) num_vertices, &out_mesh
+    );
     free (vertices);
     if (vbo_failed) {
         free (indices);
-        return null_mesh; // Logging handled in upload_vertices
+        return null_mesh; // Logging handled in upload_mesh_vertices
     }
 
-    SDL_GPUBuffer* ibo = NULL;
-    Uint64 indices_size = num_indices * sizeof (Uint16);
-    int ibo_failed = upload_indices (device, indices, indices_size, &ibo);
+    Uint64 indices_size = num_indices * index_size_bytes (index_size);
+    int ibo_failed = upload_indices (device, indices, indices_size, &out_mesh);
     free (indices);
     if (ibo_failed) {
-        SDL_ReleaseGPUBuffer (device, vbo);
+        release_mesh_buffers (device, &out_mesh);
         return null_mesh; // Logging handled in upload_indices
     }
 
-    MeshComponent out_mesh =
-        (MeshComponent) {.vertex_buffer = vbo,
-                         .num_vertices = (Uint32) num_vertices,
-                         .index_buffer = ibo,
-                         .num_indices = (Uint32) num_indices,
-                         .index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT};
+    out_mesh.num_indices = (Uint32) num_indices;
+    out_mesh.index_size = index_size;
 
     return out_mesh;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <geometry/cone.h>
 #include <geometry/cylinder.h>
+#include <profiler/profiler.h>
 
 MeshComponent create_cone_mesh (
     float radius,
@@ -11,6 +12,7 @@ MeshComponent create_cone_mesh (
     float theta_length,
     SDL_GPUDevice* device
 ) {
+    PROFILE_ZONE ("create_cone_mesh");
     // cylinder returns normals
     return create_cylinder_mesh (
         0.0f, radius, height, radial_segments, height_segments, open_ended,
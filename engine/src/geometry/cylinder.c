@@ -1,7 +1,9 @@
 #include <stdlib.h>
 
+#include <geometry/g_common.h>
 #include <geometry/cylinder.h>
 #include <geometry/lathe.h>
+#include <profiler/profiler.h>
 
 MeshComponent create_cylinder_mesh (
     float radius_top,
@@ -14,6 +16,7 @@ MeshComponent create_cylinder_mesh (
     float theta_length,
     SDL_GPUDevice* device
 ) {
+    PROFILE_ZONE ("create_cylinder_mesh");
     MeshComponent out_mesh = {0};
     if (radial_segments < 3 || height_segments < 1) {
         SDL_Log (
@@ -64,4 +67,35 @@ MeshComponent create_cylinder_mesh (
     );
     free (points);
     return out_mesh;
+}
+
+MeshComponent create_cylinder_mesh_lods (
+    float radius_top,
+    float radius_bottom,
+    float height,
+    int radial_segments,
+    int height_segments,
+    bool open_ended,
+    float theta_start,
+    float theta_length,
+    int lod_count,
+    SDL_GPUDevice* device
+) {
+    MeshComponent mesh = create_cylinder_mesh (
+        radius_top, radius_bottom, height, radial_segments, height_segments,
+        open_ended, theta_start, theta_length, device
+    );
+    for (int i = 0; i < lod_count && mesh.vertex_buffer; i++) {
+        if (radial_segments <= 3 && height_segments <= 1) break;
+        radial_segments = SDL_max (radial_segments / 2, 3);
+        height_segments = SDL_max (height_segments / 2, 1);
+
+        MeshComponent lod = create_cylinder_mesh (
+            radius_top, radius_bottom, height, radial_segments,
+            height_segments, open_ended, theta_start, theta_length, device
+        );
+        if (add_mesh_lod (device, &mesh, lod))
+            break; // logging handled in the generator or add_mesh_lod()
+    }
+    return mesh;
 }
\ No newline at end of file
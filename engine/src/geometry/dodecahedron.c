@@ -5,8 +5,10 @@
 #include <geometry/dodecahedron.h>
 #include <geometry/g_common.h>
 #include <math/matrix.h>
+#include <profiler/profiler.h>
 
 MeshComponent create_dodecahedron_mesh (float radius, SDL_GPUDevice* device) {
+    PROFILE_ZONE ("create_dodecahedron_mesh");
     float phi = (1.0f + sqrtf (5.0f)) / 2.0f;
     float phi_inv = 1.0f / phi;
 
@@ -65,29 +67,26 @@ MeshComponent create_dodecahedron_mesh (float radius, SDL_GPUDevice* device) {
 
     // Compute normals
     compute_vertex_normals (
-        vertices, num_vertices, indices, num_indices, 8, 0, 3
+        vertices, num_vertices, indices, SDL_GPU_INDEXELEMENTSIZE_16BIT,
+        num_indices, 8, 0, 3, NORMAL_WEIGHT_FACE
     );
 
-    SDL_GPUBuffer* vbo = NULL;
-    Uint64 vertices_size = num_vertices * 8 * sizeof (float);
-    int vbo_failed = upload_vertices (device, vertices, vertices_size, &vbo);
+    MeshComponent out_mesh = {0};
+    int vbo_failed = upload_mesh_vertices (
+        device, vertices, (Uint32) num_vertices, &out_mesh
+    );
     free (vertices);
     if (vbo_failed) return (MeshComponent) {0};
 
-    SDL_GPUBuffer* ibo = NULL;
     Uint64 indices_size = num_indices * sizeof (Uint16);
-    int ibo_failed = upload_indices (device, indices, indices_size, &ibo);
+    int ibo_failed = upload_indices (device, indices, indices_size, &out_mesh);
     if (ibo_failed) {
-        SDL_ReleaseGPUBuffer (device, vbo);
+        release_mesh_buffers (device, &out_mesh);
         return (MeshComponent) {0};
     }
 
-    MeshComponent out_mesh =
-        (MeshComponent) {.vertex_buffer = vbo,
-                         .num_vertices = (Uint32) num_vertices,
-                         .index_buffer = ibo,
-                         .num_indices = (Uint32) num_indices,
-                         .index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT};
+    out_mesh.num_indices = (Uint32) num_indices;
+    out_mesh.index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
 
     return out_mesh;
 }
\ No newline at end of file
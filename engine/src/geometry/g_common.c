@@ -1,37 +1,51 @@
+#include <float.h>
+#include <math.h>
 #include <stdlib.h>
 
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_gpu.h>
 
 #include <geometry/g_common.h>
+#include <gpu/buffer_heap.h>
+#include <jobs/jobs.h>
 #include <math/matrix.h>
+#include <profiler/profiler.h>
+
+#define NORMALS_MIN_BATCH 4096 // triangles or vertices per job batch
 
 // Returns 0 on success, 1 on failure
-int upload_vertices (
+// copies size bytes to a new range of the heap, filling in buffer and offset
+static int upload_range (
     SDL_GPUDevice* device,
-    const void* vertices,
-    Uint64 vertices_size,
-    SDL_GPUBuffer** vbo_out
+    BufferHeapKind kind,
+    const void* src,
+    Uint64 size,
+    SDL_GPUBuffer** buffer,
+    Uint32* offset
 ) {
-    SDL_GPUBufferCreateInfo vbo_info = {
-        .size = (Uint32) vertices_size,
-        .usage = SDL_GPU_BUFFERUSAGE_VERTEX
-    };
-    SDL_GPUBuffer* vbo = SDL_CreateGPUBuffer (device, &vbo_info);
-    if (!vbo) {
-        SDL_Log ("Failed to create vertex buffer: %s", SDL_GetError ());
-        return 1;
-    }
+    if (buffer_heap_alloc (device, kind, (Uint32) size, buffer, offset))
+        return 1; // logging handled in buffer_heap_alloc()
 
     SDL_GPUTransferBufferCreateInfo trans_info = {
-        .size = (Uint32) vertices_size,
+        .size = (Uint32) size,
         .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
     };
     SDL_GPUTransferBuffer* trans_buf =
         SDL_CreateGPUTransferBuffer (device, &trans_info);
     if (!trans_buf) {
         SDL_Log ("Failed to create transfer buffer: %s", SDL_GetError ());
-        SDL_ReleaseGPUBuffer (device, vbo);
+        buffer_heap_free (device, kind, *buffer, *offset);
         return 1;
     }
 
@@ -39,17 +53,17 @@ int upload_vertices (
     if (!data) {
         SDL_Log ("Failed to map transfer buffer: %s", SDL_GetError ());
         SDL_ReleaseGPUTransferBuffer (device, trans_buf);
-        SDL_ReleaseGPUBuffer (device, vbo);
+        buffer_heap_free (device, kind, *buffer, *offset);
         return 1;
     }
-    memcpy (data, vertices, vertices_size);
+    memcpy (data, src, size);
     SDL_UnmapGPUTransferBuffer (device, trans_buf);
 
     SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (device);
     if (!cmd) {
         SDL_Log ("Failed to acquire command buffer: %s", SDL_GetError ());
         SDL_ReleaseGPUTransferBuffer (device, trans_buf);
-        SDL_ReleaseGPUBuffer (device, vbo);
+        buffer_heap_free (device, kind, *buffer, *offset);
         return 1;
     }
 
@@ -58,7 +72,7 @@ int upload_vertices (
         SDL_Log ("Failed to begin copy pass: %s", SDL_GetError ());
         SDL_SubmitGPUCommandBuffer (cmd);
         SDL_ReleaseGPUTransferBuffer (device, trans_buf);
-        SDL_ReleaseGPUBuffer (device, vbo);
+        buffer_heap_free (device, kind, *buffer, *offset);
         return 1;
     }
 
@@ -67,140 +81,860 @@ int upload_vertices (
         .offset = 0
     };
     SDL_GPUBufferRegion dst_reg =
-        {.buffer = vbo, .offset = 0, .size = (Uint32) vertices_size};
+        {.buffer = *buffer, .offset = *offset, .size = (Uint32) size};
+    // never cycle: other meshes live in the same buffer
     SDL_UploadToGPUBuffer (copy_pass, &src_loc, &dst_reg, false);
     SDL_EndGPUCopyPass (copy_pass);
     SDL_SubmitGPUCommandBuffer (cmd);
 
     SDL_ReleaseGPUTransferBuffer (device, trans_buf);
-    *vbo_out = vbo;
     return 0;
 }
 
+// Returns 0 on success, 1 on failure
+int upload_vertices (
+    SDL_GPUDevice* device,
+    const void* vertices,
+    Uint64 vertices_size,
+    MeshComponent* mesh
+) {
+    PROFILE_ZONE ("upload_vertices");
+    return upload_range (
+        device, BUFFER_HEAP_VERTEX, vertices, vertices_size,
+        &mesh->vertex_buffer, &mesh->vertex_offset
+    ); // logging handled in upload_range()
+}
+
 // Returns 0 on success, 1 on failure
 int upload_indices (
     SDL_GPUDevice* device,
     const void* indices,
     Uint64 indices_size,
-    SDL_GPUBuffer** ibo_out
+    MeshComponent* mesh
 ) {
-    SDL_GPUBufferCreateInfo ibo_info = {
-        .size = (Uint32) indices_size,
-        .usage = SDL_GPU_BUFFERUSAGE_INDEX
-    };
-    SDL_GPUBuffer* ibo = SDL_CreateGPUBuffer (device, &ibo_info);
-    if (!ibo) {
-        SDL_Log ("Failed to create index buffer: %s", SDL_GetError ());
+    PROFILE_ZONE ("upload_indices");
+    return upload_range (
+        device, BUFFER_HEAP_INDEX, indices, indices_size, &mesh->index_buffer,
+        &mesh->index_offset
+    ); // logging handled in upload_range()
+}
+
+void release_mesh_buffers (SDL_GPUDevice* device, MeshComponent* mesh) {
+    if (mesh->vertex_buffer)
+        buffer_heap_free (
+            device, BUFFER_HEAP_VERTEX, mesh->vertex_buffer,
+            mesh->vertex_offset
+        );
+    if (mesh->index_buffer)
+        buffer_heap_free (
+            device, BUFFER_HEAP_INDEX, mesh->index_buffer, mesh->index_offset
+        );
+    mesh->vertex_buffer = NULL;
+    mesh->index_buffer = NULL;
+}
+
+// Returns 0 on success, 1 on failure
+int share_mesh (MeshComponent* mesh, MeshComponent* out) {
+    if (!mesh->refs) {
+        mesh->refs = (Uint32*) malloc (sizeof (Uint32));
+        if (!mesh->refs) {
+            SDL_Log ("Failed to share mesh");
+            return 1;
+        }
+        *mesh->refs = 1;
+    }
+    (*mesh->refs)++;
+    *out = *mesh;
+    return 0;
+}
+
+void release_mesh (SDL_GPUDevice* device, MeshComponent* mesh) {
+    if (mesh->refs && --*mesh->refs > 0) {
+        *mesh = (MeshComponent) {0};
+        return;
+    }
+    free (mesh->refs);
+    release_mesh_buffers (device, mesh);
+    for (Uint32 i = 0; i < mesh->lod_count; i++)
+        release_mesh_buffers (device, &mesh->lods[i]);
+    free (mesh->lods);
+    *mesh = (MeshComponent) {0};
+}
+
+Uint32 vertex_stride (VertexLayout layout) {
+    if (layout == VERTEX_LAYOUT_COMPACT) return sizeof (CompactVertex);
+    if (layout == VERTEX_LAYOUT_SEPARATE) return 3 * sizeof (float);
+    return 8 * sizeof (float);
+}
+
+// Returns the number of vertex buffers layout reads from and fills in their
+// descriptions and the attributes
+Uint32 get_vertex_layout (
+    VertexLayout layout,
+    SDL_GPUVertexAttribute attributes[VERTEX_ATTRIBUTE_COUNT],
+    SDL_GPUVertexBufferDescription buffers[VERTEX_ATTRIBUTE_COUNT]
+) {
+    for (Uint32 i = 0; i < VERTEX_ATTRIBUTE_COUNT; i++) {
+        attributes[i] = (SDL_GPUVertexAttribute) {.location = i};
+        buffers[i] = (SDL_GPUVertexBufferDescription) {
+            .slot = i,
+            .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX
+        };
+    }
+
+    if (layout == VERTEX_LAYOUT_COMPACT) {
+        attributes[0].format = SDL_GPU_VERTEXELEMENTFORMAT_SHORT4_NORM;
+        attributes[0].offset = offsetof (CompactVertex, position);
+        attributes[1].format = SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM;
+        attributes[1].offset = offsetof (CompactVertex, normal);
+        attributes[2].format = SDL_GPU_VERTEXELEMENTFORMAT_HALF2;
+        attributes[2].offset = offsetof (CompactVertex, uv);
+        buffers[0].pitch = sizeof (CompactVertex);
         return 1;
     }
 
-    SDL_GPUTransferBufferCreateInfo trans_info = {
-        .size = (Uint32) indices_size,
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
+    attributes[0].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3; // pos
+    attributes[1].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3; // normals
+    attributes[2].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2; // texcoord
+
+    if (layout == VERTEX_LAYOUT_SEPARATE) {
+        // one tightly packed stream per attribute
+        for (Uint32 i = 0; i < VERTEX_ATTRIBUTE_COUNT; i++)
+            attributes[i].buffer_slot = i;
+        buffers[0].pitch = 3 * sizeof (float);
+        buffers[1].pitch = 3 * sizeof (float);
+        buffers[2].pitch = 2 * sizeof (float);
+        return VERTEX_ATTRIBUTE_COUNT;
+    }
+
+    attributes[0].offset = 0;
+    attributes[1].offset = 3 * sizeof (float);
+    attributes[2].offset = 6 * sizeof (float);
+    buffers[0].pitch = 8 * sizeof (float);
+    return 1;
+}
+
+void get_object_layout (
+    Uint32 slot,
+    SDL_GPUVertexAttribute attributes[OBJECT_ATTRIBUTE_COUNT],
+    SDL_GPUVertexBufferDescription* buffer
+) {
+    static const Uint32 offsets[OBJECT_ATTRIBUTE_COUNT] = {
+        offsetof (ObjectData, model), offsetof (ObjectData, model) + 16,
+        offsetof (ObjectData, model) + 32, offsetof (ObjectData, model) + 48,
+        offsetof (ObjectData, color), offsetof (ObjectData, pos_scale),
+        offsetof (ObjectData, pos_offset)
     };
-    SDL_GPUTransferBuffer* trans_buf =
-        SDL_CreateGPUTransferBuffer (device, &trans_info);
-    if (!trans_buf) {
-        SDL_Log ("Failed to create transfer buffer: %s", SDL_GetError ());
-        SDL_ReleaseGPUBuffer (device, ibo);
-        return 1;
+    for (Uint32 i = 0; i < OBJECT_ATTRIBUTE_COUNT; i++) {
+        attributes[i] = (SDL_GPUVertexAttribute) {
+            .location = VERTEX_ATTRIBUTE_COUNT + i,
+            .buffer_slot = slot,
+            .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4,
+            .offset = offsets[i]
+        };
     }
+    // first_instance picks the draw's record
+    *buffer = (SDL_GPUVertexBufferDescription) {
+        .slot = slot,
+        .pitch = sizeof (ObjectData),
+        .input_rate = SDL_GPU_VERTEXINPUTRATE_INSTANCE
+    };
+}
 
-    void* data = SDL_MapGPUTransferBuffer (device, trans_buf, false);
-    if (!data) {
-        SDL_Log ("Failed to map transfer buffer: %s", SDL_GetError ());
-        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
-        SDL_ReleaseGPUBuffer (device, ibo);
+// Returns 0 on success, 1 on failure (not logged; a missing file is often
+// expected)
+int map_file (const char* path, MappedFile* file) {
+#ifndef _WIN32
+    int fd = open (path, O_RDONLY);
+    if (fd < 0) return 1;
+    struct stat info;
+    if (fstat (fd, &info) || info.st_size <= 0) {
+        close (fd);
         return 1;
     }
-    memcpy (data, indices, indices_size);
-    SDL_UnmapGPUTransferBuffer (device, trans_buf);
+    void* data =
+        mmap (NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close (fd);
+    if (data != MAP_FAILED) {
+        *file = (MappedFile) {
+            .data = (const Uint8*) data,
+            .size = (size_t) info.st_size,
+            .mapped = true
+        };
+        return 0;
+    }
+#endif
+    size_t size = 0;
+    void* data_read = SDL_LoadFile (path, &size);
+    if (!data_read) return 1;
+    *file = (MappedFile) {.data = (const Uint8*) data_read, .size = size};
+    return 0;
+}
 
-    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (device);
-    if (!cmd) {
-        SDL_Log ("Failed to acquire command buffer: %s", SDL_GetError ());
-        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
-        SDL_ReleaseGPUBuffer (device, ibo);
-        return 1;
+void unmap_file (MappedFile* file) {
+#ifndef _WIN32
+    if (file->mapped) {
+        munmap ((void*) file->data, file->size);
+        return;
     }
+#endif
+    SDL_free ((void*) file->data);
+}
 
-    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass (cmd);
-    if (!copy_pass) {
-        SDL_Log ("Failed to begin copy pass: %s", SDL_GetError ());
-        SDL_SubmitGPUCommandBuffer (cmd);
-        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
-        SDL_ReleaseGPUBuffer (device, ibo);
+static VertexLayout mesh_layout = VERTEX_LAYOUT_STANDARD;
+
+void set_mesh_vertex_layout (VertexLayout layout) {
+    mesh_layout = layout;
+}
+
+VertexLayout get_mesh_vertex_layout (void) {
+    return mesh_layout;
+}
+
+static Sint16 quantize_snorm16 (float v) {
+    if (v > 1.0f) v = 1.0f;
+    if (v < -1.0f) v = -1.0f;
+    return (Sint16) lrintf (v * 32767.0f);
+}
+
+// round to nearest; values below the smallest normal half flush to zero
+static Uint16 float_to_half (float f) {
+    Uint32 bits;
+    SDL_memcpy (&bits, &f, sizeof (bits));
+    Uint16 sign = (Uint16) ((bits >> 16) & 0x8000);
+    Uint32 raw_exponent = (bits >> 23) & 0xff;
+    Uint32 mantissa = bits & 0x7fffff;
+
+    if (raw_exponent == 0xff)
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0); // inf or nan
+    Sint32 exponent = (Sint32) raw_exponent - 127 + 15;
+    if (exponent <= 0) return sign;
+    if (exponent >= 31) return sign | 0x7c00;
+
+    Uint16 half = sign | (Uint16) (exponent << 10) | (Uint16) (mantissa >> 13);
+    if (mantissa & 0x1000) half++; // a carry into the exponent is still right
+    return half;
+}
+
+// unit normal to the [-1, 1] square, folding the lower hemisphere over
+static void oct_encode (const float* n, Sint16* out) {
+    float l1 = fabsf (n[0]) + fabsf (n[1]) + fabsf (n[2]);
+    if (l1 <= 0.0f) {
+        out[0] = 0;
+        out[1] = 0;
+        return;
+    }
+    float x = n[0] / l1;
+    float y = n[1] / l1;
+    if (n[2] < 0.0f) {
+        float fx = (1.0f - fabsf (y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float fy = (1.0f - fabsf (x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+    out[0] = quantize_snorm16 (x);
+    out[1] = quantize_snorm16 (y);
+}
+
+// Returns 0 on success, 1 on failure
+// fills in the mesh's layout, vertex count, radius and dequantization; *out
+// is vertices itself for the standard layout and a malloc'd copy otherwise
+static int encode_vertices (
+    const float* vertices,
+    Uint32 num_vertices,
+    MeshComponent* mesh,
+    void** out,
+    Uint64* out_size
+) {
+    float radius_sq = 0.0f;
+    for (Uint32 i = 0; i < num_vertices; i++) {
+        const float* p = &vertices[i * 8];
+        float length_sq = p[0] * p[0] + p[1] * p[1] + p[2] * p[2];
+        if (length_sq > radius_sq) radius_sq = length_sq;
+    }
+    mesh->radius = sqrtf (radius_sq);
+    mesh->num_vertices = num_vertices;
+
+    if (mesh_layout != VERTEX_LAYOUT_COMPACT) {
+        mesh->layout = VERTEX_LAYOUT_STANDARD;
+        mesh->pos_scale = (vec3) {1.0f, 1.0f, 1.0f};
+        mesh->pos_offset = (vec3) {0.0f, 0.0f, 0.0f};
+        *out = (void*) vertices;
+        *out_size = (Uint64) num_vertices * 8 * sizeof (float);
+        return 0;
+    }
+
+    PROFILE_ZONE ("encode_compact_vertices");
+    float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (Uint32 i = 0; i < num_vertices; i++) {
+        for (int k = 0; k < 3; k++) {
+            float p = vertices[i * 8 + k];
+            if (p < lo[k]) lo[k] = p;
+            if (p > hi[k]) hi[k] = p;
+        }
+    }
+
+    // positions are stored relative to the bounds centre in half-extents
+    float scale[3];
+    float offset[3];
+    for (int k = 0; k < 3; k++) {
+        if (num_vertices == 0) lo[k] = hi[k] = 0.0f;
+        offset[k] = 0.5f * (lo[k] + hi[k]);
+        scale[k] = 0.5f * (hi[k] - lo[k]);
+        if (scale[k] < FLT_MIN) scale[k] = 1.0f; // flat along this axis
+    }
+
+    Uint64 packed_size = (Uint64) num_vertices * sizeof (CompactVertex);
+    CompactVertex* packed = (CompactVertex*) malloc (packed_size);
+    if (!packed) {
+        SDL_Log ("Failed to allocate compact vertices");
         return 1;
     }
 
-    SDL_GPUTransferBufferLocation src_loc = {
-        .transfer_buffer = trans_buf,
-        .offset = 0
-    };
-    SDL_GPUBufferRegion dst_reg =
-        {.buffer = ibo, .offset = 0, .size = (Uint32) indices_size};
-    SDL_UploadToGPUBuffer (copy_pass, &src_loc, &dst_reg, false);
-    SDL_EndGPUCopyPass (copy_pass);
-    SDL_SubmitGPUCommandBuffer (cmd);
+    for (Uint32 i = 0; i < num_vertices; i++) {
+        const float* v = &vertices[i * 8];
+        CompactVertex* packed_vertex = &packed[i];
+        for (int k = 0; k < 3; k++)
+            packed_vertex->position[k] =
+                quantize_snorm16 ((v[k] - offset[k]) / scale[k]);
+        packed_vertex->position[3] = 0;
+        oct_encode (&v[3], packed_vertex->normal);
+        packed_vertex->uv[0] = float_to_half (v[6]);
+        packed_vertex->uv[1] = float_to_half (v[7]);
+    }
 
-    SDL_ReleaseGPUTransferBuffer (device, trans_buf);
-    *ibo_out = ibo;
+    mesh->layout = VERTEX_LAYOUT_COMPACT;
+    mesh->pos_scale = (vec3) {scale[0], scale[1], scale[2]};
+    mesh->pos_offset = (vec3) {offset[0], offset[1], offset[2]};
+    *out = packed;
+    *out_size = packed_size;
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+int upload_mesh_vertices (
+    SDL_GPUDevice* device,
+    const float* vertices,
+    Uint32 num_vertices,
+    MeshComponent* mesh
+) {
+    void* encoded = NULL;
+    Uint64 encoded_size = 0;
+    if (encode_vertices (
+            vertices, num_vertices, mesh, &encoded, &encoded_size
+        ))
+        return 1; // logging handled in encode_vertices()
+
+    int vbo_failed = upload_vertices (device, encoded, encoded_size, mesh);
+    if (encoded != vertices) free (encoded);
+    if (vbo_failed) return 1; // logging handled in upload_vertices()
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+int make_mesh_data (
+    float* vertices,
+    Uint32 num_vertices,
+    void* indices,
+    Uint32 num_indices,
+    SDL_GPUIndexElementSize index_size,
+    MeshData* out
+) {
+    *out = (MeshData) {0};
+    void* encoded = NULL;
+    Uint64 encoded_size = 0;
+    if (encode_vertices (
+            vertices, num_vertices, &out->mesh, &encoded, &encoded_size
+        )) {
+        free (vertices);
+        free (indices);
+        return 1; // logging handled in encode_vertices()
+    }
+    if (encoded != vertices) free (vertices);
+
+    out->vertices = encoded;
+    out->vertices_size = encoded_size;
+    out->indices = indices;
+    out->indices_size = (Uint64) num_indices * index_size_bytes (index_size);
+    out->mesh.num_indices = num_indices;
+    out->mesh.index_size = index_size;
+    return 0;
+}
+
+void free_mesh_data (MeshData* data) {
+    free (data->vertices);
+    free (data->indices);
+    *data = (MeshData) {0};
+}
+
+// Returns 0 on success, 1 on failure
+int upload_mesh_data (
+    SDL_GPUDevice* device,
+    const MeshData* data,
+    MeshComponent* out
+) {
+    MeshComponent mesh = data->mesh;
+    if (upload_vertices (device, data->vertices, data->vertices_size, &mesh))
+        return 1; // logging handled in upload_vertices()
+    if (upload_indices (device, data->indices, data->indices_size, &mesh)) {
+        release_mesh_buffers (device, &mesh);
+        return 1; // logging handled in upload_indices()
+    }
+    *out = mesh;
+    return 0;
+}
+
+MeshComponent upload_mesh_levels (
+    SDL_GPUDevice* device,
+    const MeshData* levels,
+    Uint32 level_count
+) {
+    MeshComponent mesh = {0};
+    if (level_count == 0 || upload_mesh_data (device, &levels[0], &mesh))
+        return mesh; // logging handled in upload_mesh_data()
+    for (Uint32 i = 1; i < level_count; i++) {
+        MeshComponent lod = {0};
+        upload_mesh_data (device, &levels[i], &lod); // logging handled inside
+        if (add_mesh_lod (device, &mesh, lod))
+            break; // logging handled in upload_mesh_data() or add_mesh_lod()
+    }
+    return mesh;
+}
+
+// Returns 0 on success, 1 on failure
+int add_mesh_lod (
+    SDL_GPUDevice* device,
+    MeshComponent* mesh,
+    MeshComponent lod
+) {
+    if (!lod.vertex_buffer) return 1; // logging handled by the generator
+    MeshComponent* lods = (MeshComponent*) realloc (
+        mesh->lods, (mesh->lod_count + 1) * sizeof (MeshComponent)
+    );
+    if (!lods) {
+        SDL_Log ("Failed to allocate mesh LOD");
+        release_mesh_buffers (device, &lod);
+        return 1;
+    }
+    lod.lod_count = 0;
+    lod.lods = NULL;
+    lods[mesh->lod_count++] = lod;
+    mesh->lods = lods;
     return 0;
 }
 
+SDL_GPUIndexElementSize choose_index_size (Uint32 num_vertices) {
+    if (num_vertices > 65535) return SDL_GPU_INDEXELEMENTSIZE_32BIT;
+    return SDL_GPU_INDEXELEMENTSIZE_16BIT;
+}
+
+Uint32 index_size_bytes (SDL_GPUIndexElementSize index_size) {
+    if (index_size == SDL_GPU_INDEXELEMENTSIZE_32BIT) return sizeof (Uint32);
+    return sizeof (Uint16);
+}
+
+// Returns NULL on failure
+void* alloc_indices (Uint32 num_indices, SDL_GPUIndexElementSize index_size) {
+    return malloc ((size_t) num_indices * index_size_bytes (index_size));
+}
+
+// one job runs per phase: face normals over triangles, then a gather over
+// vertices that adds the faces around each vertex in triangle order, so the
+// result matches a serial scatter bit for bit
+typedef struct {
+    float* vertices;
+    const void* indices;
+    SDL_GPUIndexElementSize index_size;
+    int stride;
+    int pos_offset;
+    int norm_offset;
+    NormalWeighting weighting;
+    vec3* face_normals;
+    float* corner_weights; // per index, angle weighting only
+    const Uint32* offsets; // vertex -> first entry in corners
+    const Uint32* corners; // index positions referencing each vertex
+} NormalJob;
+
+static vec3 job_position (const NormalJob* job, Uint32 corner) {
+    Uint32 v = get_index (job->indices, job->index_size, corner);
+    const float* p = &job->vertices[(size_t) v * job->stride + job->pos_offset];
+    return (vec3) {p[0], p[1], p[2]};
+}
+
+// angle between the edges leaving a towards b and c
+static float corner_angle (vec3 a, vec3 b, vec3 c) {
+    vec3 ab = vec3_normalize (vec3_sub (b, a));
+    vec3 ac = vec3_normalize (vec3_sub (c, a));
+    float cosine = vec3_dot (ab, ac);
+    if (cosine > 1.0f) cosine = 1.0f;
+    if (cosine < -1.0f) cosine = -1.0f;
+    return acosf (cosine);
+}
+
+#ifdef __SSE__
+// four triangles at once with the same operations, in the same order, as
+// vec3_normalize (vec3_cross (b - a, c - a))
+static void face_normals_x4 (NormalJob* job, Uint32 t) {
+    float p[9][4];
+    for (int k = 0; k < 4; k++) {
+        for (int corner = 0; corner < 3; corner++) {
+            vec3 v = job_position (job, (t + k) * 3 + corner);
+            p[corner * 3][k] = v.x;
+            p[corner * 3 + 1][k] = v.y;
+            p[corner * 3 + 2][k] = v.z;
+        }
+    }
+    __m128 ax = _mm_loadu_ps (p[0]), ay = _mm_loadu_ps (p[1]);
+    __m128 az = _mm_loadu_ps (p[2]);
+    __m128 abx = _mm_sub_ps (_mm_loadu_ps (p[3]), ax);
+    __m128 aby = _mm_sub_ps (_mm_loadu_ps (p[4]), ay);
+    __m128 abz = _mm_sub_ps (_mm_loadu_ps (p[5]), az);
+    __m128 acx = _mm_sub_ps (_mm_loadu_ps (p[6]), ax);
+    __m128 acy = _mm_sub_ps (_mm_loadu_ps (p[7]), ay);
+    __m128 acz = _mm_sub_ps (_mm_loadu_ps (p[8]), az);
+
+    __m128 nx = _mm_sub_ps (_mm_mul_ps (aby, acz), _mm_mul_ps (abz, acy));
+    __m128 ny = _mm_sub_ps (_mm_mul_ps (abz, acx), _mm_mul_ps (abx, acz));
+    __m128 nz = _mm_sub_ps (_mm_mul_ps (abx, acy), _mm_mul_ps (aby, acx));
+    __m128 len_sq = _mm_add_ps (
+        _mm_add_ps (_mm_mul_ps (nx, nx), _mm_mul_ps (ny, ny)),
+        _mm_mul_ps (nz, nz)
+    );
+    __m128 len = _mm_sqrt_ps (len_sq);
+    __m128 inv = _mm_div_ps (_mm_set1_ps (1.0f), len);
+    __m128 mask = _mm_cmpgt_ps (len, _mm_setzero_ps ());
+    // degenerate triangles keep their raw cross product, like vec3_normalize
+    nx = _mm_or_ps (
+        _mm_and_ps (mask, _mm_mul_ps (nx, inv)), _mm_andnot_ps (mask, nx)
+    );
+    ny = _mm_or_ps (
+        _mm_and_ps (mask, _mm_mul_ps (ny, inv)), _mm_andnot_ps (mask, ny)
+    );
+    nz = _mm_or_ps (
+        _mm_and_ps (mask, _mm_mul_ps (nz, inv)), _mm_andnot_ps (mask, nz)
+    );
+
+    float out[3][4];
+    _mm_storeu_ps (out[0], nx);
+    _mm_storeu_ps (out[1], ny);
+    _mm_storeu_ps (out[2], nz);
+    for (int k = 0; k < 4; k++)
+        job->face_normals[t + k] = (vec3) {out[0][k], out[1][k], out[2][k]};
+}
+#endif
+
+static void face_normals_job (void* data, Uint32 start, Uint32 end) {
+    PROFILE_ZONE ("face_normals_job");
+    NormalJob* job = (NormalJob*) data;
+    Uint32 t = start;
+#ifdef __SSE__
+    for (; t + 4 <= end; t += 4) face_normals_x4 (job, t);
+#endif
+    for (; t < end; t++) {
+        vec3 a = job_position (job, t * 3);
+        vec3 b = job_position (job, t * 3 + 1);
+        vec3 c = job_position (job, t * 3 + 2);
+        job->face_normals[t] =
+            vec3_normalize (vec3_cross (vec3_sub (b, a), vec3_sub (c, a)));
+    }
+
+    if (job->weighting != NORMAL_WEIGHT_ANGLE) return;
+    for (t = start; t < end; t++) {
+        vec3 a = job_position (job, t * 3);
+        vec3 b = job_position (job, t * 3 + 1);
+        vec3 c = job_position (job, t * 3 + 2);
+        job->corner_weights[t * 3] = corner_angle (a, b, c);
+        job->corner_weights[t * 3 + 1] = corner_angle (b, c, a);
+        job->corner_weights[t * 3 + 2] = corner_angle (c, a, b);
+    }
+}
+
+static void vertex_normals_job (void* data, Uint32 start, Uint32 end) {
+    PROFILE_ZONE ("vertex_normals_job");
+    NormalJob* job = (NormalJob*) data;
+    for (Uint32 v = start; v < end; v++) {
+        vec3 sum = {0.0f, 0.0f, 0.0f};
+        for (Uint32 c = job->offsets[v]; c < job->offsets[v + 1]; c++) {
+            Uint32 corner = job->corners[c];
+            vec3 face_norm = job->face_normals[corner / 3];
+            if (job->weighting == NORMAL_WEIGHT_ANGLE)
+                face_norm = vec3_scale (face_norm, job->corner_weights[corner]);
+            sum = vec3_add (sum, face_norm);
+        }
+
+        vec3 norm = vec3_normalize (sum);
+        float* n = &job->vertices[(size_t) v * job->stride + job->norm_offset];
+        n[0] = norm.x;
+        n[1] = norm.y;
+        n[2] = norm.z;
+    }
+}
+
 void compute_vertex_normals (
     float* vertices,
     int num_vertices,
-    const Uint16* indices,
+    const void* indices,
+    SDL_GPUIndexElementSize index_size,
     int num_indices,
     int stride,
     int pos_offset,
-    int norm_offset
+    int norm_offset,
+    NormalWeighting weighting
 ) {
-    // Accumulate normals per vertex
-    vec3* accum_norms = (vec3*) calloc (num_vertices, sizeof (vec3));
-    if (!accum_norms) {
-        SDL_Log ("Failed to allocate accum_norms for normals computation");
-        return;
+    PROFILE_ZONE ("compute_vertex_normals");
+    if (num_vertices <= 0) return;
+    Uint32 num_triangles = num_indices > 0 ? (Uint32) num_indices / 3 : 0;
+    Uint32 num_corners = num_triangles * 3;
+
+    NormalJob job = {
+        .vertices = vertices,
+        .indices = indices,
+        .index_size = index_size,
+        .stride = stride,
+        .pos_offset = pos_offset,
+        .norm_offset = norm_offset,
+        .weighting = weighting
+    };
+    Uint32* offsets = (Uint32*) calloc (num_vertices + 1, sizeof (Uint32));
+    Uint32* corners = (Uint32*) malloc ((num_corners + 1) * sizeof (Uint32));
+    job.face_normals = (vec3*) malloc ((num_triangles + 1) * sizeof (vec3));
+    if (weighting == NORMAL_WEIGHT_ANGLE)
+        job.corner_weights =
+            (float*) malloc ((num_corners + 1) * sizeof (float));
+    if (!offsets || !corners || !job.face_normals ||
+        (weighting == NORMAL_WEIGHT_ANGLE && !job.corner_weights)) {
+        SDL_Log ("Failed to allocate buffers for normals computation");
+        goto cleanup;
     }
 
-    for (int i = 0; i < num_indices; i += 3) {
-        int ia = indices[i];
-        int ib = indices[i + 1];
-        int ic = indices[i + 2];
+    jobs_parallel_for (
+        num_triangles, NORMALS_MIN_BATCH, face_normals_job, &job
+    );
 
-        vec3 a = {
-            vertices[ia * stride + pos_offset],
-            vertices[ia * stride + pos_offset + 1],
-            vertices[ia * stride + pos_offset + 2]
-        };
-        vec3 b = {
-            vertices[ib * stride + pos_offset],
-            vertices[ib * stride + pos_offset + 1],
-            vertices[ib * stride + pos_offset + 2]
-        };
-        vec3 c = {
-            vertices[ic * stride + pos_offset],
-            vertices[ic * stride + pos_offset + 1],
-            vertices[ic * stride + pos_offset + 2]
-        };
+    // vertex -> corner lists, in index order
+    for (Uint32 c = 0; c < num_corners; c++)
+        offsets[get_index (indices, index_size, c) + 1]++;
+    for (int v = 0; v < num_vertices; v++) offsets[v + 1] += offsets[v];
+    for (Uint32 c = 0; c < num_corners; c++)
+        corners[offsets[get_index (indices, index_size, c)]++] = c;
+    for (int v = num_vertices; v > 0; v--) offsets[v] = offsets[v - 1];
+    offsets[0] = 0;
+    job.offsets = offsets;
+    job.corners = corners;
+
+    jobs_parallel_for (
+        (Uint32) num_vertices, NORMALS_MIN_BATCH, vertex_normals_job, &job
+    );
+
+cleanup:
+    free (offsets);
+    free (corners);
+    free (job.face_normals);
+    free (job.corner_weights);
+}
+
+float compute_acmr (
+    const void* indices,
+    SDL_GPUIndexElementSize index_size,
+    Uint32 num_indices,
+    Uint32 num_vertices
+) {
+    if (num_indices < 3) return 0.0f;
+    // FIFO cache: a vertex stays resident for VERTEX_CACHE_SIZE misses
+    Uint32* inserted = (Uint32*) malloc (num_vertices * sizeof (Uint32));
+    if (!inserted) {
+        SDL_Log ("Failed to allocate vertex cache simulation");
+        return 0.0f;
+    }
+    for (Uint32 v = 0; v < num_vertices; v++) inserted[v] = 0;
+
+    Uint32 misses = 0;
+    for (Uint32 i = 0; i < num_indices; i++) {
+        Uint32 v = get_index (indices, index_size, i);
+        // inserted[] holds the miss count after insertion, 0 is never cached
+        if (inserted[v] == 0 || misses - inserted[v] >= VERTEX_CACHE_SIZE) {
+            misses++;
+            inserted[v] = misses;
+        }
+    }
+    free (inserted);
+    return (float) misses / (float) (num_indices / 3);
+}
+
+// next fanning vertex for tipsify: the candidate still live that stays in
+// the cache longest, else the most recent dead end, else the next live one
+static Sint64 tipsify_next_vertex (
+    const Uint32* candidates,
+    Uint32 num_candidates,
+    const Uint32* live,
+    const Uint32* cache_time,
+    Uint32 timestamp,
+    Uint32* dead_ends,
+    Uint32* num_dead_ends,
+    Uint32* cursor,
+    Uint32 num_vertices
+) {
+    Sint64 best = -1;
+    Sint64 best_priority = -1;
+    for (Uint32 c = 0; c < num_candidates; c++) {
+        Uint32 v = candidates[c];
+        if (live[v] == 0) continue;
+        Sint64 priority = 0;
+        if (timestamp - cache_time[v] + 2 * live[v] <= VERTEX_CACHE_SIZE)
+            priority = timestamp - cache_time[v];
+        if (priority > best_priority) {
+            best_priority = priority;
+            best = v;
+        }
+    }
+    if (best >= 0) return best;
 
-        vec3 ab = vec3_sub (b, a);
-        vec3 ac = vec3_sub (c, a);
-        vec3 face_norm = vec3_normalize (vec3_cross (ab, ac));
+    while (*num_dead_ends > 0) {
+        Uint32 v = dead_ends[--(*num_dead_ends)];
+        if (live[v] > 0) return v;
+    }
+    for (; *cursor < num_vertices; (*cursor)++) {
+        if (live[*cursor] > 0) return *cursor;
+    }
+    return -1;
+}
 
-        accum_norms[ia] = vec3_add (accum_norms[ia], face_norm);
-        accum_norms[ib] = vec3_add (accum_norms[ib], face_norm);
-        accum_norms[ic] = vec3_add (accum_norms[ic], face_norm);
+// Returns 0 on success, 1 on failure
+static int tipsify (Uint32* tris, Uint32 num_indices, Uint32 num_vertices) {
+    Uint32 num_triangles = num_indices / 3;
+    Uint32* offsets = (Uint32*) calloc (num_vertices + 1, sizeof (Uint32));
+    Uint32* live = (Uint32*) calloc (num_vertices, sizeof (Uint32));
+    Uint32* cache_time = (Uint32*) calloc (num_vertices, sizeof (Uint32));
+    Uint32* adjacency = (Uint32*) malloc (num_indices * sizeof (Uint32));
+    Uint32* dead_ends = (Uint32*) malloc (num_indices * sizeof (Uint32));
+    Uint32* candidates = (Uint32*) malloc (num_indices * sizeof (Uint32));
+    bool* emitted = (bool*) calloc (num_triangles, sizeof (bool));
+    Uint32* out = (Uint32*) malloc (num_indices * sizeof (Uint32));
+    int result = 1;
+    if (!offsets || !live || !cache_time || !adjacency || !dead_ends ||
+        !candidates || !emitted || !out) {
+        SDL_Log ("Failed to allocate vertex cache optimization buffers");
+        goto cleanup;
     }
 
-    // Normalize and assign
-    for (int i = 0; i < num_vertices; i++) {
-        vec3 norm = vec3_normalize (accum_norms[i]);
-        vertices[i * stride + norm_offset] = norm.x;
-        vertices[i * stride + norm_offset + 1] = norm.y;
-        vertices[i * stride + norm_offset + 2] = norm.z;
+    // vertex -> triangle adjacency in CSR form
+    for (Uint32 i = 0; i < num_triangles * 3; i++) live[tris[i]]++;
+    for (Uint32 v = 0; v < num_vertices; v++)
+        offsets[v + 1] = offsets[v] + live[v];
+    for (Uint32 v = 0; v < num_vertices; v++) cache_time[v] = offsets[v];
+    for (Uint32 i = 0; i < num_triangles * 3; i++)
+        adjacency[cache_time[tris[i]]++] = i / 3;
+    for (Uint32 v = 0; v < num_vertices; v++) cache_time[v] = 0;
+
+    Uint32 timestamp = VERTEX_CACHE_SIZE + 1;
+    Uint32 cursor = 0;
+    Uint32 num_dead_ends = 0;
+    Uint32 written = 0;
+    Sint64 fan = num_vertices > 0 ? 0 : -1;
+    while (fan >= 0) {
+        Uint32 num_candidates = 0;
+        for (Uint32 a = offsets[fan]; a < offsets[fan + 1]; a++) {
+            Uint32 t = adjacency[a];
+            if (emitted[t]) continue;
+            emitted[t] = true;
+            for (int k = 0; k < 3; k++) {
+                Uint32 v = tris[t * 3 + k];
+                out[written++] = v;
+                dead_ends[num_dead_ends++] = v;
+                candidates[num_candidates++] = v;
+                live[v]--;
+                if (timestamp - cache_time[v] > VERTEX_CACHE_SIZE)
+                    cache_time[v] = timestamp++;
+            }
+        }
+        fan = tipsify_next_vertex (
+            candidates, num_candidates, live, cache_time, timestamp, dead_ends,
+            &num_dead_ends, &cursor, num_vertices
+        );
     }
 
-    free (accum_norms);
-}
\ No newline at end of file
+    SDL_memcpy (tris, out, written * sizeof (Uint32));
+    result = 0;
+
+cleanup:
+    free (offsets);
+    free (live);
+    free (cache_time);
+    free (adjacency);
+    free (dead_ends);
+    free (candidates);
+    free (emitted);
+    free (out);
+    return result;
+}
+
+// Returns 0 on success, 1 on failure
+int optimize_mesh (
+    float* vertices,
+    Uint32 num_vertices,
+    int stride,
+    void* indices,
+    SDL_GPUIndexElementSize index_size,
+    Uint32 num_indices
+) {
+    PROFILE_ZONE ("optimize_mesh");
+    num_indices -= num_indices % 3;
+    if (num_indices == 0 || num_vertices == 0) return 0;
+
+    Uint32* tris = (Uint32*) malloc (num_indices * sizeof (Uint32));
+    Uint32* remap = (Uint32*) malloc (num_vertices * sizeof (Uint32));
+    float* reordered =
+        (float*) malloc ((size_t) num_vertices * stride * sizeof (float));
+    if (!tris || !remap || !reordered) {
+        SDL_Log ("Failed to allocate mesh optimization buffers");
+        free (tris);
+        free (remap);
+        free (reordered);
+        return 1;
+    }
+
+    float acmr_before =
+        compute_acmr (indices, index_size, num_indices, num_vertices);
+    for (Uint32 i = 0; i < num_indices; i++)
+        tris[i] = get_index (indices, index_size, i);
+    if (tipsify (tris, num_indices, num_vertices)) {
+        free (tris);
+        free (remap);
+        free (reordered);
+        return 1; // logging handled in tipsify()
+    }
+
+    // vertex fetch: number vertices in the order the triangles first use
+    // them, unreferenced ones last
+    for (Uint32 v = 0; v < num_vertices; v++) remap[v] = UINT32_MAX;
+    Uint32 next = 0;
+    for (Uint32 i = 0; i < num_indices; i++) {
+        if (remap[tris[i]] == UINT32_MAX) remap[tris[i]] = next++;
+    }
+    for (Uint32 v = 0; v < num_vertices; v++) {
+        if (remap[v] == UINT32_MAX) remap[v] = next++;
+    }
+    for (Uint32 v = 0; v < num_vertices; v++) {
+        float* dst = &reordered[(size_t) remap[v] * stride];
+        SDL_memcpy (dst, &vertices[(size_t) v * stride], stride * sizeof (float));
+    }
+    SDL_memcpy (
+        vertices, reordered, (size_t) num_vertices * stride * sizeof (float)
+    );
+    for (Uint32 i = 0; i < num_indices; i++)
+        set_index (indices, index_size, i, remap[tris[i]]);
+
+    float acmr_after =
+        compute_acmr (indices, index_size, num_indices, num_vertices);
+    SDL_LogDebug (
+        SDL_LOG_CATEGORY_APPLICATION,
+        "Mesh optimized: %u triangles, ACMR %.3f -> %.3f", num_indices / 3,
+        acmr_before, acmr_after
+    );
+
+    free (tris);
+    free (remap);
+    free (reordered);
+    return 0;
+}
@@ -0,0 +1,1148 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include <geometry/g_common.h>
+#include <geometry/gltf.h>
+#include <gpu/buffer_heap.h>
+#include <profiler/profiler.h>
+
+#define GLB_MAGIC 0x46546c67u      // "glTF"
+#define GLB_CHUNK_JSON 0x4e4f534au // "JSON"
+#define GLB_CHUNK_BIN 0x004e4942u  // "BIN\0"
+
+#define GLTF_MODE_TRIANGLES 4
+#define GLTF_BYTE 5120
+#define GLTF_UNSIGNED_BYTE 5121
+#define GLTF_SHORT 5122
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_UNSIGNED_INT 5125
+#define GLTF_FLOAT 5126
+
+#define JSON_MAX_DEPTH 64
+#define JSON_NONE 0xffffffffu
+
+// ---- JSON ----
+
+typedef enum {
+    JSON_OBJECT,
+    JSON_ARRAY,
+    JSON_STRING,
+    JSON_PRIMITIVE, // number, true, false or null
+} JsonType;
+
+// tokens are stored flat in document order; objects hold key, value pairs
+typedef struct {
+    JsonType type;
+    Uint32 start; // byte range in the text, quotes excluded
+    Uint32 end;
+    Uint32 next; // first token after this one's subtree
+} JsonToken;
+
+typedef struct {
+    const char* text;
+    JsonToken* tokens;
+    Uint32 count;
+} Json;
+
+// Returns the number of tokens, -1 if the text is malformed
+// counts only when tokens is NULL, so callers can allocate exactly once
+static Sint64 json_tokenize (
+    const char* text,
+    Uint32 length,
+    JsonToken* tokens
+) {
+    Uint32 stack[JSON_MAX_DEPTH];
+    char closers[JSON_MAX_DEPTH];
+    Uint32 depth = 0;
+    Uint32 count = 0;
+
+    for (Uint32 i = 0; i < length; i++) {
+        char c = text[i];
+        switch (c) {
+        case '{':
+        case '[':
+            if (depth == JSON_MAX_DEPTH) return -1;
+            if (tokens) {
+                tokens[count] = (JsonToken) {
+                    .type = c == '{' ? JSON_OBJECT : JSON_ARRAY,
+                    .start = i
+                };
+            }
+            closers[depth] = c == '{' ? '}' : ']';
+            stack[depth++] = count++;
+            break;
+        case '}':
+        case ']':
+            if (depth == 0 || closers[depth - 1] != c) return -1;
+            depth--;
+            if (tokens) {
+                tokens[stack[depth]].end = i + 1;
+                tokens[stack[depth]].next = count;
+            }
+            break;
+        case '"': {
+            Uint32 start = i + 1;
+            for (i++; i < length && text[i] != '"'; i++) {
+                if (text[i] == '\\') i++;
+            }
+            if (i >= length) return -1;
+            if (tokens) {
+                tokens[count] = (JsonToken) {
+                    .type = JSON_STRING,
+                    .start = start,
+                    .end = i,
+                    .next = count + 1
+                };
+            }
+            count++;
+            break;
+        }
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\n':
+        case '\0': // padding
+        case ':':
+        case ',':
+            break;
+        default: {
+            Uint32 start = i;
+            while (i < length && !SDL_strchr (" \t\r\n,:]}", text[i]) &&
+                   text[i] != '\0')
+                i++;
+            if (tokens) {
+                tokens[count] = (JsonToken) {
+                    .type = JSON_PRIMITIVE,
+                    .start = start,
+                    .end = i,
+                    .next = count + 1
+                };
+            }
+            count++;
+            i--; // the delimiter is handled by the next iteration
+            break;
+        }
+        }
+    }
+    if (depth) return -1;
+    return count;
+}
+
+static bool json_equals (const Json* json, Uint32 t, const char* s) {
+    if (t == JSON_NONE) return false;
+    const JsonToken* token = &json->tokens[t];
+    size_t length = SDL_strlen (s);
+    return token->type == JSON_STRING && token->end - token->start == length &&
+           !SDL_memcmp (json->text + token->start, s, length);
+}
+
+// Returns the value of key in object, JSON_NONE if absent
+static Uint32 json_get (const Json* json, Uint32 object, const char* key) {
+    if (object == JSON_NONE || json->tokens[object].type != JSON_OBJECT)
+        return JSON_NONE;
+    Uint32 end = json->tokens[object].next;
+    for (Uint32 t = object + 1; t + 1 < end; t = json->tokens[t + 1].next) {
+        if (json_equals (json, t, key)) return t + 1;
+    }
+    return JSON_NONE;
+}
+
+// Returns element n of array, JSON_NONE if absent
+static Uint32 json_at (const Json* json, Uint32 array, Uint32 n) {
+    if (array == JSON_NONE || json->tokens[array].type != JSON_ARRAY)
+        return JSON_NONE;
+    Uint32 end = json->tokens[array].next;
+    for (Uint32 t = array + 1; t < end; t = json->tokens[t].next) {
+        if (n-- == 0) return t;
+    }
+    return JSON_NONE;
+}
+
+static Uint32 json_length (const Json* json, Uint32 array) {
+    if (array == JSON_NONE || json->tokens[array].type != JSON_ARRAY) return 0;
+    Uint32 length = 0;
+    Uint32 end = json->tokens[array].next;
+    for (Uint32 t = array + 1; t < end; t = json->tokens[t].next) length++;
+    return length;
+}
+
+// fills items with the token of every element; Returns the element count
+static Uint32 json_elements (const Json* json, Uint32 array, Uint32* items) {
+    if (array == JSON_NONE || json->tokens[array].type != JSON_ARRAY) return 0;
+    Uint32 length = 0;
+    Uint32 end = json->tokens[array].next;
+    for (Uint32 t = array + 1; t < end; t = json->tokens[t].next)
+        items[length++] = t;
+    return length;
+}
+
+static double json_number (const Json* json, Uint32 t, double fallback) {
+    if (t == JSON_NONE || json->tokens[t].type != JSON_PRIMITIVE)
+        return fallback;
+    char buffer[64];
+    Uint32 length = json->tokens[t].end - json->tokens[t].start;
+    if (length >= sizeof (buffer)) return fallback;
+    SDL_memcpy (buffer, json->text + json->tokens[t].start, length);
+    buffer[length] = '\0';
+    char* end = NULL;
+    double value = SDL_strtod (buffer, &end);
+    return end == buffer ? fallback : value;
+}
+
+static bool json_true (const Json* json, Uint32 t) {
+    if (t == JSON_NONE || json->tokens[t].type != JSON_PRIMITIVE) return false;
+    return json->tokens[t].end - json->tokens[t].start == 4 &&
+           !SDL_memcmp (json->text + json->tokens[t].start, "true", 4);
+}
+
+// Returns a non-negative integer token's value, JSON_NONE otherwise
+static Uint32 json_index (const Json* json, Uint32 t) {
+    double value = json_number (json, t, -1.0);
+    if (value < 0.0 || value >= (double) JSON_NONE) return JSON_NONE;
+    return (Uint32) value;
+}
+
+// non-negative integer member of object, or fallback
+static Uint32 json_uint (
+    const Json* json,
+    Uint32 object,
+    const char* key,
+    Uint32 fallback
+) {
+    Uint32 value = json_index (json, json_get (json, object, key));
+    return value == JSON_NONE ? fallback : value;
+}
+
+// reads up to count numbers of an array member; Returns how many were read
+static Uint32 json_floats (
+    const Json* json,
+    Uint32 object,
+    const char* key,
+    float* out,
+    Uint32 count
+) {
+    Uint32 array = json_get (json, object, key);
+    if (array == JSON_NONE || json->tokens[array].type != JSON_ARRAY) return 0;
+    Uint32 read = 0;
+    Uint32 end = json->tokens[array].next;
+    for (Uint32 t = array + 1; t < end && read < count;
+         t = json->tokens[t].next)
+        out[read++] = (float) json_number (json, t, 0.0);
+    return read;
+}
+
+// ---- document ----
+
+typedef struct {
+    Json json;
+    const Uint8* bin;
+    Uint64 bin_size;
+    // element tokens of the top-level arrays
+    Uint32* accessors;
+    Uint32 accessor_count;
+    Uint32* views;
+    Uint32 view_count;
+    Uint32* meshes;
+    Uint32 mesh_count;
+    Uint32* nodes;
+    Uint32 node_count;
+} GltfDocument;
+
+typedef struct {
+    const Uint8* data; // first element, inside the BIN chunk
+    Uint32 count;
+    Uint32 component_type;
+    Uint32 components;
+    Uint32 element_size;
+    Uint32 stride;
+    bool normalized;
+    bool has_bounds;
+    float min[3];
+    float max[3];
+} GltfAccessor;
+
+static Uint32 component_size (Uint32 component_type) {
+    switch (component_type) {
+    case GLTF_BYTE:
+    case GLTF_UNSIGNED_BYTE:
+        return 1;
+    case GLTF_SHORT:
+    case GLTF_UNSIGNED_SHORT:
+        return 2;
+    case GLTF_UNSIGNED_INT:
+    case GLTF_FLOAT:
+        return 4;
+    }
+    return 0;
+}
+
+static Uint32 type_components (const Json* json, Uint32 t) {
+    if (json_equals (json, t, "SCALAR")) return 1;
+    if (json_equals (json, t, "VEC2")) return 2;
+    if (json_equals (json, t, "VEC3")) return 3;
+    if (json_equals (json, t, "VEC4")) return 4;
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+static int read_accessor (
+    const GltfDocument* doc,
+    Uint32 index,
+    GltfAccessor* out
+) {
+    const Json* json = &doc->json;
+    if (index >= doc->accessor_count) {
+        SDL_Log ("glTF accessor %u does not exist", index);
+        return 1;
+    }
+    Uint32 accessor = doc->accessors[index];
+    if (json_get (json, accessor, "sparse") != JSON_NONE) {
+        SDL_Log ("glTF sparse accessors are not supported");
+        return 1;
+    }
+
+    Uint32 view_index = json_uint (json, accessor, "bufferView", JSON_NONE);
+    if (view_index >= doc->view_count) {
+        SDL_Log ("glTF accessor %u has no buffer view", index);
+        return 1;
+    }
+    Uint32 view = doc->views[view_index];
+    if (json_uint (json, view, "buffer", 0) != 0 || !doc->bin) {
+        SDL_Log ("glTF buffers outside the BIN chunk are not supported");
+        return 1;
+    }
+
+    *out = (GltfAccessor) {
+        .count = json_uint (json, accessor, "count", 0),
+        .component_type = json_uint (json, accessor, "componentType", 0),
+        .components = type_components (json, json_get (json, accessor, "type")),
+        .normalized = json_true (json, json_get (json, accessor, "normalized"))
+    };
+    out->element_size =
+        out->components * component_size (out->component_type);
+    if (out->element_size == 0 || out->count == 0) {
+        SDL_Log ("glTF accessor %u is empty or of an unknown type", index);
+        return 1;
+    }
+    out->stride = json_uint (json, view, "byteStride", 0);
+    if (out->stride == 0) out->stride = out->element_size;
+
+    Uint64 view_offset = json_uint (json, view, "byteOffset", 0);
+    Uint64 view_length = json_uint (json, view, "byteLength", 0);
+    Uint64 offset = json_uint (json, accessor, "byteOffset", 0);
+    Uint64 span =
+        (Uint64) (out->count - 1) * out->stride + out->element_size;
+    if (view_offset + view_length > doc->bin_size ||
+        offset + span > view_length) {
+        SDL_Log ("glTF accessor %u reads past its buffer", index);
+        return 1;
+    }
+    out->data = doc->bin + view_offset + offset;
+
+    out->has_bounds =
+        json_floats (json, accessor, "min", out->min, 3) == 3 &&
+        json_floats (json, accessor, "max", out->max, 3) == 3;
+    return 0;
+}
+
+// component c of element i as a float, normalizing integer types
+static float accessor_float (const GltfAccessor* acc, Uint32 i, Uint32 c) {
+    const Uint8* p = acc->data + (size_t) i * acc->stride;
+    switch (acc->component_type) {
+    case GLTF_FLOAT: {
+        float value;
+        SDL_memcpy (&value, p + c * 4, sizeof (value));
+        return value;
+    }
+    case GLTF_UNSIGNED_SHORT: {
+        Uint16 value;
+        SDL_memcpy (&value, p + c * 2, sizeof (value));
+        return acc->normalized ? value / 65535.0f : (float) value;
+    }
+    case GLTF_SHORT: {
+        Sint16 value;
+        SDL_memcpy (&value, p + c * 2, sizeof (value));
+        return acc->normalized ? SDL_max (value / 32767.0f, -1.0f)
+                               : (float) value;
+    }
+    case GLTF_UNSIGNED_BYTE:
+        return acc->normalized ? p[c] / 255.0f : (float) p[c];
+    case GLTF_BYTE: {
+        Sint8 value = (Sint8) p[c];
+        return acc->normalized ? SDL_max (value / 127.0f, -1.0f)
+                               : (float) value;
+    }
+    }
+    return 0.0f;
+}
+
+static Uint32 accessor_index (const GltfAccessor* acc, Uint32 i) {
+    const Uint8* p = acc->data + (size_t) i * acc->stride;
+    if (acc->component_type == GLTF_UNSIGNED_BYTE) return p[0];
+    if (acc->component_type == GLTF_UNSIGNED_SHORT) {
+        Uint16 value;
+        SDL_memcpy (&value, p, sizeof (value));
+        return value;
+    }
+    Uint32 value;
+    SDL_memcpy (&value, p, sizeof (value));
+    return value;
+}
+
+// ---- transforms ----
+
+typedef struct {
+    vec3 translation;
+    vec4 rotation;
+    vec3 scale;
+} Trs;
+
+static vec4 quat_from_rotation (const float r[9]) {
+    // r is column-major 3x3
+    float trace = r[0] + r[4] + r[8];
+    vec4 q;
+    if (trace > 0.0f) {
+        float s = sqrtf (trace + 1.0f) * 2.0f;
+        q = (vec4) {
+            .w = 0.25f * s,
+            .x = (r[5] - r[7]) / s,
+            .y = (r[6] - r[2]) / s,
+            .z = (r[1] - r[3]) / s
+        };
+    } else if (r[0] > r[4] && r[0] > r[8]) {
+        float s = sqrtf (1.0f + r[0] - r[4] - r[8]) * 2.0f;
+        q = (vec4) {
+            .w = (r[5] - r[7]) / s,
+            .x = 0.25f * s,
+            .y = (r[3] + r[1]) / s,
+            .z = (r[6] + r[2]) / s
+        };
+    } else if (r[4] > r[8]) {
+        float s = sqrtf (1.0f + r[4] - r[0] - r[8]) * 2.0f;
+        q = (vec4) {
+            .w = (r[6] - r[2]) / s,
+            .x = (r[3] + r[1]) / s,
+            .y = 0.25f * s,
+            .z = (r[7] + r[5]) / s
+        };
+    } else {
+        float s = sqrtf (1.0f + r[8] - r[0] - r[4]) * 2.0f;
+        q = (vec4) {
+            .w = (r[1] - r[3]) / s,
+            .x = (r[6] + r[2]) / s,
+            .y = (r[7] + r[5]) / s,
+            .z = 0.25f * s
+        };
+    }
+    return quat_normalize (q);
+}
+
+static Trs node_transform (const Json* json, Uint32 node) {
+    Trs trs = {
+        .translation = {0.0f, 0.0f, 0.0f},
+        .rotation = {.w = 1.0f},
+        .scale = {1.0f, 1.0f, 1.0f}
+    };
+
+    float m[16];
+    if (json_floats (json, node, "matrix", m, 16) == 16) {
+        // assumes no shear, as the spec requires for animated nodes
+        trs.translation = (vec3) {m[12], m[13], m[14]};
+        float s[3];
+        for (int c = 0; c < 3; c++) {
+            s[c] = sqrtf (
+                m[c * 4] * m[c * 4] + m[c * 4 + 1] * m[c * 4 + 1] +
+                m[c * 4 + 2] * m[c * 4 + 2]
+            );
+            if (s[c] == 0.0f) s[c] = 1.0f;
+        }
+        float det = m[0] * (m[5] * m[10] - m[9] * m[6]) -
+                    m[4] * (m[1] * m[10] - m[9] * m[2]) +
+                    m[8] * (m[1] * m[6] - m[5] * m[2]);
+        if (det < 0.0f) s[0] = -s[0];
+        float r[9];
+        for (int c = 0; c < 3; c++) {
+            for (int k = 0; k < 3; k++) r[c * 3 + k] = m[c * 4 + k] / s[c];
+        }
+        trs.rotation = quat_from_rotation (r);
+        trs.scale = (vec3) {s[0], s[1], s[2]};
+        return trs;
+    }
+
+    float t[4];
+    if (json_floats (json, node, "translation", t, 3) == 3)
+        trs.translation = (vec3) {t[0], t[1], t[2]};
+    if (json_floats (json, node, "rotation", t, 4) == 4)
+        trs.rotation = quat_normalize (
+            (vec4) {.w = t[3], .x = t[0], .y = t[1], .z = t[2]}
+        );
+    if (json_floats (json, node, "scale", t, 3) == 3)
+        trs.scale = (vec3) {t[0], t[1], t[2]};
+    return trs;
+}
+
+// exact without shear; non-uniform parent scale on a rotated child is
+// approximated the way a TRS transform component has to
+static Trs trs_combine (Trs parent, Trs local) {
+    vec3 scaled = {
+        parent.scale.x * local.translation.x,
+        parent.scale.y * local.translation.y,
+        parent.scale.z * local.translation.z
+    };
+    return (Trs) {
+        .translation = vec3_add (
+            parent.translation, vec3_rotate (parent.rotation, scaled)
+        ),
+        .rotation = quat_multiply (parent.rotation, local.rotation),
+        .scale = {
+            parent.scale.x * local.scale.x, parent.scale.y * local.scale.y,
+            parent.scale.z * local.scale.z
+        }
+    };
+}
+
+// glTF is right-handed; mirroring z gives the engine's left-handed axes
+static TransformComponent trs_to_engine (Trs trs) {
+    return (TransformComponent) {
+        .position = {
+            trs.translation.x, trs.translation.y, -trs.translation.z
+        },
+        .rotation = {
+            .w = trs.rotation.w,
+            .x = -trs.rotation.x,
+            .y = -trs.rotation.y,
+            .z = trs.rotation.z
+        },
+        .scale = {trs.scale.x, trs.scale.y, -trs.scale.z}
+    };
+}
+
+// ---- primitives ----
+
+// a primitive whose streams are copied from the BIN chunk unchanged
+typedef struct {
+    const Uint8* sources[4]; // position, normal, uv, indices
+    Uint32 sizes[4];
+    Uint32 transfer_offset;
+} DirectUpload;
+
+static bool is_float_stream (
+    const GltfAccessor* acc,
+    Uint32 components,
+    Uint32 count
+) {
+    return acc->component_type == GLTF_FLOAT &&
+           acc->components == components && acc->count == count &&
+           acc->stride == acc->element_size;
+}
+
+static float accessor_radius (const GltfAccessor* positions) {
+    float radius_sq = 0.0f;
+    if (positions->has_bounds) {
+        // farthest corner of the bounds
+        for (int k = 0; k < 3; k++) {
+            float extent = SDL_max (
+                fabsf (positions->min[k]), fabsf (positions->max[k])
+            );
+            radius_sq += extent * extent;
+        }
+        return sqrtf (radius_sq);
+    }
+    for (Uint32 i = 0; i < positions->count; i++) {
+        float x = accessor_float (positions, i, 0);
+        float y = accessor_float (positions, i, 1);
+        float z = accessor_float (positions, i, 2);
+        radius_sq = SDL_max (radius_sq, x * x + y * y + z * z);
+    }
+    return sqrtf (radius_sq);
+}
+
+// Returns 0 on success, 1 on failure
+// whole triangles whose every index names a vertex, so neither path can
+// send the GPU fetching past the vertex data
+static int check_indices (const GltfAccessor* indices, Uint32 num_vertices) {
+    Uint32 num_indices = indices ? indices->count : num_vertices;
+    if (num_indices % 3) {
+        SDL_Log ("glTF triangle list has %u indices", num_indices);
+        return 1;
+    }
+    for (Uint32 i = 0; indices && i < num_indices; i++) {
+        Uint32 index = accessor_index (indices, i);
+        if (index >= num_vertices) {
+            SDL_Log ("glTF index %u is out of range", index);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+// decodes anything the direct path cannot take into the generator layout;
+// the indices have passed check_indices()
+static int decode_primitive (
+    SDL_GPUDevice* device,
+    const GltfAccessor* positions,
+    const GltfAccessor* normals,   // NULL when absent
+    const GltfAccessor* texcoords, // NULL when absent
+    const GltfAccessor* indices,   // NULL when absent
+    MeshComponent* out
+) {
+    PROFILE_ZONE ("decode_gltf_primitive");
+    Uint32 num_vertices = positions->count;
+    Uint32 num_indices = indices ? indices->count : num_vertices;
+    SDL_GPUIndexElementSize index_size = choose_index_size (num_vertices);
+
+    float* vertices =
+        (float*) calloc ((size_t) num_vertices * 8, sizeof (float));
+    void* index_data = alloc_indices (num_indices, index_size);
+    if (!vertices || !index_data) {
+        SDL_Log ("Failed to allocate glTF primitive");
+        free (vertices);
+        free (index_data);
+        return 1;
+    }
+
+    for (Uint32 i = 0; i < num_vertices; i++) {
+        float* v = &vertices[i * 8];
+        for (Uint32 c = 0; c < 3; c++) {
+            v[c] = accessor_float (positions, i, c);
+            if (normals) v[3 + c] = accessor_float (normals, i, c);
+        }
+        if (texcoords) {
+            v[6] = accessor_float (texcoords, i, 0);
+            v[7] = accessor_float (texcoords, i, 1);
+        }
+    }
+    for (Uint32 i = 0; i < num_indices; i++) {
+        Uint32 index = indices ? accessor_index (indices, i) : i;
+        set_index (index_data, index_size, i, index);
+    }
+    if (!normals) {
+        compute_vertex_normals (
+            vertices, (int) num_vertices, index_data, index_size,
+            (int) num_indices, 8, 0, 3, NORMAL_WEIGHT_ANGLE
+        );
+    }
+
+    MeshComponent mesh = {0};
+    int failed = upload_mesh_vertices (device, vertices, num_vertices, &mesh);
+    free (vertices);
+    if (failed) {
+        free (index_data);
+        return 1; // logging handled in upload_mesh_vertices()
+    }
+    failed = upload_indices (
+        device, index_data,
+        (Uint64) num_indices * index_size_bytes (index_size),
+        &mesh
+    );
+    free (index_data);
+    if (failed) {
+        release_mesh_buffers (device, &mesh);
+        return 1; // logging handled in upload_indices()
+    }
+    mesh.num_indices = num_indices;
+    mesh.index_size = index_size;
+    *out = mesh;
+    return 0;
+}
+
+// Returns 0 on success, 1 if the primitive was skipped or failed to load
+// direct primitives only get their buffers created here; their data is
+// uploaded later by upload_direct()
+static int load_primitive (
+    SDL_GPUDevice* device,
+    const GltfDocument* doc,
+    Uint32 primitive,
+    MeshComponent* out,
+    DirectUpload* direct
+) {
+    const Json* json = &doc->json;
+    if (json_uint (json, primitive, "mode", GLTF_MODE_TRIANGLES) !=
+        GLTF_MODE_TRIANGLES) {
+        SDL_Log ("Skipping glTF primitive that is not a triangle list");
+        return 1;
+    }
+
+    Uint32 attributes = json_get (json, primitive, "attributes");
+    Uint32 position_index = json_uint (json, attributes, "POSITION", JSON_NONE);
+    Uint32 normal_index = json_uint (json, attributes, "NORMAL", JSON_NONE);
+    Uint32 uv_index = json_uint (json, attributes, "TEXCOORD_0", JSON_NONE);
+    Uint32 index_index = json_uint (json, primitive, "indices", JSON_NONE);
+
+    GltfAccessor positions, normals, texcoords, indices;
+    if (read_accessor (doc, position_index, &positions))
+        return 1; // logging handled in read_accessor()
+    if (positions.components != 3) {
+        SDL_Log ("glTF positions must have three components");
+        return 1;
+    }
+    bool has_normals = normal_index != JSON_NONE;
+    bool has_uvs = uv_index != JSON_NONE;
+    bool has_indices = index_index != JSON_NONE;
+    if ((has_normals && read_accessor (doc, normal_index, &normals)) ||
+        (has_uvs && read_accessor (doc, uv_index, &texcoords)) ||
+        (has_indices && read_accessor (doc, index_index, &indices)))
+        return 1; // logging handled in read_accessor()
+    if ((has_normals && normals.count != positions.count) ||
+        (has_uvs && texcoords.count != positions.count)) {
+        SDL_Log ("glTF attribute counts do not match");
+        return 1;
+    }
+    if (check_indices (has_indices ? &indices : NULL, positions.count))
+        return 1; // logging handled in check_indices()
+
+    Uint32 count = positions.count;
+    bool is_direct = has_normals && has_uvs && has_indices &&
+                     is_float_stream (&positions, 3, count) &&
+                     is_float_stream (&normals, 3, count) &&
+                     is_float_stream (&texcoords, 2, count) &&
+                     indices.components == 1 &&
+                     indices.stride == indices.element_size &&
+                     (indices.component_type == GLTF_UNSIGNED_SHORT ||
+                      indices.component_type == GLTF_UNSIGNED_INT);
+    if (!is_direct) {
+        return decode_primitive (
+            device, &positions, has_normals ? &normals : NULL,
+            has_uvs ? &texcoords : NULL, has_indices ? &indices : NULL, out
+        ); // logging handled in decode_primitive()
+    }
+
+    // sizes of byte-aligned streams fit: views are bounded by the BIN chunk
+    *direct = (DirectUpload) {
+        .sources = {positions.data, normals.data, texcoords.data, indices.data},
+        .sizes = {
+            count * positions.element_size, count * normals.element_size,
+            count * texcoords.element_size,
+            indices.count * indices.element_size
+        }
+    };
+
+    Uint64 vertex_size =
+        (Uint64) direct->sizes[0] + direct->sizes[1] + direct->sizes[2];
+    if (vertex_size > SDL_MAX_UINT32) {
+        SDL_Log ("glTF primitive exceeds one vertex buffer");
+        return 1;
+    }
+    SDL_GPUBuffer* vbo = NULL;
+    Uint32 vbo_offset = 0;
+    if (buffer_heap_alloc (
+            device, BUFFER_HEAP_VERTEX, (Uint32) vertex_size, &vbo,
+            &vbo_offset
+        ))
+        return 1; // logging handled in buffer_heap_alloc()
+    SDL_GPUBuffer* ibo = NULL;
+    Uint32 ibo_offset = 0;
+    if (buffer_heap_alloc (
+            device, BUFFER_HEAP_INDEX, direct->sizes[3], &ibo, &ibo_offset
+        )) {
+        buffer_heap_free (device, BUFFER_HEAP_VERTEX, vbo, vbo_offset);
+        return 1; // logging handled in buffer_heap_alloc()
+    }
+
+    *out = (MeshComponent) {
+        .vertex_buffer = vbo,
+        .vertex_offset = vbo_offset,
+        .num_vertices = count,
+        .index_buffer = ibo,
+        .index_offset = ibo_offset,
+        .num_indices = indices.count,
+        .index_size = indices.component_type == GLTF_UNSIGNED_INT
+                          ? SDL_GPU_INDEXELEMENTSIZE_32BIT
+                          : SDL_GPU_INDEXELEMENTSIZE_16BIT,
+        .layout = VERTEX_LAYOUT_SEPARATE,
+        .stream_offsets = {
+            0, direct->sizes[0], direct->sizes[0] + direct->sizes[1]
+        },
+        .pos_scale = {1.0f, 1.0f, 1.0f},
+        .radius = accessor_radius (&positions)
+    };
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+// copies every direct primitive's streams from the mapped file into one
+// transfer buffer and uploads them all in a single copy pass
+static int upload_direct (
+    SDL_GPUDevice* device,
+    GltfPrimitive* primitives,
+    DirectUpload* uploads,
+    Uint32 count
+) {
+    PROFILE_ZONE ("upload_gltf");
+    Uint64 total = 0;
+    for (Uint32 i = 0; i < count; i++) {
+        if (!uploads[i].sources[0]) continue;
+        uploads[i].transfer_offset = (Uint32) total;
+        for (int s = 0; s < 4; s++) total += (uploads[i].sizes[s] + 3) & ~3u;
+        if (total > SDL_MAX_UINT32) {
+            SDL_Log ("glTF geometry exceeds one transfer buffer");
+            return 1;
+        }
+    }
+    if (total == 0) return 0;
+
+    SDL_GPUTransferBufferCreateInfo trans_info = {
+        .size = (Uint32) total,
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
+    };
+    SDL_GPUTransferBuffer* trans_buf =
+        SDL_CreateGPUTransferBuffer (device, &trans_info);
+    if (!trans_buf) {
+        SDL_Log ("Failed to create transfer buffer: %s", SDL_GetError ());
+        return 1;
+    }
+
+    Uint8* data = (Uint8*) SDL_MapGPUTransferBuffer (device, trans_buf, false);
+    if (!data) {
+        SDL_Log ("Failed to map transfer buffer: %s", SDL_GetError ());
+        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+        return 1;
+    }
+    for (Uint32 i = 0; i < count; i++) {
+        if (!uploads[i].sources[0]) continue;
+        Uint32 offset = uploads[i].transfer_offset;
+        for (int s = 0; s < 4; s++) {
+            SDL_memcpy (
+                data + offset, uploads[i].sources[s], uploads[i].sizes[s]
+            );
+            offset += (uploads[i].sizes[s] + 3) & ~3u;
+        }
+    }
+    SDL_UnmapGPUTransferBuffer (device, trans_buf);
+
+    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (device);
+    if (!cmd) {
+        SDL_Log ("Failed to acquire command buffer: %s", SDL_GetError ());
+        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+        return 1;
+    }
+
+    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass (cmd);
+    if (!copy_pass) {
+        SDL_Log ("Failed to begin copy pass: %s", SDL_GetError ());
+        SDL_SubmitGPUCommandBuffer (cmd);
+        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+        return 1;
+    }
+
+    for (Uint32 i = 0; i < count; i++) {
+        if (!uploads[i].sources[0]) continue;
+        const MeshComponent* mesh = &primitives[i].mesh;
+        Uint32 offset = uploads[i].transfer_offset;
+        for (int s = 0; s < 4; s++) {
+            SDL_GPUTransferBufferLocation src_loc = {
+                .transfer_buffer = trans_buf,
+                .offset = offset
+            };
+            // the last stream is the indices, which have no stream offset
+            SDL_GPUBufferRegion dst_reg = {
+                .buffer = mesh->index_buffer,
+                .offset = mesh->index_offset,
+                .size = uploads[i].sizes[s]
+            };
+            if (s < 3) {
+                dst_reg.buffer = mesh->vertex_buffer;
+                dst_reg.offset = mesh->vertex_offset + mesh->stream_offsets[s];
+            }
+            SDL_UploadToGPUBuffer (copy_pass, &src_loc, &dst_reg, false);
+            offset += (uploads[i].sizes[s] + 3) & ~3u;
+        }
+    }
+    SDL_EndGPUCopyPass (copy_pass);
+    SDL_SubmitGPUCommandBuffer (cmd);
+
+    SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+    return 0;
+}
+
+// ---- loading ----
+
+// Returns 0 on success, 1 on failure
+static int parse_glb (
+    const MappedFile* file,
+    const char* path,
+    GltfDocument* doc
+) {
+    const Uint8* data = file->data;
+    Uint32 header[5];
+    if (file->size < sizeof (header)) {
+        SDL_Log ("%s is not a .glb file", path);
+        return 1;
+    }
+    SDL_memcpy (header, data, sizeof (header));
+    // magic, version, length, then the JSON chunk's length and type
+    if (header[0] != GLB_MAGIC || header[1] != 2 || header[2] > file->size ||
+        header[4] != GLB_CHUNK_JSON || (Uint64) header[3] + 20 > header[2]) {
+        SDL_Log ("%s is not a version 2 .glb file", path);
+        return 1;
+    }
+    Uint64 length = header[2];
+    doc->json.text = (const char*) data + 20;
+    Uint32 json_size = header[3];
+
+    Uint64 bin_chunk = 20 + (Uint64) json_size;
+    if (bin_chunk + 8 <= length) {
+        Uint32 chunk[2];
+        SDL_memcpy (chunk, data + bin_chunk, sizeof (chunk));
+        if (chunk[1] == GLB_CHUNK_BIN && chunk[0] <= length - bin_chunk - 8) {
+            doc->bin = data + bin_chunk + 8;
+            doc->bin_size = chunk[0];
+        }
+    }
+
+    Sint64 count = json_tokenize (doc->json.text, json_size, NULL);
+    if (count <= 0) {
+        SDL_Log ("%s has malformed JSON", path);
+        return 1;
+    }
+    doc->json.tokens = (JsonToken*) malloc (count * sizeof (JsonToken));
+    if (!doc->json.tokens) {
+        SDL_Log ("Failed to allocate glTF tokens");
+        return 1;
+    }
+    json_tokenize (doc->json.text, json_size, doc->json.tokens);
+    doc->json.count = (Uint32) count;
+    if (doc->json.tokens[0].type != JSON_OBJECT) {
+        SDL_Log ("%s has malformed JSON", path);
+        return 1;
+    }
+
+    // one table for the element tokens of every array we index into
+    const Json* json = &doc->json;
+    Uint32 accessors = json_get (json, 0, "accessors");
+    Uint32 views = json_get (json, 0, "bufferViews");
+    Uint32 meshes = json_get (json, 0, "meshes");
+    Uint32 nodes = json_get (json, 0, "nodes");
+    Uint32 total = json_length (json, accessors) + json_length (json, views) +
+                   json_length (json, meshes) + json_length (json, nodes);
+    Uint32* table = (Uint32*) malloc ((total + 1) * sizeof (Uint32));
+    if (!table) {
+        SDL_Log ("Failed to allocate glTF tables");
+        return 1;
+    }
+    doc->accessors = table;
+    doc->accessor_count = json_elements (json, accessors, doc->accessors);
+    doc->views = doc->accessors + doc->accessor_count;
+    doc->view_count = json_elements (json, views, doc->views);
+    doc->meshes = doc->views + doc->view_count;
+    doc->mesh_count = json_elements (json, meshes, doc->meshes);
+    doc->nodes = doc->meshes + doc->mesh_count;
+    doc->node_count = json_elements (json, nodes, doc->nodes);
+    return 0;
+}
+
+// pushes node n with its world transform unless it was already reached
+static void push_node (
+    const GltfDocument* doc,
+    Uint32 n,
+    const Trs* parent,
+    Trs* world,
+    Uint32* stack,
+    Uint32* depth,
+    Uint8* visited
+) {
+    if (n >= doc->node_count || visited[n] == 1) return;
+    visited[n] = 1;
+    Trs local = node_transform (&doc->json, doc->nodes[n]);
+    world[n] = parent ? trs_combine (*parent, local) : local;
+    stack[(*depth)++] = n;
+}
+
+// Returns the number of mesh nodes written to order, with their world
+// transforms; roots are the default scene's nodes, or every parentless node
+// when there are no scenes
+static Uint32 flatten_nodes (
+    const GltfDocument* doc,
+    Uint32* order,
+    Trs* world,
+    Uint32* stack,
+    Uint8* visited
+) {
+    const Json* json = &doc->json;
+    Uint32 depth = 0;
+
+    Uint32 scene = json_at (
+        json, json_get (json, 0, "scenes"), json_uint (json, 0, "scene", 0)
+    );
+    if (scene != JSON_NONE) {
+        Uint32 roots = json_get (json, scene, "nodes");
+        Uint32 end = json_length (json, roots) ? json->tokens[roots].next : 0;
+        for (Uint32 t = roots + 1; t < end; t = json->tokens[t].next)
+            push_node (
+                doc, json_index (json, t), NULL, world, stack, &depth, visited
+            );
+    } else {
+        // 2 marks a child; push_node() only skips nodes already reached
+        for (Uint32 n = 0; n < doc->node_count; n++) {
+            Uint32 children = json_get (json, doc->nodes[n], "children");
+            Uint32 end =
+                json_length (json, children) ? json->tokens[children].next : 0;
+            for (Uint32 t = children + 1; t < end; t = json->tokens[t].next) {
+                Uint32 child = json_index (json, t);
+                if (child < doc->node_count) visited[child] = 2;
+            }
+        }
+        for (Uint32 n = 0; n < doc->node_count; n++) {
+            if (visited[n] == 0)
+                push_node (doc, n, NULL, world, stack, &depth, visited);
+        }
+    }
+
+    // each node is pushed at most once, so the stack never overflows
+    Uint32 count = 0;
+    while (depth) {
+        Uint32 n = stack[--depth];
+        Uint32 node = doc->nodes[n];
+        if (json_get (json, node, "mesh") != JSON_NONE) order[count++] = n;
+
+        Uint32 children = json_get (json, node, "children");
+        Uint32 end =
+            json_length (json, children) ? json->tokens[children].next : 0;
+        for (Uint32 t = children + 1; t < end; t = json->tokens[t].next)
+            push_node (
+                doc, json_index (json, t), &world[n], world, stack, &depth,
+                visited
+            );
+    }
+    return count;
+}
+
+static void release_primitives (
+    SDL_GPUDevice* device,
+    GltfPrimitive* primitives,
+    Uint32 count
+) {
+    for (Uint32 i = 0; i < count; i++)
+        release_mesh (device, &primitives[i].mesh);
+}
+
+// Returns 0 on success, 1 on failure
+int load_glb (SDL_GPUDevice* device, const char* path, GltfModel* out) {
+    PROFILE_ZONE ("load_glb");
+    MappedFile file;
+    if (map_file (path, &file)) {
+        SDL_Log ("Failed to open %s", path);
+        return 1;
+    }
+    GltfDocument doc = {0};
+    if (parse_glb (&file, path, &doc)) {
+        // logging handled in parse_glb()
+        free (doc.json.tokens);
+        free (doc.accessors);
+        unmap_file (&file);
+        return 1;
+    }
+
+    // traversal scratch in one block: world transforms, mesh node order,
+    // stack and visited flags
+    Uint32 node_count = doc.node_count;
+    Uint8* scratch = (Uint8*) calloc (
+        (size_t) node_count + 1, sizeof (Trs) + 2 * sizeof (Uint32) + 1
+    );
+    if (!scratch) {
+        SDL_Log ("Failed to allocate glTF node scratch");
+        free (doc.json.tokens);
+        free (doc.accessors);
+        unmap_file (&file);
+        return 1;
+    }
+    Trs* world = (Trs*) scratch;
+    Uint32* order = (Uint32*) (world + node_count);
+    Uint32* stack = order + node_count;
+    Uint8* visited = (Uint8*) (stack + node_count);
+    Uint32 mesh_nodes = flatten_nodes (&doc, order, world, stack, visited);
+
+    const Json* json = &doc.json;
+    Uint32 total = 0;
+    for (Uint32 i = 0; i < mesh_nodes; i++) {
+        Uint32 m = json_uint (json, doc.nodes[order[i]], "mesh", JSON_NONE);
+        if (m >= doc.mesh_count) continue;
+        Uint32 list = json_get (json, doc.meshes[m], "primitives");
+        total += json_length (json, list);
+    }
+
+    GltfPrimitive* primitives =
+        (GltfPrimitive*) calloc (total + 1, sizeof (GltfPrimitive));
+    DirectUpload* uploads =
+        (DirectUpload*) calloc (total + 1, sizeof (DirectUpload));
+    Uint32* mesh_first =
+        (Uint32*) malloc (((size_t) doc.mesh_count + 1) * 2 * sizeof (Uint32));
+    if (!primitives || !uploads || !mesh_first) {
+        SDL_Log ("Failed to allocate glTF primitives");
+        free (primitives);
+        free (uploads);
+        free (mesh_first);
+        free (scratch);
+        free (doc.json.tokens);
+        free (doc.accessors);
+        unmap_file (&file);
+        return 1;
+    }
+    Uint32* mesh_loaded = mesh_first + doc.mesh_count + 1;
+
+    // the first node using a mesh loads its primitives, later ones share
+    // them: first primitive and how many loaded, per glTF mesh
+    for (Uint32 m = 0; m < doc.mesh_count; m++) mesh_first[m] = JSON_NONE;
+    Uint32 count = 0;
+    for (Uint32 i = 0; i < mesh_nodes; i++) {
+        Uint32 m = json_uint (json, doc.nodes[order[i]], "mesh", JSON_NONE);
+        if (m >= doc.mesh_count) {
+            SDL_Log ("glTF mesh %u does not exist", m);
+            continue;
+        }
+        TransformComponent transform = trs_to_engine (world[order[i]]);
+        if (mesh_first[m] != JSON_NONE) {
+            for (Uint32 k = 0; k < mesh_loaded[m]; k++) {
+                GltfPrimitive* source = &primitives[mesh_first[m] + k];
+                uploads[count] = (DirectUpload) {0};
+                if (share_mesh (&source->mesh, &primitives[count].mesh))
+                    continue; // logging handled in share_mesh()
+                primitives[count++].transform = transform;
+            }
+            continue;
+        }
+        mesh_first[m] = count;
+        Uint32 list = json_get (json, doc.meshes[m], "primitives");
+        Uint32 end = json_length (json, list) ? json->tokens[list].next : 0;
+        for (Uint32 t = list + 1; t < end; t = json->tokens[t].next) {
+            uploads[count] = (DirectUpload) {0};
+            if (load_primitive (
+                    device, &doc, t, &primitives[count].mesh, &uploads[count]
+                ))
+                continue; // logging handled in load_primitive()
+            primitives[count++].transform = transform;
+        }
+        mesh_loaded[m] = count - mesh_first[m];
+    }
+
+    int failed = upload_direct (device, primitives, uploads, count);
+    if (failed) {
+        // logging handled in upload_direct()
+        release_primitives (device, primitives, count);
+        free (primitives);
+    } else {
+        SDL_LogDebug (
+            SDL_LOG_CATEGORY_APPLICATION, "Loaded %u primitives from %s",
+            count, path
+        );
+        *out = (GltfModel) {.primitives = primitives, .primitive_count = count};
+    }
+
+    free (uploads);
+    free (mesh_first);
+    free (scratch);
+    free (doc.json.tokens);
+    free (doc.accessors);
+    unmap_file (&file);
+    return failed;
+}
+
+void free_gltf_model (GltfModel* model) {
+    free (model->primitives);
+    model->primitives = NULL;
+    model->primitive_count = 0;
+}
@@ -4,8 +4,10 @@
 #include <geometry/g_common.h>
 #include <geometry/icosahedron.h>
 #include <math/matrix.h>
+#include <profiler/profiler.h>
 
 MeshComponent create_icosahedron_mesh (float radius, SDL_GPUDevice* device) {
+    PROFILE_ZONE ("create_icosahedron_mesh");
     MeshComponent null_mesh = (MeshComponent) {0};
     const int num_vertices = 12;
     float* vertices = (float*) malloc (num_vertices * 8 * sizeof (float));
@@ -71,30 +73,27 @@ MeshComponent create_icosahedron_mesh (float radius, SDL_GPUDevice* device) {
 
     // Compute normals using standard_indices
     compute_vertex_normals (
-        vertices, num_vertices, standard_indices, 60, 8, 0, 3
+        vertices, num_vertices, standard_indices,
+        SDL_GPU_INDEXELEMENTSIZE_16BIT, 60, 8, 0, 3, NORMAL_WEIGHT_FACE
     );
 
-    SDL_GPUBuffer* vbo = NULL;
-    Uint64 vertices_size = num_vertices * 8 * sizeof (float);
-    int vbo_failed = upload_vertices (device, vertices, vertices_size, &vbo);
+    MeshComponent out_mesh = {0};
+    int vbo_failed = upload_mesh_vertices (
+        device, vertices, (Uint32) num_vertices, &out_mesh
+    );
     free (vertices);
     if (vbo_failed) return null_mesh;
 
-    SDL_GPUBuffer* ibo = NULL;
     Uint64 indices_size = 60 * sizeof (Uint16);
     int ibo_failed =
-        upload_indices (device, standard_indices, indices_size, &ibo);
+        upload_indices (device, standard_indices, indices_size, &out_mesh);
     if (ibo_failed) {
-        SDL_ReleaseGPUBuffer (device, vbo);
+        release_mesh_buffers (device, &out_mesh);
         return null_mesh;
     }
 
-    MeshComponent out_mesh =
-        (MeshComponent) {.vertex_buffer = vbo,
-                         .num_vertices = (Uint32) num_vertices,
-                         .index_buffer = ibo,
-                         .num_indices = 60,
-                         .index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT};
+    out_mesh.num_indices = 60;
+    out_mesh.index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
 
     return out_mesh;
 }
\ No newline at end of file
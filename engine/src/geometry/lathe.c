@@ -4,41 +4,38 @@
 #include <geometry/g_common.h>
 #include <geometry/lathe.h>
 #include <math/matrix.h>
+#include <profiler/profiler.h>
 
-MeshComponent create_lathe_mesh (
-    vec2* points,
+// Returns 0 on success, 1 on failure
+int build_lathe_mesh (
+    const vec2* points,
     int num_points,
     int phi_segments,
     float phi_start,
     float phi_length,
-    SDL_GPUDevice* device
+    MeshData* out
 ) {
-    MeshComponent null_mesh = (MeshComponent) {0};
+    PROFILE_ZONE ("build_lathe_mesh");
     if (num_points < 2) {
         SDL_Log ("Lathe requires at least 2 points");
-        return null_mesh;
+        return 1;
     }
     if (phi_segments < 3) {
         SDL_Log ("Lathe requires at least 3 phi segments");
-        return null_mesh;
+        return 1;
     }
 
     int num_phi = phi_segments + 1; // Rings closed
     int num_vertices = num_points * num_phi;
-
-    // Check for Uint16 overflow (max 65535 verts); extend to Uint32 if needed
-    // later
-    if (num_vertices > 65535) {
-        SDL_Log ("Lathe mesh too large for Uint16 indices");
-        return null_mesh;
-    }
+    SDL_GPUIndexElementSize index_size =
+        choose_index_size ((Uint32) num_vertices);
 
     float* vertices = (float*) malloc (
         num_vertices * 8 * sizeof (float)
     ); // pos.x,y,z + normal.x,y,z + uv.u,v
     if (!vertices) {
         SDL_Log ("Failed to allocate vertices for lathe mesh");
-        return null_mesh;
+        return 1;
     }
 
     // Generate vertices
@@ -75,64 +72,69 @@ MeshComponent create_lathe_mesh (
 
     // Generate indices (quads between rings, flipped winding for outward faces)
     int num_indices = (num_points - 1) * phi_segments * 6;
-    Uint16* indices = (Uint16*) malloc (num_indices * sizeof (Uint16));
+    void* indices = alloc_indices ((Uint32) num_indices, index_size);
     if (!indices) {
         SDL_Log ("Failed to allocate indices for lathe mesh");
         free (vertices);
-        return null_mesh;
+        return 1;
     }
 
     int index_idx = 0;
     for (int i = 0; i < num_points - 1; i++) {
         for (int j = 0; j < phi_segments; j++) {
-            Uint16 a = (Uint16) (i * num_phi + j);
-            Uint16 b =
-                (Uint16) (i * num_phi + (j + 1) % phi_segments); // Wrap phi
-            Uint16 c = (Uint16) ((i + 1) * num_phi + (j + 1) % phi_segments);
-            Uint16 d = (Uint16) ((i + 1) * num_phi + j);
+            Uint32 a = (Uint32) (i * num_phi + j);
+            Uint32 b =
+                (Uint32) (i * num_phi + (j + 1) % phi_segments); // Wrap phi
+            Uint32 c = (Uint32) ((i + 1) * num_phi + (j + 1) % phi_segments);
+            Uint32 d = (Uint32) ((i + 1) * num_phi + j);
 
             // Flipped winding: a -> c -> b and a -> d -> c (counterclockwise if
             // original was clockwise)
-            indices[index_idx++] = a;
-            indices[index_idx++] = c;
-            indices[index_idx++] = b;
+            set_index (indices, index_size, index_idx++, a);
+            set_index (indices, index_size, index_idx++, c);
+            set_index (indices, index_size, index_idx++, b);
 
-            indices[index_idx++] = a;
-            indices[index_idx++] = d;
-            indices[index_idx++] = c;
+            set_index (indices, index_size, index_idx++, a);
+            set_index (indices, index_size, index_idx++, d);
+            set_index (indices, index_size, index_idx++, c);
         }
     }
 
     // Compute normals
     compute_vertex_normals (
-        vertices, num_vertices, indices, num_indices, 8, 0, 3
+        vertices, num_vertices, indices, index_size, num_indices, 8, 0, 3,
+        NORMAL_WEIGHT_FACE
     );
 
-    // Upload to GPU
-    SDL_GPUBuffer* vbo = NULL;
-    Uint64 vertices_size = num_vertices * 8 * sizeof (float);
-    int vbo_failed = upload_vertices (device, vertices, vertices_size, &vbo);
-    free (vertices);
-    if (vbo_failed) {
-        free (indices);
-        return null_mesh; // Logging handled in upload_vertices
-    }
-
-    SDL_GPUBuffer* ibo = NULL;
-    Uint64 indices_size = num_indices * sizeof (Uint16);
-    int ibo_failed = upload_indices (device, indices, indices_size, &ibo);
-    free (indices);
-    if (ibo_failed) {
-        SDL_ReleaseGPUBuffer (device, vbo);
-        return null_mesh; // Logging handled in upload_indices
-    }
+    // on failure the buffers keep generation order; logging handled inside
+    optimize_mesh (
+        vertices, (Uint32) num_vertices, 8, indices, index_size,
+        (Uint32) num_indices
+    );
 
-    MeshComponent out_mesh =
-        (MeshComponent) {.vertex_buffer = vbo,
-                         .num_vertices = (Uint32) num_vertices,
-                         .index_buffer = ibo,
-                         .num_indices = (Uint32) num_indices,
-                         .index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT};
+    return make_mesh_data (
+        vertices, (Uint32) num_vertices, indices, (Uint32) num_indices,
+        index_size, out
+    ); // logging handled in make_mesh_data()
+}
 
-    return out_mesh;
-}
\ No newline at end of file
+MeshComponent create_lathe_mesh (
+    vec2* points,
+    int num_points,
+    int phi_segments,
+    float phi_start,
+    float phi_length,
+    SDL_GPUDevice* device
+) {
+    PROFILE_ZONE ("create_lathe_mesh");
+    MeshData data;
+    if (build_lathe_mesh (
+            points, num_points, phi_segments, phi_start, phi_length, &data
+        ))
+        return (MeshComponent) {0}; // logging handled in build_lathe_mesh()
+
+    MeshComponent mesh = {0};
+    upload_mesh_data (device, &data, &mesh); // logging handled inside
+    free_mesh_data (&data);
+    return mesh;
+}
@@ -0,0 +1,439 @@
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include <geometry/g_common.h>
+#include <geometry/mesh_cache.h>
+#include <gpu/buffer_heap.h>
+#include <profiler/profiler.h>
+
+#define AMESH_ALIGN_UP(x) \
+    (((x) + AMESH_ALIGN - 1) & ~(Uint64) (AMESH_ALIGN - 1))
+
+static Uint64 fnv1a (Uint64 hash, const void* data, size_t size) {
+    const Uint8* bytes = (const Uint8*) data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+void mesh_cache_path (
+    char* out,
+    size_t out_size,
+    const char* dir,
+    const char* name,
+    const void* params,
+    size_t params_size
+) {
+    Uint32 layout = (Uint32) get_mesh_vertex_layout ();
+    Uint32 version = AMESH_VERSION;
+    Uint64 hash = 0xcbf29ce484222325ull;
+    hash = fnv1a (hash, params, params_size);
+    hash = fnv1a (hash, &layout, sizeof (layout));
+    hash = fnv1a (hash, &version, sizeof (version));
+    SDL_snprintf (
+        out, out_size, "%s/%s_%016llx.amesh", dir, name,
+        (unsigned long long) hash
+    );
+}
+
+// ---- loading ----
+
+// Returns 0 if the header matches what this build would write
+static int check_header (const MappedFile* file) {
+    if (file->size < sizeof (AMeshHeader)) return 1;
+    const AMeshHeader* header = (const AMeshHeader*) file->data;
+    if (header->magic != AMESH_MAGIC || header->version != AMESH_VERSION)
+        return 1;
+    if (header->layout != (Uint32) get_mesh_vertex_layout ()) return 1;
+    if (header->level_count == 0) return 1;
+
+    SDL_GPUVertexAttribute attributes[VERTEX_ATTRIBUTE_COUNT];
+    SDL_GPUVertexBufferDescription buffers[VERTEX_ATTRIBUTE_COUNT];
+    if (get_vertex_layout (header->layout, attributes, buffers) != 1)
+        return 1; // only interleaved layouts are cached
+    if (header->vertex_stride != buffers[0].pitch) return 1;
+    if (header->attribute_count != VERTEX_ATTRIBUTE_COUNT) return 1;
+    for (Uint32 i = 0; i < VERTEX_ATTRIBUTE_COUNT; i++) {
+        if (header->attributes[i].format != (Uint32) attributes[i].format ||
+            header->attributes[i].offset != attributes[i].offset)
+            return 1;
+    }
+
+    Uint64 levels_end = sizeof (AMeshHeader) +
+                        (Uint64) header->level_count * sizeof (AMeshLevel);
+    if (levels_end > file->size) return 1;
+    return 0;
+}
+
+// Returns 0 if the blob lies inside the file and fits a GPU buffer
+static int check_blob (const MappedFile* file, Uint64 offset, Uint64 size) {
+    if (offset % AMESH_ALIGN || size == 0 || size > SDL_MAX_UINT32) return 1;
+    if (offset > file->size || size > file->size - offset) return 1;
+    return 0;
+}
+
+static void release_level_buffers (
+    SDL_GPUDevice* device,
+    MeshComponent* meshes,
+    Uint32 count
+) {
+    for (Uint32 i = 0; i < count; i++)
+        release_mesh_buffers (device, &meshes[i]);
+}
+
+// Returns 0 on success, 1 on failure
+// copies [start, end) of the file into one transfer buffer and uploads every
+// level's blobs from it in a single copy pass
+static int upload_levels (
+    SDL_GPUDevice* device,
+    const MappedFile* file,
+    const AMeshLevel* levels,
+    Uint32 level_count,
+    Uint64 start,
+    Uint64 end,
+    const MeshComponent* meshes
+) {
+    SDL_GPUTransferBufferCreateInfo trans_info = {
+        .size = (Uint32) (end - start),
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
+    };
+    SDL_GPUTransferBuffer* trans_buf =
+        SDL_CreateGPUTransferBuffer (device, &trans_info);
+    if (!trans_buf) {
+        SDL_Log ("Failed to create transfer buffer: %s", SDL_GetError ());
+        return 1;
+    }
+
+    void* data = SDL_MapGPUTransferBuffer (device, trans_buf, false);
+    if (!data) {
+        SDL_Log ("Failed to map transfer buffer: %s", SDL_GetError ());
+        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+        return 1;
+    }
+    memcpy (data, file->data + start, (size_t) (end - start));
+    SDL_UnmapGPUTransferBuffer (device, trans_buf);
+
+    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (device);
+    if (!cmd) {
+        SDL_Log ("Failed to acquire command buffer: %s", SDL_GetError ());
+        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+        return 1;
+    }
+
+    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass (cmd);
+    if (!copy_pass) {
+        SDL_Log ("Failed to begin copy pass: %s", SDL_GetError ());
+        SDL_SubmitGPUCommandBuffer (cmd);
+        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+        return 1;
+    }
+
+    for (Uint32 i = 0; i < level_count; i++) {
+        SDL_GPUTransferBufferLocation src_loc = {
+            .transfer_buffer = trans_buf,
+            .offset = (Uint32) (levels[i].vertex_offset - start)
+        };
+        SDL_GPUBufferRegion dst_reg = {
+            .buffer = meshes[i].vertex_buffer,
+            .offset = meshes[i].vertex_offset,
+            .size = (Uint32) levels[i].vertex_size
+        };
+        SDL_UploadToGPUBuffer (copy_pass, &src_loc, &dst_reg, false);
+
+        src_loc.offset = (Uint32) (levels[i].index_offset - start);
+        dst_reg.buffer = meshes[i].index_buffer;
+        dst_reg.offset = meshes[i].index_offset;
+        dst_reg.size = (Uint32) levels[i].index_size;
+        SDL_UploadToGPUBuffer (copy_pass, &src_loc, &dst_reg, false);
+    }
+    SDL_EndGPUCopyPass (copy_pass);
+    SDL_SubmitGPUCommandBuffer (cmd);
+
+    SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+    return 0;
+}
+
+// everything but the buffers
+static MeshComponent
+level_mesh (const AMeshHeader* header, const AMeshLevel* level) {
+    return (MeshComponent) {
+        .num_vertices = level->num_vertices,
+        .num_indices = level->num_indices,
+        .index_size = level->index_size_bits == 32
+                          ? SDL_GPU_INDEXELEMENTSIZE_32BIT
+                          : SDL_GPU_INDEXELEMENTSIZE_16BIT,
+        .layout = (VertexLayout) header->layout,
+        .pos_scale =
+            {level->pos_scale[0], level->pos_scale[1], level->pos_scale[2]},
+        .pos_offset =
+            {level->pos_offset[0], level->pos_offset[1], level->pos_offset[2]},
+        .radius = header->radius
+    };
+}
+
+// Returns 0 on success, 1 on failure (missing or stale files fail quietly)
+int load_mesh_cache (
+    SDL_GPUDevice* device,
+    const char* path,
+    MeshComponent* out
+) {
+#if SDL_BYTEORDER != SDL_LIL_ENDIAN
+    (void) device;
+    (void) path;
+    (void) out;
+    return 1; // the format is little-endian only
+#else
+    PROFILE_ZONE ("load_mesh_cache");
+    MappedFile file;
+    if (map_file (path, &file)) return 1;
+    if (check_header (&file)) {
+        unmap_file (&file);
+        return 1;
+    }
+
+    const AMeshHeader* header = (const AMeshHeader*) file.data;
+    const AMeshLevel* levels =
+        (const AMeshLevel*) (file.data + sizeof (AMeshHeader));
+    Uint32 level_count = header->level_count;
+
+    // the blobs sit back to back after the level table
+    Uint64 start = UINT64_MAX;
+    Uint64 end = 0;
+    for (Uint32 i = 0; i < level_count; i++) {
+        const AMeshLevel* level = &levels[i];
+        Uint32 index_bytes = level->index_size_bits / 8;
+        if ((level->index_size_bits != 16 && level->index_size_bits != 32) ||
+            level->vertex_size !=
+                (Uint64) level->num_vertices * header->vertex_stride ||
+            level->index_size != (Uint64) level->num_indices * index_bytes ||
+            check_blob (&file, level->vertex_offset, level->vertex_size) ||
+            check_blob (&file, level->index_offset, level->index_size)) {
+            SDL_Log ("Ignoring corrupt mesh cache %s", path);
+            unmap_file (&file);
+            return 1;
+        }
+        start = SDL_min (start, level->vertex_offset);
+        start = SDL_min (start, level->index_offset);
+        end = SDL_max (end, level->vertex_offset + level->vertex_size);
+        end = SDL_max (end, level->index_offset + level->index_size);
+    }
+    if (end - start > SDL_MAX_UINT32) {
+        SDL_Log ("Ignoring oversized mesh cache %s", path);
+        unmap_file (&file);
+        return 1;
+    }
+
+    MeshComponent* meshes =
+        (MeshComponent*) calloc (level_count, sizeof (MeshComponent));
+    MeshComponent* lods = NULL;
+    if (level_count > 1)
+        lods = (MeshComponent*) malloc (
+            (level_count - 1) * sizeof (MeshComponent)
+        );
+    if (!meshes || (level_count > 1 && !lods)) {
+        SDL_Log ("Failed to allocate mesh cache levels");
+        free (meshes);
+        free (lods);
+        unmap_file (&file);
+        return 1;
+    }
+
+    for (Uint32 i = 0; i < level_count; i++) {
+        MeshComponent* mesh = &meshes[i];
+        *mesh = level_mesh (header, &levels[i]);
+        if (buffer_heap_alloc (
+                device, BUFFER_HEAP_VERTEX, (Uint32) levels[i].vertex_size,
+                &mesh->vertex_buffer, &mesh->vertex_offset
+            ) ||
+            buffer_heap_alloc (
+                device, BUFFER_HEAP_INDEX, (Uint32) levels[i].index_size,
+                &mesh->index_buffer, &mesh->index_offset
+            )) {
+            // logging handled in buffer_heap_alloc()
+            release_level_buffers (device, meshes, i + 1);
+            free (meshes);
+            free (lods);
+            unmap_file (&file);
+            return 1;
+        }
+    }
+
+    if (upload_levels (
+            device, &file, levels, level_count, start, end, meshes
+        )) {
+        // logging handled in upload_levels()
+        release_level_buffers (device, meshes, level_count);
+        free (meshes);
+        free (lods);
+        unmap_file (&file);
+        return 1;
+    }
+
+    *out = meshes[0];
+    for (Uint32 i = 1; i < level_count; i++) lods[i - 1] = meshes[i];
+    out->lod_count = level_count - 1;
+    out->lods = lods;
+
+    free (meshes);
+    unmap_file (&file);
+    return 0;
+#endif
+}
+
+// ---- writing ----
+
+static void compute_bounds (const MeshData* data, AMeshHeader* header) {
+    const MeshComponent* mesh = &data->mesh;
+    if (mesh->layout == VERTEX_LAYOUT_COMPACT) {
+        // positions are quantized within offset +- scale
+        const float* offset = &mesh->pos_offset.x;
+        const float* scale = &mesh->pos_scale.x;
+        for (int k = 0; k < 3; k++) {
+            header->bounds_min[k] = offset[k] - scale[k];
+            header->bounds_max[k] = offset[k] + scale[k];
+        }
+        return;
+    }
+
+    for (int k = 0; k < 3; k++) {
+        header->bounds_min[k] = mesh->num_vertices ? FLT_MAX : 0.0f;
+        header->bounds_max[k] = mesh->num_vertices ? -FLT_MAX : 0.0f;
+    }
+    const float* v = (const float*) data->vertices;
+    for (Uint32 i = 0; i < mesh->num_vertices; i++) {
+        for (int k = 0; k < 3; k++) {
+            float p = v[i * 8 + k];
+            header->bounds_min[k] = SDL_min (header->bounds_min[k], p);
+            header->bounds_max[k] = SDL_max (header->bounds_max[k], p);
+        }
+    }
+}
+
+// Returns 0 on success, 1 on failure
+static int write_padded (SDL_IOStream* io, const void* data, Uint64 size) {
+    static const Uint8 zeros[AMESH_ALIGN] = {0};
+    if (SDL_WriteIO (io, data, (size_t) size) != size) return 1;
+    Uint64 padding = AMESH_ALIGN_UP (size) - size;
+    if (padding && SDL_WriteIO (io, zeros, (size_t) padding) != padding)
+        return 1;
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+int write_mesh_cache (
+    const char* path,
+    const MeshData* levels,
+    Uint32 level_count
+) {
+    PROFILE_ZONE ("write_mesh_cache");
+    if (level_count == 0) {
+        SDL_Log ("A cached mesh needs at least one level");
+        return 1;
+    }
+    const MeshComponent* mesh = &levels[0].mesh;
+    AMeshHeader header = {
+        .magic = AMESH_MAGIC,
+        .version = AMESH_VERSION,
+        .layout = (Uint32) mesh->layout,
+        .attribute_count = VERTEX_ATTRIBUTE_COUNT,
+        .level_count = level_count,
+        .radius = mesh->radius
+    };
+    SDL_GPUVertexAttribute attributes[VERTEX_ATTRIBUTE_COUNT];
+    SDL_GPUVertexBufferDescription buffers[VERTEX_ATTRIBUTE_COUNT];
+    if (get_vertex_layout (mesh->layout, attributes, buffers) != 1) {
+        SDL_Log ("Only interleaved meshes can be cached");
+        return 1;
+    }
+    header.vertex_stride = buffers[0].pitch;
+    for (Uint32 i = 0; i < VERTEX_ATTRIBUTE_COUNT; i++) {
+        header.attributes[i] = (AMeshAttribute) {
+            .format = (Uint32) attributes[i].format,
+            .offset = attributes[i].offset
+        };
+    }
+    compute_bounds (&levels[0], &header);
+
+    AMeshLevel* entries =
+        (AMeshLevel*) calloc (level_count, sizeof (AMeshLevel));
+    if (!entries) {
+        SDL_Log ("Failed to allocate mesh cache levels");
+        return 1;
+    }
+
+    Uint64 offset = AMESH_ALIGN_UP (
+        sizeof (AMeshHeader) + (Uint64) level_count * sizeof (AMeshLevel)
+    );
+    for (Uint32 i = 0; i < level_count; i++) {
+        const MeshData* src = &levels[i];
+        Uint32 index_bytes = index_size_bytes (src->mesh.index_size);
+        if (src->mesh.layout != mesh->layout ||
+            src->vertices_size !=
+                (Uint64) src->mesh.num_vertices * header.vertex_stride ||
+            src->indices_size != (Uint64) src->mesh.num_indices * index_bytes) {
+            SDL_Log ("Mesh cache level %u does not match its data", i);
+            free (entries);
+            return 1;
+        }
+
+        AMeshLevel* level = &entries[i];
+        level->num_vertices = src->mesh.num_vertices;
+        level->num_indices = src->mesh.num_indices;
+        level->index_size_bits = 8 * index_bytes;
+        level->pos_scale[0] = src->mesh.pos_scale.x;
+        level->pos_scale[1] = src->mesh.pos_scale.y;
+        level->pos_scale[2] = src->mesh.pos_scale.z;
+        level->pos_offset[0] = src->mesh.pos_offset.x;
+        level->pos_offset[1] = src->mesh.pos_offset.y;
+        level->pos_offset[2] = src->mesh.pos_offset.z;
+        level->vertex_offset = offset;
+        level->vertex_size = src->vertices_size;
+        offset += AMESH_ALIGN_UP (src->vertices_size);
+        level->index_offset = offset;
+        level->index_size = src->indices_size;
+        offset += AMESH_ALIGN_UP (src->indices_size);
+    }
+
+    // written beside the target and renamed so readers never see half a file
+    char temp_path[1024];
+    if (SDL_snprintf (temp_path, sizeof (temp_path), "%s.tmp", path) >=
+        (int) sizeof (temp_path)) {
+        SDL_Log ("Mesh cache path is too long: %s", path);
+        free (entries);
+        return 1;
+    }
+    SDL_IOStream* io = SDL_IOFromFile (temp_path, "wb");
+    if (!io) {
+        SDL_Log ("Failed to open %s: %s", temp_path, SDL_GetError ());
+        free (entries);
+        return 1;
+    }
+
+    int failed = SDL_WriteIO (io, &header, sizeof (header)) != sizeof (header);
+    if (!failed)
+        failed = write_padded (
+            io, entries, (Uint64) level_count * sizeof (AMeshLevel)
+        );
+    for (Uint32 i = 0; i < level_count && !failed; i++) {
+        failed = write_padded (io, levels[i].vertices, levels[i].vertices_size);
+        if (!failed)
+            failed =
+                write_padded (io, levels[i].indices, levels[i].indices_size);
+    }
+    free (entries);
+
+    if (!SDL_CloseIO (io)) failed = 1;
+    if (!failed && !SDL_RenamePath (temp_path, path)) failed = 1;
+    if (failed) {
+        SDL_Log ("Failed to write %s: %s", path, SDL_GetError ());
+        SDL_RemovePath (temp_path);
+        return 1;
+    }
+    return 0;
+}
@@ -4,8 +4,10 @@
 #include <geometry/g_common.h>
 #include <geometry/octahedron.h>
 #include <math/matrix.h>
+#include <profiler/profiler.h>
 
 MeshComponent create_octahedron_mesh (float radius, SDL_GPUDevice* device) {
+    PROFILE_ZONE ("create_octahedron_mesh");
     MeshComponent null_mesh = (MeshComponent) {0};
     const int num_vertices = 6;
     float vertices[6 * 8] = {0};
@@ -41,29 +43,25 @@ MeshComponent create_octahedron_mesh (float radius, SDL_GPUDevice* device) {
 
     // Compute normals
     compute_vertex_normals (
-        vertices, num_vertices, indices, sizeof (indices) / sizeof (Uint16), 8,
-        0, 3
+        vertices, num_vertices, indices, SDL_GPU_INDEXELEMENTSIZE_16BIT,
+        sizeof (indices) / sizeof (Uint16), 8, 0, 3, NORMAL_WEIGHT_FACE
     );
 
-    SDL_GPUBuffer* vbo = NULL;
-    Uint64 vertices_size = sizeof (vertices);
-    int vbo_failed = upload_vertices (device, vertices, vertices_size, &vbo);
+    MeshComponent out_mesh = {0};
+    int vbo_failed = upload_mesh_vertices (
+        device, vertices, (Uint32) num_vertices, &out_mesh
+    );
     if (vbo_failed) return null_mesh;
 
-    SDL_GPUBuffer* ibo = NULL;
     Uint64 indices_size = sizeof (indices);
-    int ibo_failed = upload_indices (device, indices, indices_size, &ibo);
+    int ibo_failed = upload_indices (device, indices, indices_size, &out_mesh);
     if (ibo_failed) {
-        SDL_ReleaseGPUBuffer (device, vbo);
+        release_mesh_buffers (device, &out_mesh);
         return null_mesh;
     }
 
-    MeshComponent out_mesh =
-        (MeshComponent) {.vertex_buffer = vbo,
-                         .num_vertices = (Uint32) num_vertices,
-                         .index_buffer = ibo,
-                         .num_indices = sizeof (indices) / sizeof (Uint16),
-                         .index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT};
+    out_mesh.num_indices = sizeof (indices) / sizeof (Uint16);
+    out_mesh.index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
 
     return out_mesh;
 }
\ No newline at end of file
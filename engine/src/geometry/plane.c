@@ -2,6 +2,7 @@
 
 #include <geometry/g_common.h>
 #include <geometry/plane.h>
+#include <profiler/profiler.h>
 
 MeshComponent create_plane_mesh (
     float width,
@@ -10,19 +11,15 @@ MeshComponent create_plane_mesh (
     int height_segments,
     SDL_GPUDevice* device
 ) {
+    PROFILE_ZONE ("create_plane_mesh");
     MeshComponent null_mesh = (MeshComponent) {0};
     if (width_segments < 1) width_segments = 1;
     if (height_segments < 1) height_segments = 1;
 
     int num_vertices = (width_segments + 1) * (height_segments + 1);
     int num_indices = width_segments * height_segments * 6;
-
-    // Check for Uint16 overflow (max 65535 verts); fallback to Uint32 if needed
-    // For now, assume small segments; add Uint32 support later if required
-    if (num_vertices > 65535) {
-        SDL_Log ("Plane mesh too large for Uint16 indices");
-        return null_mesh;
-    }
+    SDL_GPUIndexElementSize index_size =
+        choose_index_size ((Uint32) num_vertices);
 
     float* vertices = (float*) malloc (
         num_vertices * 8 * sizeof (float)
@@ -32,7 +29,7 @@ MeshComponent create_plane_mesh (
         return null_mesh;
     }
 
-    Uint16* indices = (Uint16*) malloc (num_indices * sizeof (Uint16));
+    void* indices = alloc_indices ((Uint32) num_indices, index_size);
     if (!indices) {
         SDL_Log ("Failed to allocate indices for plane mesh");
         free (vertices);
@@ -66,46 +63,49 @@ MeshComponent create_plane_mesh (
     int index_idx = 0;
     for (int iy = 0; iy < height_segments; iy++) {
         for (int ix = 0; ix < width_segments; ix++) {
-            Uint16 a = (Uint16) (iy * (width_segments + 1) + ix);
-            Uint16 b = (Uint16) (iy * (width_segments + 1) + ix + 1);
-            Uint16 c = (Uint16) ((iy + 1) * (width_segments + 1) + ix + 1);
-            Uint16 d = (Uint16) ((iy + 1) * (width_segments + 1) + ix);
+            Uint32 a = (Uint32) (iy * (width_segments + 1) + ix);
+            Uint32 b = (Uint32) (iy * (width_segments + 1) + ix + 1);
+            Uint32 c = (Uint32) ((iy + 1) * (width_segments + 1) + ix + 1);
+            Uint32 d = (Uint32) ((iy + 1) * (width_segments + 1) + ix);
 
             // Triangle 1: a -> b -> c (clockwise)
-            indices[index_idx++] = a;
-            indices[index_idx++] = b;
-            indices[index_idx++] = c;
+            set_index (indices, index_size, index_idx++, a);
+            set_index (indices, index_size, index_idx++, b);
+            set_index (indices, index_size, index_idx++, c);
 
             // Triangle 2: a -> c -> d (clockwise)
-            indices[index_idx++] = a;
-            indices[index_idx++] = c;
-            indices[index_idx++] = d;
+            set_index (indices, index_size, index_idx++, a);
+            set_index (indices, index_size, index_idx++, c);
+            set_index (indices, index_size, index_idx++, d);
         }
     }
 
-    SDL_GPUBuffer* vbo = NULL;
-    Uint64 vertices_size = num_vertices * 8 * sizeof (float);
-    int vbo_failed = upload_vertices (device, vertices, vertices_size, &vbo);
+    // on failure the buffers keep generation order; logging handled inside
+    optimize_mesh (
+        vertices, (Uint32) num_vertices, 8, indices, index_size,
+        (Uint32) num_indices
+    );
+
+    MeshComponent out_mesh = {0};
+    int vbo_failed = upload_mesh_vertices (
+        device, vertices, (Uint32) num_vertices, &out_mesh
+    );
     free (vertices);
     if (vbo_failed) {
         free (indices);
-        return null_mesh; // logging handled in upload_vertices()
+        return null_mesh; // logging handled in upload_mesh_vertices()
     }
 
-    SDL_GPUBuffer* ibo = NULL;
-    Uint64 indices_size = num_indices * sizeof (Uint16);
-    int ibo_failed = upload_indices (device, indices, indices_size, &ibo);
+    Uint64 indices_size = num_indices * index_size_bytes (index_size);
+    int ibo_failed = upload_indices (device, indices, indices_size, &out_mesh);
     free (indices);
     if (ibo_failed) {
+        release_mesh_buffers (device, &out_mesh);
         return null_mesh; // logging handled in upload_indices()
     }
 
-    MeshComponent out_mesh =
-        (MeshComponent) {.vertex_buffer = vbo,
-                         .num_vertices = (Uint32) num_vertices,
-                         .index_buffer = ibo,
-                         .num_indices = (Uint32) num_indices,
-                         .index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT};
+    out_mesh.num_indices = (Uint32) num_indices;
+    out_mesh.index_size = index_size;
 
     return out_mesh;
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include <geometry/g_common.h>
 #include <geometry/ring.h>
+#include <profiler/profiler.h>
 
 MeshComponent create_ring_mesh (
     float inner_radius,
@@ -13,6 +14,7 @@ MeshComponent create_ring_mesh (
     float theta_length,
     SDL_GPUDevice* device
 ) {
+    PROFILE_ZONE ("create_ring_mesh");
     MeshComponent null_mesh = (MeshComponent) {0};
     if (theta_segments < 3) {
         SDL_Log ("Ring must have at least 3 theta segments");
@@ -31,10 +33,8 @@ MeshComponent create_ring_mesh (
     int num_phi = phi_segments + 1;
     int num_vertices = num_theta * num_phi;
 
-    if (num_vertices > 65535) {
-        SDL_Log ("Ring mesh too large for Uint16 indices");
-        return null_mesh;
-    }
+    SDL_GPUIndexElementSize index_size =
+        choose_index_size ((Uint32) num_vertices);
 
     float* vertices = (float*) malloc (
         num_vertices * 8 * sizeof (float)
@@ -75,7 +75,7 @@ MeshComponent create_ring_mesh (
     }
 
     int num_indices = theta_segments * phi_segments * 6;
-    Uint16* indices = (Uint16*) malloc (num_indices * sizeof (Uint16));
+    void* indices = alloc_indices ((Uint32) num_indices, index_size);
     if (!indices) {
         SDL_Log ("Failed to allocate indices for ring mesh");
         free (vertices);
@@ -85,47 +85,49 @@ MeshComponent create_ring_mesh (
     int index_idx = 0;
     for (int i = 0; i < theta_segments; i++) {
         for (int j = 0; j < phi_segments; j++) {
-            Uint16 a = (Uint16) (i * num_phi + j);
-            Uint16 b = (Uint16) (i * num_phi + j + 1);
-            Uint16 c = (Uint16) ((i + 1) * num_phi + j + 1);
-            Uint16 d = (Uint16) ((i + 1) * num_phi + j);
+            Uint32 a = (Uint32) (i * num_phi + j);
+            Uint32 b = (Uint32) (i * num_phi + j + 1);
+            Uint32 c = (Uint32) ((i + 1) * num_phi + j + 1);
+            Uint32 d = (Uint32) ((i + 1) * num_phi + j);
 
             // Clockwise winding to match circle geometry
-            indices[index_idx++] = a;
-            indices[index_idx++] = b;
-            indices[index_idx++] = c;
+            set_index (indices, index_size, index_idx++, a);
+            set_index (indices, index_size, index_idx++, b);
+            set_index (indices, index_size, index_idx++, c);
 
-            indices[index_idx++] = a;
-            indices[index_idx++] = c;
-            indices[index_idx++] = d;
+            set_index (indices, index_size, index_idx++, a);
+            set_index (indices, index_size, index_idx++, c);
+            set_index (indices, index_size, index_idx++, d);
         }
     }
 
+    // on failure the buffers keep generation order; logging handled inside
+    optimize_mesh (
+        vertices, (Uint32) num_vertices, 8, indices, index_size,
+        (Uint32) num_indices
+    );
+
     // Upload to GPU
-    SDL_GPUBuffer* vbo = NULL;
-    Uint64 vertices_size = num_vertices * 8 * sizeof (float);
-    int vbo_failed = upload_vertices (device, vertices, vertices_size, &vbo);
+    MeshComponent out_mesh = {0};
+    int vbo_failed = upload_mesh_vertices (
+        device, vertices, (Uint32) num_vertices, &out_mesh
+    );
     free (vertices);
     if (vbo_failed) {
         free (indices);
-        return null_mesh; // Logging handled in upload_vertices
+        return null_mesh; // Logging handled in upload_mesh_vertices
     }
 
-    SDL_GPUBuffer* ibo = NULL;
-    Uint64 indices_size = num_indices * sizeof (Uint16);
-    int ibo_failed = upload_indices (device, indices, indices_size, &ibo);
+    Uint64 indices_size = num_indices * index_size_bytes (index_size);
+    int ibo_failed = upload_indices (device, indices, indices_size, &out_mesh);
     free (indices);
     if (ibo_failed) {
-        SDL_ReleaseGPUBuffer (device, vbo);
+        release_mesh_buffers (device, &out_mesh);
         return null_mesh; // Logging handled in upload_indices
     }
 
-    MeshComponent out_mesh =
-        (MeshComponent) {.vertex_buffer = vbo,
-                         .num_vertices = (Uint32) num_vertices,
-                         .index_buffer = ibo,
-                         .num_indices = (Uint32) num_indices,
-                         .index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT};
+    out_mesh.num_indices = (Uint32) num_indices;
+    out_mesh.index_size = index_size;
 
     return out_mesh;
 }
\ No newline at end of file
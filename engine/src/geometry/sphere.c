@@ -1,10 +1,13 @@
 #include <math.h>
 #include <stdlib.h>
 
+#include <geometry/g_common.h>
 #include <geometry/lathe.h>
 #include <geometry/sphere.h>
+#include <profiler/profiler.h>
 
-MeshComponent create_sphere_mesh (
+// Returns 0 on success, 1 on failure
+int build_sphere_mesh (
     float radius,
     int width_segments,
     int height_segments,
@@ -12,21 +15,21 @@ MeshComponent create_sphere_mesh (
     float phi_length,
     float theta_start,
     float theta_length,
-    SDL_GPUDevice* device
+    MeshData* out
 ) {
-    MeshComponent null_mesh = (MeshComponent) {0};
+    PROFILE_ZONE ("build_sphere_mesh");
     if (width_segments < 3 || height_segments < 2) {
         SDL_Log (
             "Sphere must have at least 3 width segments and 2 height segments"
         );
-        return null_mesh;
+        return 1;
     }
 
     int num_points = height_segments + 1;
     vec2* points = (vec2*) malloc (num_points * sizeof (vec2));
     if (!points) {
         SDL_Log ("Failed to allocate points for sphere path");
-        return null_mesh;
+        return 1;
     }
 
     for (int i = 0; i < num_points; i++) {
@@ -40,9 +43,63 @@ MeshComponent create_sphere_mesh (
     }
 
     // lathe returns normals
-    MeshComponent mesh = create_lathe_mesh (
-        points, num_points, width_segments, phi_start, phi_length, device
+    int failed = build_lathe_mesh (
+        points, num_points, width_segments, phi_start, phi_length, out
     );
     free (points);
+    return failed; // logging handled in build_lathe_mesh()
+}
+
+MeshComponent create_sphere_mesh (
+    float radius,
+    int width_segments,
+    int height_segments,
+    float phi_start,
+    float phi_length,
+    float theta_start,
+    float theta_length,
+    SDL_GPUDevice* device
+) {
+    PROFILE_ZONE ("create_sphere_mesh");
+    MeshData data;
+    if (build_sphere_mesh (
+            radius, width_segments, height_segments, phi_start, phi_length,
+            theta_start, theta_length, &data
+        ))
+        return (MeshComponent) {0}; // logging handled in build_sphere_mesh()
+
+    MeshComponent mesh = {0};
+    upload_mesh_data (device, &data, &mesh); // logging handled inside
+    free_mesh_data (&data);
+    return mesh;
+}
+
+MeshComponent create_sphere_mesh_lods (
+    float radius,
+    int width_segments,
+    int height_segments,
+    float phi_start,
+    float phi_length,
+    float theta_start,
+    float theta_length,
+    int lod_count,
+    SDL_GPUDevice* device
+) {
+    MeshComponent mesh = create_sphere_mesh (
+        radius, width_segments, height_segments, phi_start, phi_length,
+        theta_start, theta_length, device
+    );
+    for (int i = 0; i < lod_count && mesh.vertex_buffer; i++) {
+        if (width_segments <= 3 && height_segments <= 2) break;
+        width_segments = SDL_max (width_segments / 2, 3);
+        height_segments = SDL_max (height_segments / 2, 2);
+
+        MeshComponent lod = create_sphere_mesh (
+            radius, width_segments, height_segments, phi_start, phi_length,
+            theta_start, theta_length, device
+        );
+        if (add_mesh_lod (device, &mesh, lod))
+            break; // logging handled in the generator or add_mesh_lod()
+    }
     return mesh;
 }
\ No newline at end of file
@@ -2,8 +2,10 @@
 
 #include <geometry/g_common.h>
 #include <geometry/tetrahedron.h>
+#include <profiler/profiler.h>
 
 MeshComponent create_tetrahedron_mesh (float radius, SDL_GPUDevice* device) {
+    PROFILE_ZONE ("create_tetrahedron_mesh");
     MeshComponent null_mesh = (MeshComponent) {0};
     // 4 vertices (positions + normals + UVs; simple UV projection for demo)
     const int num_vertices = 4;
@@ -45,28 +47,25 @@ MeshComponent create_tetrahedron_mesh (float radius, SDL_GPUDevice* device) {
 
     // Compute normals
     compute_vertex_normals (
-        vertices, num_vertices, indices, num_indices, 8, 0, 3
+        vertices, num_vertices, indices, SDL_GPU_INDEXELEMENTSIZE_16BIT,
+        num_indices, 8, 0, 3, NORMAL_WEIGHT_FACE
     );
 
-    SDL_GPUBuffer* vbo = NULL;
-    Uint64 vertices_size = num_vertices * 8 * sizeof (float);
-    int vbo_failed = upload_vertices (device, vertices, vertices_size, &vbo);
+    MeshComponent out_mesh = {0};
+    int vbo_failed = upload_mesh_vertices (
+        device, vertices, (Uint32) num_vertices, &out_mesh
+    );
     if (vbo_failed) return null_mesh;
 
-    SDL_GPUBuffer* ibo = NULL;
     Uint64 indices_size = num_indices * sizeof (Uint16);
-    int ibo_failed = upload_indices (device, indices, indices_size, &ibo);
+    int ibo_failed = upload_indices (device, indices, indices_size, &out_mesh);
     if (ibo_failed) {
-        SDL_ReleaseGPUBuffer (device, vbo);
+        release_mesh_buffers (device, &out_mesh);
         return null_mesh;
     }
 
-    MeshComponent out_mesh =
-        (MeshComponent) {.vertex_buffer = vbo,
-                         .num_vertices = (Uint32) num_vertices,
-                         .index_buffer = ibo,
-                         .num_indices = (Uint32) num_indices,
-                         .index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT};
+    out_mesh.num_indices = (Uint32) num_indices;
+    out_mesh.index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
 
     return out_mesh;
 }
\ No newline at end of file
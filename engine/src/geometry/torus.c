@@ -4,27 +4,29 @@
 #include <geometry/g_common.h>
 #include <geometry/torus.h>
 #include <math/matrix.h>
+#include <profiler/profiler.h>
 
-MeshComponent create_torus_mesh (
+// Returns 0 on success, 1 on failure
+int build_torus_mesh (
     float radius,
     float tube_radius,
     int radial_segments,
     int tubular_segments,
     float arc,
-    SDL_GPUDevice* device
+    MeshData* out
 ) {
-    MeshComponent null_mesh = (MeshComponent) {0};
+    PROFILE_ZONE ("build_torus_mesh");
     if (radial_segments < 3 || tubular_segments < 3) {
         SDL_Log ("Torus must have at least 3 segments in each direction");
-        return null_mesh;
+        return 1;
     }
     if (tube_radius <= 0.0f || radius <= 0.0f) {
         SDL_Log ("Torus radii must be positive");
-        return null_mesh;
+        return 1;
     }
     if (arc <= 0.0f || arc > 2.0f * (float) M_PI) {
         SDL_Log ("Torus arc must be between 0 and 2*PI");
-        return null_mesh;
+        return 1;
     }
 
     bool is_closed = fabsf (arc - 2.0f * (float) M_PI) < 1e-6f;
@@ -32,17 +34,15 @@ MeshComponent create_torus_mesh (
     int num_radial = radial_segments; // Always closed in radial direction
 
     int num_vertices = num_tubular * num_radial;
-    if (num_vertices > 65535) {
-        SDL_Log ("Torus mesh too large for Uint16 indices");
-        return null_mesh;
-    }
+    SDL_GPUIndexElementSize index_size =
+        choose_index_size ((Uint32) num_vertices);
 
     float* vertices = (float*) malloc (
         num_vertices * 8 * sizeof (float)
     ); // pos3 + norm3 + uv2
     if (!vertices) {
         SDL_Log ("Failed to allocate vertices for torus mesh");
-        return null_mesh;
+        return 1;
     }
 
     int vertex_idx = 0;
@@ -87,11 +87,11 @@ MeshComponent create_torus_mesh (
     int num_u_loops = tubular_segments;
     int num_r_loops = radial_segments;
     int num_indices = num_u_loops * num_r_loops * 6;
-    Uint16* indices = (Uint16*) malloc (num_indices * sizeof (Uint16));
+    void* indices = alloc_indices ((Uint32) num_indices, index_size);
     if (!indices) {
         SDL_Log ("Failed to allocate indices for torus mesh");
         free (vertices);
-        return null_mesh;
+        return 1;
     }
 
     int index_idx = 0;
@@ -104,48 +104,103 @@ MeshComponent create_torus_mesh (
         for (int ra = 0; ra < num_r_loops; ra++) {
             int ra1 = (ra + 1) % radial_segments;
 
-            Uint16 a = (Uint16) (tu * num_radial + ra);
-            Uint16 b = (Uint16) (tu1 * num_radial + ra);
-            Uint16 c = (Uint16) (tu1 * num_radial + ra1);
-            Uint16 d = (Uint16) (tu * num_radial + ra1);
+            Uint32 a = (Uint32) (tu * num_radial + ra);
+            Uint32 b = (Uint32) (tu1 * num_radial + ra);
+            Uint32 c = (Uint32) (tu1 * num_radial + ra1);
+            Uint32 d = (Uint32) (tu * num_radial + ra1);
 
             // Clockwise winding for front-face (matches
             // SDL_GPU_FRONTFACE_CLOCKWISE)
-            indices[index_idx++] = a;
-            indices[index_idx++] = d;
-            indices[index_idx++] = b;
+            set_index (indices, index_size, index_idx++, a);
+            set_index (indices, index_size, index_idx++, d);
+            set_index (indices, index_size, index_idx++, b);
 
-            indices[index_idx++] = b;
-            indices[index_idx++] = d;
-            indices[index_idx++] = c;
+            set_index (indices, index_size, index_idx++, b);
+            set_index (indices, index_size, index_idx++, d);
+            set_index (indices, index_size, index_idx++, c);
         }
     }
 
-    // Upload to GPU
-    SDL_GPUBuffer* vbo = NULL;
-    Uint64 vertices_size = num_vertices * 8 * sizeof (float);
-    if (upload_vertices (device, vertices, vertices_size, &vbo)) {
-        free (vertices);
-        free (indices);
-        return null_mesh; // Logging handled in upload_vertices
-    }
-    free (vertices);
-
-    SDL_GPUBuffer* ibo = NULL;
-    Uint64 indices_size = num_indices * sizeof (Uint16);
-    if (upload_indices (device, indices, indices_size, &ibo)) {
-        SDL_ReleaseGPUBuffer (device, vbo);
-        free (indices);
-        return null_mesh; // Logging handled in upload_indices
-    }
-    free (indices);
+    // on failure the buffers keep generation order; logging handled inside
+    optimize_mesh (
+        vertices, (Uint32) num_vertices, 8, indices, index_size,
+        (Uint32) num_indices
+    );
 
-    MeshComponent out_mesh =
-        (MeshComponent) {.vertex_buffer = vbo,
-                         .num_vertices = (Uint32) num_vertices,
-                         .index_buffer = ibo,
-                         .num_indices = (Uint32) num_indices,
-                         .index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT};
+    return make_mesh_data (
+        vertices, (Uint32) num_vertices, indices, (Uint32) num_indices,
+        index_size, out
+    ); // logging handled in make_mesh_data()
+}
 
-    return out_mesh;
-}
\ No newline at end of file
+MeshComponent create_torus_mesh (
+    float radius,
+    float tube_radius,
+    int radial_segments,
+    int tubular_segments,
+    float arc,
+    SDL_GPUDevice* device
+) {
+    PROFILE_ZONE ("create_torus_mesh");
+    MeshData data;
+    if (build_torus_mesh (
+            radius, tube_radius, radial_segments, tubular_segments, arc, &data
+        ))
+        return (MeshComponent) {0}; // logging handled in build_torus_mesh()
+
+    MeshComponent mesh = {0};
+    upload_mesh_data (device, &data, &mesh); // logging handled inside
+    free_mesh_data (&data);
+    return mesh;
+}
+
+Uint32 build_torus_mesh_lods (
+    float radius,
+    float tube_radius,
+    int radial_segments,
+    int tubular_segments,
+    float arc,
+    int lod_count,
+    MeshData* levels
+) {
+    Uint32 count = 0;
+    for (int i = 0; i <= lod_count; i++) {
+        if (i > 0) {
+            if (radial_segments <= 3 && tubular_segments <= 3) break;
+            radial_segments = SDL_max (radial_segments / 2, 3);
+            tubular_segments = SDL_max (tubular_segments / 2, 3);
+        }
+        if (build_torus_mesh (
+                radius, tube_radius, radial_segments, tubular_segments, arc,
+                &levels[count]
+            ))
+            break; // logging handled in build_torus_mesh()
+        count++;
+    }
+    return count;
+}
+
+MeshComponent create_torus_mesh_lods (
+    float radius,
+    float tube_radius,
+    int radial_segments,
+    int tubular_segments,
+    float arc,
+    int lod_count,
+    SDL_GPUDevice* device
+) {
+    MeshData* levels =
+        (MeshData*) malloc ((size_t) (lod_count + 1) * sizeof (MeshData));
+    if (!levels) {
+        SDL_Log ("Failed to allocate torus levels");
+        return (MeshComponent) {0};
+    }
+    Uint32 count = build_torus_mesh_lods (
+        radius, tube_radius, radial_segments, tubular_segments, arc, lod_count,
+        levels
+    );
+    MeshComponent mesh = upload_mesh_levels (device, levels, count);
+    for (Uint32 i = 0; i < count; i++) free_mesh_data (&levels[i]);
+    free (levels);
+    return mesh;
+}
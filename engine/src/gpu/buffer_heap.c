@@ -0,0 +1,209 @@
+#include <stdlib.h>
+
+#include <gpu/buffer_heap.h>
+
+#define TREE_NODES ((2u << BUFFER_HEAP_MAX_ORDER) - 1)
+#define NO_RANGE SDL_MAX_UINT32
+
+typedef struct {
+    SDL_GPUBuffer* buffer;
+    // implicit binary tree over the block, root first: each node holds one
+    // more than the order of the largest free range below it, 0 for none.
+    // NULL for a dedicated buffer holding a single oversized range
+    Uint8* tree;
+    Uint32 live; // ranges handed out
+} HeapBlock;
+
+typedef struct {
+    HeapBlock* blocks;
+    Uint32 count;
+    Uint32 capacity;
+} BufferHeap;
+
+static BufferHeap heaps[BUFFER_HEAP_COUNT];
+
+static const SDL_GPUBufferUsageFlags heap_usage[BUFFER_HEAP_COUNT] = {
+    SDL_GPU_BUFFERUSAGE_VERTEX,
+    SDL_GPU_BUFFERUSAGE_INDEX,
+};
+
+static const char* heap_names[BUFFER_HEAP_COUNT] = {"vertex", "index"};
+
+static void tree_init (Uint8* tree) {
+    Uint32 node = 0;
+    for (Uint32 depth = 0; depth <= BUFFER_HEAP_MAX_ORDER; depth++) {
+        for (Uint32 i = 0; i < (1u << depth); i++)
+            tree[node++] = (Uint8) (BUFFER_HEAP_MAX_ORDER - depth + 1);
+    }
+}
+
+// recomputes the ancestors of node, a range of the given order
+static void tree_update (Uint8* tree, Uint32 node, Uint32 order) {
+    while (node > 0) {
+        node = (node - 1) / 2;
+        order++;
+        Uint8 left = tree[node * 2 + 1];
+        Uint8 right = tree[node * 2 + 2];
+        // two whole children merge back into their parent
+        if (left == order && right == order)
+            tree[node] = (Uint8) (order + 1);
+        else
+            tree[node] = SDL_max (left, right);
+    }
+}
+
+// Returns the range's offset in BUFFER_HEAP_MIN_ALLOC units, or NO_RANGE
+static Uint32 tree_alloc (Uint8* tree, Uint32 order) {
+    if (tree[0] < order + 1) return NO_RANGE;
+    Uint32 node = 0;
+    for (Uint32 level = BUFFER_HEAP_MAX_ORDER; level > order; level--) {
+        Uint32 left = node * 2 + 1;
+        node = tree[left] >= order + 1 ? left : left + 1;
+    }
+    tree[node] = 0;
+    tree_update (tree, node, order);
+    Uint32 first = (1u << (BUFFER_HEAP_MAX_ORDER - order)) - 1;
+    return (node - first) << order;
+}
+
+// Returns 0 on success, 1 if no range starts at unit
+static int tree_free (Uint8* tree, Uint32 unit) {
+    // ranges below an allocated node are never touched, so the allocated
+    // node is the first zero on the way up from the unit's leaf
+    Uint32 node = (1u << BUFFER_HEAP_MAX_ORDER) - 1 + unit;
+    Uint32 order = 0;
+    while (tree[node] != 0) {
+        if (node == 0) return 1;
+        node = (node - 1) / 2;
+        order++;
+    }
+    Uint32 first = (1u << (BUFFER_HEAP_MAX_ORDER - order)) - 1;
+    if (((node - first) << order) != unit) return 1;
+    tree[node] = (Uint8) (order + 1);
+    tree_update (tree, node, order);
+    return 0;
+}
+
+// Returns NULL on failure
+static HeapBlock*
+add_block (SDL_GPUDevice* device, BufferHeapKind kind, Uint32 size) {
+    BufferHeap* heap = &heaps[kind];
+    if (heap->count == heap->capacity) {
+        Uint32 capacity = heap->capacity ? heap->capacity * 2 : 4;
+        HeapBlock* grown = (HeapBlock*) realloc (
+            heap->blocks, capacity * sizeof (HeapBlock)
+        );
+        if (!grown) {
+            SDL_Log ("Failed to grow %s heap", heap_names[kind]);
+            return NULL;
+        }
+        heap->blocks = grown;
+        heap->capacity = capacity;
+    }
+
+    Uint8* tree = NULL;
+    if (size == BUFFER_HEAP_BLOCK_SIZE) {
+        tree = (Uint8*) malloc (TREE_NODES);
+        if (!tree) {
+            SDL_Log ("Failed to allocate %s heap block", heap_names[kind]);
+            return NULL;
+        }
+        tree_init (tree);
+    }
+
+    SDL_GPUBufferCreateInfo info = {.usage = heap_usage[kind], .size = size};
+    SDL_GPUBuffer* buffer = SDL_CreateGPUBuffer (device, &info);
+    if (!buffer) {
+        SDL_Log (
+            "Failed to create %s heap block: %s", heap_names[kind],
+            SDL_GetError ()
+        );
+        free (tree);
+        return NULL;
+    }
+
+    HeapBlock* block = &heap->blocks[heap->count++];
+    *block = (HeapBlock) {.buffer = buffer, .tree = tree};
+    return block;
+}
+
+int buffer_heap_alloc (
+    SDL_GPUDevice* device,
+    BufferHeapKind kind,
+    Uint32 size,
+    SDL_GPUBuffer** buffer,
+    Uint32* offset
+) {
+    if (size == 0) {
+        SDL_Log ("Empty %s heap range requested", heap_names[kind]);
+        return 1;
+    }
+    if (size > BUFFER_HEAP_BLOCK_SIZE) {
+        HeapBlock* block = add_block (device, kind, size);
+        if (!block) return 1; // logging handled in add_block()
+        block->live = 1;
+        *buffer = block->buffer;
+        *offset = 0;
+        return 0;
+    }
+
+    Uint32 order = 0;
+    while ((BUFFER_HEAP_MIN_ALLOC << order) < size) order++;
+
+    BufferHeap* heap = &heaps[kind];
+    HeapBlock* block = NULL;
+    Uint32 unit = NO_RANGE;
+    for (Uint32 i = 0; i < heap->count && unit == NO_RANGE; i++) {
+        if (!heap->blocks[i].tree) continue;
+        block = &heap->blocks[i];
+        unit = tree_alloc (block->tree, order);
+    }
+    if (unit == NO_RANGE) {
+        block = add_block (device, kind, BUFFER_HEAP_BLOCK_SIZE);
+        if (!block) return 1; // logging handled in add_block()
+        unit = tree_alloc (block->tree, order);
+    }
+
+    block->live++;
+    *buffer = block->buffer;
+    *offset = unit * BUFFER_HEAP_MIN_ALLOC;
+    return 0;
+}
+
+void buffer_heap_free (
+    SDL_GPUDevice* device,
+    BufferHeapKind kind,
+    SDL_GPUBuffer* buffer,
+    Uint32 offset
+) {
+    BufferHeap* heap = &heaps[kind];
+    Uint32 i = 0;
+    while (i < heap->count && heap->blocks[i].buffer != buffer) i++;
+    if (i == heap->count) {
+        SDL_Log ("Buffer is not part of the %s heap", heap_names[kind]);
+        return;
+    }
+
+    HeapBlock* block = &heap->blocks[i];
+    if (block->tree &&
+        (offset % BUFFER_HEAP_MIN_ALLOC ||
+         tree_free (block->tree, offset / BUFFER_HEAP_MIN_ALLOC))) {
+        SDL_Log ("No %s heap range at offset %u", heap_names[kind], offset);
+        return;
+    }
+    if (--block->live > 0) return;
+
+    // SDL holds the release back until the GPU has stopped reading the block
+    SDL_ReleaseGPUBuffer (device, block->buffer);
+    free (block->tree);
+    heap->blocks[i] = heap->blocks[--heap->count];
+    if (heap->count == 0) {
+        free (heap->blocks);
+        heap->blocks = NULL;
+        heap->capacity = 0;
+    }
+}
+
+Uint32 buffer_heap_block_count (BufferHeapKind kind) {
+    return heaps[kind].count;
+}
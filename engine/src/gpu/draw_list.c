@@ -0,0 +1,680 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include <geometry/g_common.h>
+#include <gpu/draw_list.h>
+#include <gpu/hiz.h>
+#include <gpu/staging_ring.h>
+#include <jobs/jobs.h>
+#include <material/m_common.h>
+#include <profiler/profiler.h>
+
+#define DRAW_LIST_MIN_CAPACITY 256
+#define CULL_GROUP_SIZE 64 // local_size_x in draw_cull.comp
+#define DRAW_MIN_BATCH 2048 // draws per job batch for keys and gathering
+#define RECORD_CHUNK 1024 // draws per recording chunk
+#define SORT_QUEUE_BIT 0x80000000u
+// opaque keys are the top 16 bits of the depth (sign, exponent and 7 bits of
+// mantissa) over this many bits of state
+#define SORT_STATE_BITS 15
+
+// std140 layout of the Cull block in draw_cull.comp
+typedef struct {
+    float planes[6][4]; // xyz inward normal, w distance
+    mat4 hiz_view_proj;
+    float hiz_size[2];
+    Uint32 draw_count;
+    Uint32 hiz_levels; // 0 skips the occlusion test
+} CullUniforms;
+
+typedef struct {
+    SDL_GPUGraphicsPipeline* pipeline;
+    SDL_GPUGraphicsPipeline* depth_pipeline; // NULL: not in the pre-pass
+    SDL_GPUTexture* texture;
+    MeshComponent mesh; // a copy, so the mesh pool may move meanwhile
+    DrawQueue queue;
+} DrawItem;
+
+// a run of positions [start, start + count) drawn with one call
+typedef struct {
+    Uint32 start;
+    Uint32 count;
+} DrawRecord;
+
+// one frame's list on the CPU side
+typedef struct {
+    // indexed by draw in the order added; a draw's ObjectData is its instance
+    DrawItem* items;
+    ObjectData* objects;
+    SDL_GPUIndexedIndirectDrawCommand* commands;
+    Uint32 count;
+    Uint32 capacity;
+    // the draw at each position of the submitted order, and the radix sort's
+    // keys and second buffers
+    Uint32* order;
+    Uint32* order_scratch;
+    Uint32* sort_keys;
+    Uint32* key_scratch;
+} DrawFrame;
+
+static SDL_GPUDevice* list_device = NULL;
+
+static DrawFrame frames[2];
+static DrawFrame* building = &frames[0]; // filled by draw_list_add()
+static DrawFrame* drawing = &frames[1];  // uploaded and drawn
+static Uint32 reserved_start = 0; // building's first draw_list_set() slot
+
+// batches found by the recording jobs; chunk c writes from its first
+// position c * RECORD_CHUNK, so never more records than draws
+static DrawRecord* records = NULL;
+static Uint32* chunk_record_counts = NULL;
+static Uint32 record_capacity = 0;
+
+// GPU side, sized in draws
+static SDL_GPUBuffer* object_buffer = NULL;
+static SDL_GPUBuffer* indirect_buffer = NULL;
+static Uint32 buffer_capacity = 0;
+
+static SDL_GPUComputePipeline* cull_pipeline = NULL;
+static Uint32 last_batch_count = 0;
+
+int draw_list_init (SDL_GPUDevice* device) {
+    if (list_device) {
+        SDL_Log ("Draw list already initialized");
+        return 1;
+    }
+    list_device = device;
+    // culling binds the depth pyramid, so goes without it
+    if (hiz_init (device)) return 0; // logging handled in hiz_init()
+    // logging handled in load_compute_pipeline()
+    cull_pipeline = load_compute_pipeline (
+        device, "shaders/draw_cull.comp.spv",
+        (SDL_GPUComputePipelineCreateInfo) {
+            .num_samplers = 2,
+            .num_readonly_storage_buffers = 1,
+            .num_readwrite_storage_buffers = 1,
+            .num_uniform_buffers = 1,
+            .threadcount_x = CULL_GROUP_SIZE,
+            .threadcount_y = 1,
+            .threadcount_z = 1
+        }
+    );
+    return 0;
+}
+
+static void release_buffers (void) {
+    if (object_buffer) SDL_ReleaseGPUBuffer (list_device, object_buffer);
+    if (indirect_buffer) SDL_ReleaseGPUBuffer (list_device, indirect_buffer);
+    object_buffer = NULL;
+    indirect_buffer = NULL;
+    buffer_capacity = 0;
+}
+
+void draw_list_shutdown (void) {
+    if (!list_device) return;
+    release_buffers ();
+    if (cull_pipeline)
+        SDL_ReleaseGPUComputePipeline (list_device, cull_pipeline);
+    cull_pipeline = NULL;
+    hiz_shutdown ();
+    for (int i = 0; i < 2; i++) {
+        DrawFrame* frame = &frames[i];
+        free (frame->items);
+        free (frame->objects);
+        free (frame->commands);
+        free (frame->order);
+        free (frame->order_scratch);
+        free (frame->sort_keys);
+        free (frame->key_scratch);
+        *frame = (DrawFrame) {0};
+    }
+    free (records);
+    free (chunk_record_counts);
+    records = NULL;
+    chunk_record_counts = NULL;
+    record_capacity = 0;
+    list_device = NULL;
+}
+
+void draw_list_reset (void) {
+    building->count = 0;
+    reserved_start = 0;
+}
+
+void draw_list_swap (void) {
+    DrawFrame* built = building;
+    building = drawing;
+    drawing = built;
+}
+
+// Returns 0 on success, 1 on failure; array is left as it was on failure
+static int grow_array (void** array, Uint32 capacity, size_t size) {
+    void* grown = realloc (*array, capacity * size);
+    if (!grown) return 1;
+    *array = grown;
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+static int grow_frame (DrawFrame* frame) {
+    Uint32 capacity =
+        frame->capacity ? frame->capacity * 2 : DRAW_LIST_MIN_CAPACITY;
+    int failed =
+        grow_array ((void**) &frame->items, capacity, sizeof (DrawItem));
+    failed |=
+        grow_array ((void**) &frame->objects, capacity, sizeof (ObjectData));
+    failed |= grow_array (
+        (void**) &frame->commands, capacity,
+        sizeof (SDL_GPUIndexedIndirectDrawCommand)
+    );
+    failed |= grow_array ((void**) &frame->order, capacity, sizeof (Uint32));
+    failed |=
+        grow_array ((void**) &frame->order_scratch, capacity, sizeof (Uint32));
+    failed |=
+        grow_array ((void**) &frame->sort_keys, capacity, sizeof (Uint32));
+    failed |=
+        grow_array ((void**) &frame->key_scratch, capacity, sizeof (Uint32));
+    if (failed) {
+        SDL_Log ("Failed to grow draw list");
+        return 1;
+    }
+    frame->capacity = capacity;
+    return 0;
+}
+
+int draw_list_reserve (Uint32 count) {
+    DrawFrame* frame = building;
+    while (frame->count + count > frame->capacity)
+        if (grow_frame (frame)) return 1; // logging handled in grow_frame()
+    reserved_start = frame->count;
+    return 0;
+}
+
+void draw_list_set (
+    Uint32 slot,
+    SDL_GPUGraphicsPipeline* pipeline,
+    SDL_GPUGraphicsPipeline* depth_pipeline,
+    SDL_GPUTexture* texture,
+    const MeshComponent* mesh,
+    const ObjectData* object,
+    DrawQueue queue
+) {
+    DrawFrame* frame = building;
+    Uint32 i = reserved_start + slot;
+    frame->items[i] = (DrawItem) {
+        .pipeline = pipeline,
+        .depth_pipeline = depth_pipeline,
+        .texture = texture,
+        .mesh = *mesh,
+        .queue = queue
+    };
+    frame->objects[i] = *object;
+
+    // interleaved meshes start at a base vertex into the heap block, which
+    // the heap's alignment keeps whole; separate streams differ in stride, so
+    // those are bound at the mesh itself
+    Sint32 base_vertex = 0;
+    if (mesh->layout != VERTEX_LAYOUT_SEPARATE)
+        base_vertex =
+            (Sint32) (mesh->vertex_offset / vertex_stride (mesh->layout));
+    frame->commands[i] = (SDL_GPUIndexedIndirectDrawCommand) {
+        .num_indices = mesh->num_indices,
+        .num_instances = 1,
+        .first_index = mesh->index_offset / index_size_bytes (mesh->index_size),
+        .vertex_offset = base_vertex,
+        .first_instance = 0 // the draw's position, filled in on upload
+    };
+}
+
+void draw_list_keep (Uint32 slot, Uint32 count) {
+    DrawFrame* frame = building;
+    Uint32 src = reserved_start + slot;
+    Uint32 dst = frame->count;
+    if (src != dst) {
+        // runs only ever move back over the slots dropped before them
+        memmove (
+            &frame->items[dst], &frame->items[src], count * sizeof (DrawItem)
+        );
+        memmove (
+            &frame->objects[dst], &frame->objects[src],
+            count * sizeof (ObjectData)
+        );
+        memmove (
+            &frame->commands[dst], &frame->commands[src],
+            count * sizeof (SDL_GPUIndexedIndirectDrawCommand)
+        );
+    }
+    for (Uint32 i = dst; i < dst + count; i++)
+        frame->order[i] = i; // unsorted lists go out as added
+    frame->count += count;
+}
+
+int draw_list_add (
+    SDL_GPUGraphicsPipeline* pipeline,
+    SDL_GPUGraphicsPipeline* depth_pipeline,
+    SDL_GPUTexture* texture,
+    const MeshComponent* mesh,
+    const ObjectData* object,
+    DrawQueue queue
+) {
+    if (draw_list_reserve (1)) return 1; // logging handled in grow_frame()
+    draw_list_set (0, pipeline, depth_pipeline, texture, mesh, object, queue);
+    draw_list_keep (0, 1);
+    return 0;
+}
+
+// orders floats as unsigned integers do: negatives flip whole, positives
+// gain the sign bit
+static Uint32 float_key (float value) {
+    Uint32 bits;
+    memcpy (&bits, &value, sizeof (bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+// SORT_STATE_BITS that tend to differ between draws that cannot share a batch
+static Uint32 state_key (const DrawItem* item) {
+    Uint64 hash = (Uint64) (uintptr_t) item->pipeline;
+    hash = (hash ^ (Uint64) (uintptr_t) item->texture) * 0x9E3779B97F4A7C15u;
+    hash = (hash ^ (Uint64) (uintptr_t) item->mesh.vertex_buffer) *
+           0x9E3779B97F4A7C15u;
+    return (Uint32) (hash >> (64 - SORT_STATE_BITS));
+}
+
+// stable LSD radix sort of the frame's order by its sort_keys, a byte per
+// pass; O(n) where a comparison sort of 100k draws would not be
+static void radix_sort (DrawFrame* frame) {
+    Uint32 count = frame->count;
+    Uint32* keys = frame->sort_keys;
+    Uint32* keys_out = frame->key_scratch;
+    Uint32* draws = frame->order;
+    Uint32* draws_out = frame->order_scratch;
+    for (Uint32 shift = 0; shift < 32; shift += 8) {
+        Uint32 offsets[256] = {0};
+        for (Uint32 i = 0; i < count; i++) offsets[(keys[i] >> shift) & 0xff]++;
+        // a byte every key shares leaves the order as it is
+        if (offsets[(keys[0] >> shift) & 0xff] == count) continue;
+
+        Uint32 sum = 0;
+        for (Uint32 digit = 0; digit < 256; digit++) {
+            Uint32 digit_count = offsets[digit];
+            offsets[digit] = sum;
+            sum += digit_count;
+        }
+        for (Uint32 i = 0; i < count; i++) {
+            Uint32 slot = offsets[(keys[i] >> shift) & 0xff]++;
+            keys_out[slot] = keys[i];
+            draws_out[slot] = draws[i];
+        }
+        Uint32* swap = keys;
+        keys = keys_out;
+        keys_out = swap;
+        swap = draws;
+        draws = draws_out;
+        draws_out = swap;
+    }
+    frame->sort_keys = keys;
+    frame->key_scratch = keys_out;
+    frame->order = draws;
+    frame->order_scratch = draws_out;
+}
+
+// data is the view matrix
+static void sort_keys_job (void* data, Uint32 start, Uint32 end) {
+    const float* view = (const float*) data;
+    DrawFrame* frame = building;
+    for (Uint32 i = start; i < end; i++) {
+        // view depth of the model origin, which the bounds center on
+        const float* model = frame->objects[i].model;
+        float depth = view[MAT4_IDX (2, 3)];
+        for (int axis = 0; axis < 3; axis++)
+            depth += view[MAT4_IDX (2, axis)] * model[MAT4_IDX (axis, 3)];
+
+        // the top bit puts blended draws last; opaque ones only need rough
+        // depth, so the bits below group state that can share a batch
+        Uint32 key = float_key (depth);
+        if (frame->items[i].queue == DRAW_QUEUE_BLENDED)
+            key = SORT_QUEUE_BIT | (~key >> 1);
+        else
+            key = (key >> 16) << SORT_STATE_BITS |
+                  state_key (&frame->items[i]);
+        frame->sort_keys[i] = key;
+        frame->order[i] = i;
+    }
+}
+
+void draw_list_sort (mat4 view) {
+    PROFILE_ZONE ("draw_list_sort");
+    if (building->count == 0) return;
+    jobs_parallel_for (building->count, DRAW_MIN_BATCH, sort_keys_job, view);
+    radix_sort (building);
+}
+
+// Returns 0 on success, 1 on failure
+static int reserve_buffers (void) {
+    if (drawing->count <= buffer_capacity) return 0;
+    Uint32 capacity = SDL_max (buffer_capacity, DRAW_LIST_MIN_CAPACITY);
+    while (capacity < drawing->count) capacity *= 2;
+    release_buffers (); // deferred until the GPU is done with them
+
+    // the culling pass reads the objects and writes the commands
+    SDL_GPUBufferCreateInfo object_info = {
+        .usage = SDL_GPU_BUFFERUSAGE_VERTEX |
+                 SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ,
+        .size = capacity * (Uint32) sizeof (ObjectData)
+    };
+    SDL_GPUBufferCreateInfo indirect_info = {
+        .usage = SDL_GPU_BUFFERUSAGE_INDIRECT |
+                 SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+        .size = capacity * (Uint32) sizeof (SDL_GPUIndexedIndirectDrawCommand)
+    };
+    object_buffer = SDL_CreateGPUBuffer (list_device, &object_info);
+    indirect_buffer = SDL_CreateGPUBuffer (list_device, &indirect_info);
+    if (!object_buffer || !indirect_buffer) {
+        SDL_Log ("Failed to create draw list buffers: %s", SDL_GetError ());
+        release_buffers ();
+        return 1;
+    }
+    buffer_capacity = capacity;
+    return 0;
+}
+
+typedef struct {
+    ObjectData* objects;
+    SDL_GPUIndexedIndirectDrawCommand* commands;
+} GatherJob;
+
+// gathers positions [start, end) into submission order; each draw's
+// instance is its position
+static void gather_job (void* data, Uint32 start, Uint32 end) {
+    GatherJob* job = (GatherJob*) data;
+    const DrawFrame* frame = drawing;
+    for (Uint32 p = start; p < end; p++) {
+        job->objects[p] = frame->objects[frame->order[p]];
+        job->commands[p] = frame->commands[frame->order[p]];
+        job->commands[p].first_instance = p;
+    }
+}
+
+int draw_list_upload (void) {
+    PROFILE_ZONE ("draw_list_upload");
+    Uint32 draw_count = drawing->count;
+    if (draw_count == 0) return 0;
+    if (reserve_buffers ()) {
+        drawing->count = 0; // nothing to draw from
+        return 1; // logging handled in reserve_buffers()
+    }
+
+    // one upload per buffer: cycling a second time in a frame would drop the
+    // first
+    Uint32 objects_size = draw_count * (Uint32) sizeof (ObjectData);
+    Uint32 commands_size =
+        draw_count * (Uint32) sizeof (SDL_GPUIndexedIndirectDrawCommand);
+    void* object_dst =
+        staging_upload_buffer (object_buffer, 0, objects_size, true);
+    void* command_dst =
+        staging_upload_buffer (indirect_buffer, 0, commands_size, true);
+    if (!object_dst || !command_dst) {
+        drawing->count = 0;
+        return 1; // logging handled in staging_upload_buffer()
+    }
+    GatherJob job = {
+        .objects = (ObjectData*) object_dst,
+        .commands = (SDL_GPUIndexedIndirectDrawCommand*) command_dst
+    };
+    jobs_parallel_for (draw_count, DRAW_MIN_BATCH, gather_job, &job);
+    return 0;
+}
+
+// plane as row_a + sign * row_b of the clip matrix, normalized
+static void clip_plane (
+    float plane[4],
+    const mat4 m,
+    int row_a,
+    int row_b,
+    float sign
+) {
+    for (int col = 0; col < 4; col++)
+        plane[col] = m[MAT4_IDX (row_a, col)] + sign * m[MAT4_IDX (row_b, col)];
+    float length = sqrtf (
+        plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]
+    );
+    if (length > 0.0f)
+        for (int i = 0; i < 4; i++) plane[i] /= length;
+}
+
+void draw_list_cull (SDL_GPUCommandBuffer* cmd, mat4 view_proj) {
+    PROFILE_ZONE ("draw_list_cull");
+    const HizPyramid* hiz = hiz_pyramid ();
+    Uint32 draw_count = drawing->count;
+    if (!cull_pipeline || draw_count == 0 || !hiz->levels[0].texture) return;
+
+    // Gribb-Hartmann planes; clip depth runs 0 to w, so near is row 2 alone
+    CullUniforms uniforms = {.draw_count = draw_count};
+    clip_plane (uniforms.planes[0], view_proj, 3, 0, 1.0f);  // left
+    clip_plane (uniforms.planes[1], view_proj, 3, 0, -1.0f); // right
+    clip_plane (uniforms.planes[2], view_proj, 3, 1, 1.0f);  // bottom
+    clip_plane (uniforms.planes[3], view_proj, 3, 1, -1.0f); // top
+    clip_plane (uniforms.planes[4], view_proj, 2, 2, 0.0f);  // near
+    clip_plane (uniforms.planes[5], view_proj, 3, 2, -1.0f); // far
+    memcpy (uniforms.hiz_view_proj, hiz->view_proj, sizeof (mat4));
+    uniforms.hiz_size[0] = (float) hiz->width;
+    uniforms.hiz_size[1] = (float) hiz->height;
+    uniforms.hiz_levels = hiz->level_count;
+
+    // the commands were just uploaded, so they must not be cycled away
+    SDL_GPUStorageBufferReadWriteBinding commands_binding = {
+        .buffer = indirect_buffer, .cycle = false
+    };
+    SDL_GPUComputePass* pass =
+        SDL_BeginGPUComputePass (cmd, NULL, 0, &commands_binding, 1);
+    if (!pass) {
+        SDL_Log ("Failed to begin culling pass: %s", SDL_GetError ());
+        return;
+    }
+    SDL_BindGPUComputePipeline (pass, cull_pipeline);
+    SDL_BindGPUComputeSamplers (pass, 0, hiz->levels, 2);
+    SDL_BindGPUComputeStorageBuffers (pass, 0, &object_buffer, 1);
+    SDL_PushGPUComputeUniformData (cmd, 0, &uniforms, sizeof (uniforms));
+    SDL_DispatchGPUCompute (
+        pass, (draw_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1
+    );
+    SDL_EndGPUComputePass (pass);
+}
+
+// whether b draws from the buffers bound for a
+static bool
+same_geometry (const MeshComponent* a, const MeshComponent* b) {
+    if (a->vertex_buffer != b->vertex_buffer ||
+        a->index_buffer != b->index_buffer ||
+        a->index_size != b->index_size || a->layout != b->layout)
+        return false;
+    // separate streams are bound at the mesh itself
+    return a->layout != VERTEX_LAYOUT_SEPARATE ||
+           a->vertex_offset == b->vertex_offset;
+}
+
+static bool same_batch (const DrawItem* a, const DrawItem* b, bool depth) {
+    // depth only needs the geometry, so material textures split nothing
+    if (depth)
+        return a->depth_pipeline == b->depth_pipeline &&
+               a->mesh.index_buffer && same_geometry (&a->mesh, &b->mesh);
+    return a->pipeline == b->pipeline && a->texture == b->texture &&
+           a->mesh.index_buffer && same_geometry (&a->mesh, &b->mesh);
+}
+
+static void bind_geometry (SDL_GPURenderPass* pass, const MeshComponent* mesh) {
+    SDL_GPUBufferBinding bindings[VERTEX_ATTRIBUTE_COUNT + 1];
+    Uint32 num_bindings = 0;
+    if (mesh->layout == VERTEX_LAYOUT_SEPARATE) {
+        for (Uint32 b = 0; b < VERTEX_ATTRIBUTE_COUNT; b++) {
+            bindings[num_bindings++] = (SDL_GPUBufferBinding) {
+                .buffer = mesh->vertex_buffer,
+                .offset = mesh->vertex_offset + mesh->stream_offsets[b]
+            };
+        }
+    } else {
+        bindings[num_bindings++] = (SDL_GPUBufferBinding) {
+            .buffer = mesh->vertex_buffer, .offset = 0
+        };
+    }
+    // instances index ObjectData from the start of the buffer
+    bindings[num_bindings++] = (SDL_GPUBufferBinding) {
+        .buffer = object_buffer, .offset = 0
+    };
+    SDL_BindGPUVertexBuffers (pass, 0, bindings, num_bindings);
+
+    if (mesh->index_buffer) {
+        SDL_GPUBufferBinding ibo_binding = {
+            .buffer = mesh->index_buffer, .offset = 0
+        };
+        SDL_BindGPUIndexBuffer (pass, &ibo_binding, mesh->index_size);
+    }
+}
+
+// Returns 0 on success, 1 on failure
+static int reserve_records (Uint32 count) {
+    if (count <= record_capacity) return 0;
+    Uint32 capacity = SDL_max (record_capacity, DRAW_LIST_MIN_CAPACITY);
+    while (capacity < count) capacity *= 2;
+    int failed = grow_array ((void**) &records, capacity, sizeof (DrawRecord));
+    failed |= grow_array (
+        (void**) &chunk_record_counts,
+        (capacity + RECORD_CHUNK - 1) / RECORD_CHUNK, sizeof (Uint32)
+    );
+    if (failed) {
+        SDL_Log ("Failed to grow draw list records");
+        return 1;
+    }
+    record_capacity = capacity;
+    return 0;
+}
+
+// splits chunks [start, end) into records of runs that can share a draw call;
+// data points at a bool, whether recording the pre-pass
+static void build_records_job (void* data, Uint32 start, Uint32 end) {
+    bool depth = *(const bool*) data;
+    const DrawFrame* frame = drawing;
+    for (Uint32 chunk = start; chunk < end; chunk++) {
+        Uint32 first = chunk * RECORD_CHUNK;
+        Uint32 last = SDL_min (first + RECORD_CHUNK, frame->count);
+        DrawRecord* out = &records[first];
+        Uint32 count = 0;
+
+        Uint32 run = first;
+        while (run < last) {
+            const DrawItem* item = &frame->items[frame->order[run]];
+            Uint32 run_end = run + 1;
+            while (run_end < last &&
+                   same_batch (
+                       item, &frame->items[frame->order[run_end]], depth
+                   ))
+                run_end++;
+            // runs without a pipeline sit out the pre-pass
+            if (depth ? item->depth_pipeline : item->pipeline)
+                out[count++] = (DrawRecord) {run, run_end - run};
+            run = run_end;
+        }
+        chunk_record_counts[chunk] = count;
+    }
+}
+
+static void draw_record (SDL_GPURenderPass* pass, DrawRecord record) {
+    Uint32 draw = drawing->order[record.start];
+    const DrawItem* item = &drawing->items[draw];
+    if (item->mesh.index_buffer) {
+        SDL_DrawGPUIndexedPrimitivesIndirect (
+            pass, indirect_buffer,
+            record.start * (Uint32) sizeof (SDL_GPUIndexedIndirectDrawCommand),
+            record.count
+        );
+    } else {
+        // never batched, and never culled as the instance count is not
+        // read back from the commands; first_instance picks the ObjectData
+        SDL_DrawGPUPrimitives (
+            pass, item->mesh.num_vertices, 1,
+            (Uint32) drawing->commands[draw].vertex_offset, record.start
+        );
+    }
+}
+
+// Returns the number of batches recorded
+// depth records the pre-pass: items' depth pipelines and no textures. The
+// draws are split into chunks whose records are built in parallel, then
+// replayed into pass in order, joining runs split at chunk seams and binding
+// only what changed.
+static Uint32
+record_batches (SDL_GPURenderPass* pass, SDL_GPUSampler* sampler, bool depth) {
+    const DrawFrame* frame = drawing;
+    if (frame->count == 0 || reserve_records (frame->count)) return 0;
+    Uint32 chunk_count = (frame->count + RECORD_CHUNK - 1) / RECORD_CHUNK;
+    jobs_parallel_for (chunk_count, 1, build_records_job, &depth);
+
+    Uint32 batches = 0;
+    SDL_GPUGraphicsPipeline* bound_pipeline = NULL;
+    SDL_GPUTexture* bound_texture = NULL;
+    const MeshComponent* bound_mesh = NULL;
+    DrawRecord pending = {0};
+
+    for (Uint32 chunk = 0; chunk < chunk_count; chunk++) {
+        const DrawRecord* chunk_records = &records[chunk * RECORD_CHUNK];
+        for (Uint32 r = 0; r < chunk_record_counts[chunk]; r++) {
+            DrawRecord record = chunk_records[r];
+            const DrawItem* item = &frame->items[frame->order[record.start]];
+            const DrawItem* pending_item =
+                &frame->items[frame->order[pending.start]];
+            if (pending.count > 0 &&
+                pending.start + pending.count == record.start &&
+                same_batch (pending_item, item, depth)) {
+                pending.count += record.count;
+                continue;
+            }
+            if (pending.count > 0) {
+                draw_record (pass, pending);
+                batches++;
+            }
+            pending = record;
+
+            SDL_GPUGraphicsPipeline* pipeline =
+                depth ? item->depth_pipeline : item->pipeline;
+            if (pipeline != bound_pipeline) {
+                SDL_BindGPUGraphicsPipeline (pass, pipeline);
+                bound_pipeline = pipeline;
+            }
+            if (!depth && item->texture != bound_texture) {
+                SDL_GPUTextureSamplerBinding tex_bind = {
+                    .texture = item->texture, .sampler = sampler
+                };
+                SDL_BindGPUFragmentSamplers (pass, 0, &tex_bind, 1);
+                bound_texture = item->texture;
+            }
+            // batches split on pipeline or texture alone keep their buffers
+            if (!bound_mesh || !same_geometry (bound_mesh, &item->mesh)) {
+                bind_geometry (pass, &item->mesh);
+                bound_mesh = &item->mesh;
+            }
+        }
+    }
+    if (pending.count > 0) {
+        draw_record (pass, pending);
+        batches++;
+    }
+    return batches;
+}
+
+void draw_list_draw_depth (SDL_GPURenderPass* pass) {
+    PROFILE_ZONE ("draw_list_draw_depth");
+    record_batches (pass, NULL, true);
+}
+
+void draw_list_draw (SDL_GPURenderPass* pass, SDL_GPUSampler* sampler) {
+    PROFILE_ZONE ("draw_list_draw");
+    last_batch_count = record_batches (pass, sampler, false);
+}
+
+Uint32 draw_list_count (void) {
+    return drawing->count;
+}
+
+Uint32 draw_list_batch_count (void) {
+    return last_batch_count;
+}
@@ -0,0 +1,189 @@
+#include <gpu/hiz.h>
+#include <material/m_common.h>
+#include <profiler/profiler.h>
+
+#define HIZ_GROUP_SIZE 8 // local_size_x and _y in hiz_reduce.comp
+
+// std140 layout of the Reduce block in hiz_reduce.comp
+typedef struct {
+    Sint32 src_size[2];
+    Sint32 dst_size[2];
+    Sint32 src_level;
+    Sint32 padding[3];
+} ReduceUniforms;
+
+static SDL_GPUDevice* hiz_device = NULL;
+static SDL_GPUComputePipeline* reduce_pipeline = NULL;
+static SDL_GPUSampler* point_sampler = NULL;
+static HizPyramid pyramid;
+static Uint32 texture_levels = 0; // mips in each level texture
+
+static void release_levels (void) {
+    for (int i = 0; i < 2; i++) {
+        if (pyramid.levels[i].texture)
+            SDL_ReleaseGPUTexture (hiz_device, pyramid.levels[i].texture);
+        pyramid.levels[i].texture = NULL;
+    }
+    pyramid.width = 0;
+    pyramid.height = 0;
+    pyramid.level_count = 0;
+    texture_levels = 0;
+}
+
+// Returns 0 on success, 1 on failure
+// level 0 is width x height and the rest halve down to 1x1
+static int create_levels (Uint32 width, Uint32 height) {
+    release_levels (); // deferred until the GPU is done with them
+    Uint32 levels = 1;
+    while ((SDL_max (width, height) >> levels) > 0) levels++;
+
+    SDL_GPUTextureCreateInfo info = {
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = SDL_GPU_TEXTUREFORMAT_R32_FLOAT,
+        .width = width,
+        .height = height,
+        .layer_count_or_depth = 1,
+        .num_levels = levels,
+        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER |
+                 SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE
+    };
+    for (int i = 0; i < 2; i++) {
+        pyramid.levels[i].texture = SDL_CreateGPUTexture (hiz_device, &info);
+        if (!pyramid.levels[i].texture) {
+            SDL_Log ("Failed to create depth pyramid: %s", SDL_GetError ());
+            release_levels ();
+            return 1;
+        }
+    }
+    pyramid.width = width;
+    pyramid.height = height;
+    texture_levels = levels;
+    return 0;
+}
+
+int hiz_init (SDL_GPUDevice* device) {
+    if (hiz_device) {
+        SDL_Log ("Depth pyramid already initialized");
+        return 1;
+    }
+    hiz_device = device;
+
+    SDL_GPUSamplerCreateInfo sampler_info = {
+        .min_filter = SDL_GPU_FILTER_NEAREST,
+        .mag_filter = SDL_GPU_FILTER_NEAREST,
+        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
+        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE
+    };
+    point_sampler = SDL_CreateGPUSampler (device, &sampler_info);
+    if (!point_sampler) {
+        SDL_Log ("Failed to create depth pyramid sampler: %s", SDL_GetError ());
+        hiz_device = NULL;
+        return 1;
+    }
+    pyramid.levels[0].sampler = point_sampler;
+    pyramid.levels[1].sampler = point_sampler;
+
+    // culling binds the levels before anything was built, so start at 1x1
+    if (create_levels (1, 1)) {
+        hiz_shutdown ();
+        return 1; // logging handled in create_levels()
+    }
+
+    // logging handled in load_compute_pipeline()
+    reduce_pipeline = load_compute_pipeline (
+        device, "shaders/hiz_reduce.comp.spv",
+        (SDL_GPUComputePipelineCreateInfo) {
+            .num_samplers = 1,
+            .num_readwrite_storage_textures = 1,
+            .num_uniform_buffers = 1,
+            .threadcount_x = HIZ_GROUP_SIZE,
+            .threadcount_y = HIZ_GROUP_SIZE,
+            .threadcount_z = 1
+        }
+    );
+    return 0;
+}
+
+void hiz_shutdown (void) {
+    if (!hiz_device) return;
+    release_levels ();
+    if (reduce_pipeline)
+        SDL_ReleaseGPUComputePipeline (hiz_device, reduce_pipeline);
+    if (point_sampler) SDL_ReleaseGPUSampler (hiz_device, point_sampler);
+    reduce_pipeline = NULL;
+    point_sampler = NULL;
+    pyramid = (HizPyramid) {0};
+    hiz_device = NULL;
+}
+
+int hiz_build (
+    SDL_GPUCommandBuffer* cmd,
+    SDL_GPUTexture* depth,
+    Uint32 width,
+    Uint32 height,
+    mat4 view_proj
+) {
+    PROFILE_ZONE ("hiz_build");
+    if (!reduce_pipeline) return 0;
+
+    // level 0 is already a 2x reduction of the depth buffer
+    Uint32 base_width = SDL_max (width / 2, 1u);
+    Uint32 base_height = SDL_max (height / 2, 1u);
+    if ((pyramid.width != base_width || pyramid.height != base_height) &&
+        create_levels (base_width, base_height))
+        return 1; // logging handled in create_levels()
+
+    Uint32 src_width = width;
+    Uint32 src_height = height;
+    for (Uint32 level = 0; level < texture_levels; level++) {
+        Uint32 dst_width = SDL_max (base_width >> level, 1u);
+        Uint32 dst_height = SDL_max (base_height >> level, 1u);
+
+        // the previous level is in the other texture, so nothing reads what
+        // this pass writes
+        SDL_GPUStorageTextureReadWriteBinding dst = {
+            .texture = pyramid.levels[level % 2].texture,
+            .mip_level = level,
+            .cycle = false
+        };
+        SDL_GPUTextureSamplerBinding src = {
+            .texture = level == 0 ? depth
+                                  : pyramid.levels[(level - 1) % 2].texture,
+            .sampler = point_sampler
+        };
+        ReduceUniforms uniforms = {
+            .src_size = {(Sint32) src_width, (Sint32) src_height},
+            .dst_size = {(Sint32) dst_width, (Sint32) dst_height},
+            .src_level = level == 0 ? 0 : (Sint32) (level - 1)
+        };
+
+        SDL_GPUComputePass* pass =
+            SDL_BeginGPUComputePass (cmd, &dst, 1, NULL, 0);
+        if (!pass) {
+            SDL_Log ("Failed to begin depth pyramid pass: %s", SDL_GetError ());
+            pyramid.level_count = 0; // half built, so unusable
+            return 1;
+        }
+        SDL_BindGPUComputePipeline (pass, reduce_pipeline);
+        SDL_BindGPUComputeSamplers (pass, 0, &src, 1);
+        SDL_PushGPUComputeUniformData (cmd, 0, &uniforms, sizeof (uniforms));
+        SDL_DispatchGPUCompute (
+            pass, (dst_width + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE,
+            (dst_height + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1
+        );
+        SDL_EndGPUComputePass (pass);
+
+        src_width = dst_width;
+        src_height = dst_height;
+    }
+
+    pyramid.level_count = texture_levels;
+    memcpy (pyramid.view_proj, view_proj, sizeof (mat4));
+    return 0;
+}
+
+const HizPyramid* hiz_pyramid (void) {
+    return hiz_device ? &pyramid : NULL;
+}
@@ -0,0 +1,211 @@
+#include <stdlib.h>
+
+#include <gpu/staging_ring.h>
+#include <profiler/profiler.h>
+
+// D3D12 wants texture data placed at 512 bytes; buffers need much less
+#define STAGING_BUFFER_ALIGN 16u
+#define STAGING_TEXTURE_ALIGN 512u
+
+typedef struct {
+    SDL_GPUTransferBuffer* buffer;
+    Uint32 size;
+    Uint32 used;
+    Uint8* map; // NULL until first used in a frame
+} StagingChunk;
+
+typedef struct {
+    StagingChunk* chunks;
+    Uint32 count;
+    Uint32 capacity;
+    Uint32 current; // chunks before this one are full
+} StagingFrame;
+
+typedef struct {
+    bool is_texture;
+    bool cycle;
+    SDL_GPUTransferBuffer* src;
+    Uint32 src_offset;
+    SDL_GPUBufferRegion buffer;
+    SDL_GPUTextureRegion texture;
+} StagingCopy;
+
+static SDL_GPUDevice* ring_device = NULL;
+static StagingFrame frames[STAGING_RING_FRAMES];
+static Uint32 frame_index = 0;
+static StagingCopy* copies = NULL;
+static Uint32 copy_count = 0;
+static Uint32 copy_capacity = 0;
+
+int staging_ring_init (SDL_GPUDevice* device) {
+    if (ring_device) {
+        SDL_Log ("Staging ring already initialized");
+        return 1;
+    }
+    ring_device = device;
+    frame_index = 0;
+    return 0;
+}
+
+void staging_ring_shutdown (void) {
+    if (!ring_device) return;
+    for (Uint32 f = 0; f < STAGING_RING_FRAMES; f++) {
+        StagingFrame* frame = &frames[f];
+        for (Uint32 c = 0; c < frame->count; c++) {
+            StagingChunk* chunk = &frame->chunks[c];
+            if (chunk->map)
+                SDL_UnmapGPUTransferBuffer (ring_device, chunk->buffer);
+            SDL_ReleaseGPUTransferBuffer (ring_device, chunk->buffer);
+        }
+        free (frame->chunks);
+        *frame = (StagingFrame) {0};
+    }
+    free (copies);
+    copies = NULL;
+    copy_count = 0;
+    copy_capacity = 0;
+    ring_device = NULL;
+}
+
+// Returns NULL on failure
+static StagingChunk* add_chunk (StagingFrame* frame, Uint32 min_size) {
+    if (frame->count == frame->capacity) {
+        Uint32 capacity = frame->capacity ? frame->capacity * 2 : 4;
+        StagingChunk* grown = (StagingChunk*) realloc (
+            frame->chunks, capacity * sizeof (StagingChunk)
+        );
+        if (!grown) {
+            SDL_Log ("Failed to grow staging ring");
+            return NULL;
+        }
+        frame->chunks = grown;
+        frame->capacity = capacity;
+    }
+
+    SDL_GPUTransferBufferCreateInfo info = {
+        .size = SDL_max (min_size, STAGING_CHUNK_SIZE),
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
+    };
+    SDL_GPUTransferBuffer* buffer =
+        SDL_CreateGPUTransferBuffer (ring_device, &info);
+    if (!buffer) {
+        SDL_Log ("Failed to create staging buffer: %s", SDL_GetError ());
+        return NULL;
+    }
+    StagingChunk* chunk = &frame->chunks[frame->count++];
+    *chunk = (StagingChunk) {.buffer = buffer, .size = info.size};
+    return chunk;
+}
+
+// Returns NULL on failure
+// fills in where the space lives for the copy that will read it
+static void* staging_alloc (Uint32 size, Uint32 align, StagingCopy* copy) {
+    if (!ring_device) {
+        SDL_Log ("Staging ring is not initialized");
+        return NULL;
+    }
+    StagingFrame* frame = &frames[frame_index];
+
+    StagingChunk* chunk = NULL;
+    Uint32 offset = 0;
+    for (; frame->current < frame->count; frame->current++) {
+        chunk = &frame->chunks[frame->current];
+        offset = (chunk->used + align - 1) & ~(align - 1);
+        if (offset <= chunk->size && size <= chunk->size - offset) break;
+        chunk = NULL;
+    }
+    if (!chunk) {
+        chunk = add_chunk (frame, size);
+        if (!chunk) return NULL; // logging handled in add_chunk()
+        frame->current = frame->count - 1;
+        offset = 0;
+    }
+
+    if (!chunk->map) {
+        // cycling hands back fresh memory if the GPU still reads this one
+        chunk->map = (Uint8*) SDL_MapGPUTransferBuffer (
+            ring_device, chunk->buffer, true
+        );
+        if (!chunk->map) {
+            SDL_Log ("Failed to map staging buffer: %s", SDL_GetError ());
+            return NULL;
+        }
+    }
+
+    if (copy_count == copy_capacity) {
+        Uint32 capacity = copy_capacity ? copy_capacity * 2 : 64;
+        StagingCopy* grown =
+            (StagingCopy*) realloc (copies, capacity * sizeof (StagingCopy));
+        if (!grown) {
+            SDL_Log ("Failed to grow staging copy list");
+            return NULL;
+        }
+        copies = grown;
+        copy_capacity = capacity;
+    }
+
+    chunk->used = offset + size;
+    copy->src = chunk->buffer;
+    copy->src_offset = offset;
+    copies[copy_count++] = *copy;
+    return chunk->map + offset;
+}
+
+void* staging_upload_buffer (
+    SDL_GPUBuffer* buffer,
+    Uint32 offset,
+    Uint32 size,
+    bool cycle
+) {
+    StagingCopy copy = {
+        .is_texture = false,
+        .cycle = cycle,
+        .buffer = {.buffer = buffer, .offset = offset, .size = size}
+    };
+    return staging_alloc (size, STAGING_BUFFER_ALIGN, &copy);
+}
+
+void* staging_upload_texture (const SDL_GPUTextureRegion* region, Uint32 size) {
+    StagingCopy copy = {.is_texture = true, .texture = *region};
+    return staging_alloc (size, STAGING_TEXTURE_ALIGN, &copy);
+}
+
+int staging_ring_flush (SDL_GPUCommandBuffer* cmd) {
+    PROFILE_ZONE ("staging_ring_flush");
+    if (!ring_device) return 0;
+    StagingFrame* frame = &frames[frame_index];
+    for (Uint32 c = 0; c < frame->count; c++) {
+        StagingChunk* chunk = &frame->chunks[c];
+        if (chunk->map) SDL_UnmapGPUTransferBuffer (ring_device, chunk->buffer);
+        chunk->map = NULL;
+        chunk->used = 0;
+    }
+    frame->current = 0;
+    frame_index = (frame_index + 1) % STAGING_RING_FRAMES;
+
+    if (copy_count == 0) return 0;
+    Uint32 count = copy_count;
+    copy_count = 0;
+    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass (cmd);
+    if (!copy_pass) {
+        SDL_Log ("Failed to begin staging copy pass: %s", SDL_GetError ());
+        return 1;
+    }
+    for (Uint32 i = 0; i < count; i++) {
+        const StagingCopy* copy = &copies[i];
+        if (copy->is_texture) {
+            // zero pitches mean tightly packed rows
+            SDL_GPUTextureTransferInfo src = {
+                .transfer_buffer = copy->src, .offset = copy->src_offset
+            };
+            SDL_UploadToGPUTexture (copy_pass, &src, &copy->texture, false);
+        } else {
+            SDL_GPUTransferBufferLocation src = {
+                .transfer_buffer = copy->src, .offset = copy->src_offset
+            };
+            SDL_UploadToGPUBuffer (copy_pass, &src, &copy->buffer, copy->cycle);
+        }
+    }
+    SDL_EndGPUCopyPass (copy_pass);
+    return 0;
+}
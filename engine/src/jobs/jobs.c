@@ -0,0 +1,183 @@
+#include <jobs/jobs.h>
+#include <profiler/profiler.h>
+
+#define JOBS_BATCHES_PER_THREAD 4 // slack for uneven batches
+#define JOBS_MAX_LOOPS 4          // loops from different threads in flight
+
+typedef struct {
+    JobFunc func;
+    void* data;
+    Uint32 count;
+    Uint32 batch;
+    Uint32 batches;
+    SDL_AtomicInt next_batch;
+    Uint32 helpers; // workers inside run_batches(), under lock
+    bool active;    // claimed by a submitter, under lock
+} JobLoop;
+
+static SDL_Thread* workers[JOBS_MAX_WORKERS];
+static Uint32 worker_count = 0;
+
+static SDL_Mutex* lock = NULL;
+static SDL_Condition* wake = NULL;
+static SDL_Condition* done = NULL;
+
+// one slot per submitting thread, so the frame thread and the main thread
+// can both spread a loop over the workers at once
+static JobLoop loops[JOBS_MAX_LOOPS];
+static bool quitting = false;
+
+// set while the thread runs job bodies; a loop issued from inside one runs
+// inline rather than waiting on workers that may be waiting on it
+static _Thread_local bool in_job = false;
+
+static void run_batches (JobLoop* loop) {
+    in_job = true;
+    for (;;) {
+        Uint32 batch = (Uint32) SDL_AddAtomicInt (&loop->next_batch, 1);
+        if (batch >= loop->batches) break;
+        Uint32 start = batch * loop->batch;
+        Uint32 end = SDL_min (start + loop->batch, loop->count);
+        loop->func (loop->data, start, end);
+    }
+    in_job = false;
+}
+
+// NULL when no loop has batches left to hand out; called under lock
+static JobLoop* open_loop (Uint32 first) {
+    for (Uint32 i = 0; i < JOBS_MAX_LOOPS; i++) {
+        JobLoop* loop = &loops[(first + i) % JOBS_MAX_LOOPS];
+        if (loop->active &&
+            (Uint32) SDL_GetAtomicInt (&loop->next_batch) < loop->batches)
+            return loop;
+    }
+    return NULL;
+}
+
+static int SDLCALL worker_main (void* data) {
+    // workers start their search at different slots to spread over loops
+    Uint32 first = (Uint32) (uintptr_t) data;
+    profiler_register_thread ("Worker");
+
+    SDL_LockMutex (lock);
+    for (;;) {
+        JobLoop* loop = NULL;
+        while (!quitting && !(loop = open_loop (first)))
+            SDL_WaitCondition (wake, lock);
+        if (quitting) break;
+        loop->helpers++;
+        SDL_UnlockMutex (lock);
+
+        run_batches (loop);
+
+        SDL_LockMutex (lock);
+        if (--loop->helpers == 0) SDL_BroadcastCondition (done);
+    }
+    SDL_UnlockMutex (lock);
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+int jobs_init (Uint32 num_workers) {
+    if (num_workers == 0) {
+        int cores = SDL_GetNumLogicalCPUCores ();
+        num_workers = cores > 1 ? (Uint32) cores - 1 : 0;
+    }
+    num_workers = SDL_min (num_workers, JOBS_MAX_WORKERS);
+
+    lock = SDL_CreateMutex ();
+    wake = SDL_CreateCondition ();
+    done = SDL_CreateCondition ();
+    if (!lock || !wake || !done) {
+        SDL_Log ("Failed to create job system locks: %s", SDL_GetError ());
+        jobs_shutdown ();
+        return 1;
+    }
+
+    quitting = false;
+    for (Uint32 i = 0; i < num_workers; i++) {
+        workers[i] = SDL_CreateThread (
+            worker_main, "job_worker", (void*) (uintptr_t) i
+        );
+        if (!workers[i]) {
+            SDL_Log ("Failed to create job worker: %s", SDL_GetError ());
+            jobs_shutdown ();
+            return 1;
+        }
+        worker_count++;
+    }
+    return 0;
+}
+
+void jobs_shutdown (void) {
+    if (lock) {
+        SDL_LockMutex (lock);
+        quitting = true;
+        SDL_BroadcastCondition (wake);
+        SDL_UnlockMutex (lock);
+    }
+    for (Uint32 i = 0; i < worker_count; i++) SDL_WaitThread (workers[i], NULL);
+    worker_count = 0;
+
+    if (done) SDL_DestroyCondition (done);
+    if (wake) SDL_DestroyCondition (wake);
+    if (lock) SDL_DestroyMutex (lock);
+    done = NULL;
+    wake = NULL;
+    lock = NULL;
+}
+
+Uint32 jobs_worker_count (void) {
+    return worker_count;
+}
+
+void jobs_parallel_for (
+    Uint32 count,
+    Uint32 min_batch,
+    JobFunc func,
+    void* data
+) {
+    if (count == 0) return;
+    if (min_batch == 0) min_batch = 1;
+
+    Uint32 threads = worker_count + 1;
+    Uint32 batch = count / (threads * JOBS_BATCHES_PER_THREAD);
+    batch = SDL_max (batch, min_batch);
+    Uint32 batches = (count + batch - 1) / batch;
+
+    // nested loops fall back to the calling thread
+    if (worker_count == 0 || batches == 1 || in_job) {
+        func (data, 0, count);
+        return;
+    }
+
+    SDL_LockMutex (lock);
+    JobLoop* loop = NULL;
+    for (Uint32 i = 0; i < JOBS_MAX_LOOPS && !loop; i++)
+        if (!loops[i].active) loop = &loops[i];
+    if (!loop) {
+        // more concurrent submitters than slots
+        SDL_UnlockMutex (lock);
+        func (data, 0, count);
+        return;
+    }
+
+    PROFILE_ZONE ("jobs_parallel_for");
+    loop->func = func;
+    loop->data = data;
+    loop->count = count;
+    loop->batch = batch;
+    loop->batches = batches;
+    SDL_SetAtomicInt (&loop->next_batch, 0);
+    loop->helpers = 0;
+    loop->active = true;
+    SDL_BroadcastCondition (wake);
+    SDL_UnlockMutex (lock);
+
+    run_batches (loop);
+
+    SDL_LockMutex (lock);
+    while (loop->helpers > 0) SDL_WaitCondition (done, lock);
+    loop->active = false;
+    SDL_UnlockMutex (lock);
+}
@@ -5,9 +5,10 @@ MaterialComponent
 create_basic_material (vec3 color, MaterialSide side, gpu_renderer* renderer) {
     MaterialComponent mat = {
         .color = color,
-        .texture = NULL,
+        .texture_array = NULL,
         .vertex_shader = NULL,
         .fragment_shader = NULL,
+        .compact_vertex_shader = NULL,
         .side = side
     };
 
@@ -19,6 +20,12 @@ create_basic_material (vec3 color, MaterialSide side, gpu_renderer* renderer) {
         return mat;
     };
 
+    // compact meshes are skipped by this material if this fails
+    int compact_failed = set_compact_vertex_shader (
+        renderer, &mat, "shaders/basic_material_compact.vert.spv"
+    );
+    if (compact_failed) mat.compact_vertex_shader = NULL;
+
     int frag_failed = set_fragment_shader (
         renderer, &mat, "shaders/basic_material.frag.spv", 1, 0
     );
@@ -0,0 +1,365 @@
+#include <math.h>
+#include <string.h>
+
+#include <material/bc_encode.h>
+
+#define AXIS_ITERATIONS 8 // power iterations for the principal axis
+
+static const int bc7_weights[16] =
+    {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+// endpoints of the segment through the block's principal axis that spans
+// every texel, over the first channels components
+static void fit_endpoints (
+    const Uint8* rgba,
+    int channels,
+    float lo[4],
+    float hi[4]
+) {
+    float mean[4] = {0};
+    for (int i = 0; i < BC_BLOCK_TEXELS; i++)
+        for (int c = 0; c < channels; c++) mean[c] += rgba[i * 4 + c];
+    for (int c = 0; c < channels; c++) mean[c] /= BC_BLOCK_TEXELS;
+
+    float cov[4][4] = {0};
+    for (int i = 0; i < BC_BLOCK_TEXELS; i++) {
+        float d[4];
+        for (int c = 0; c < channels; c++) d[c] = rgba[i * 4 + c] - mean[c];
+        for (int a = 0; a < channels; a++)
+            for (int b = 0; b < channels; b++) cov[a][b] += d[a] * d[b];
+    }
+
+    float axis[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    for (int it = 0; it < AXIS_ITERATIONS; it++) {
+        float next[4] = {0};
+        float length = 0.0f;
+        for (int a = 0; a < channels; a++) {
+            for (int b = 0; b < channels; b++) next[a] += cov[a][b] * axis[b];
+            length = SDL_max (length, fabsf (next[a]));
+        }
+        if (length < 1e-6f) break; // flat block
+        for (int c = 0; c < channels; c++) axis[c] = next[c] / length;
+    }
+
+    float norm = 0.0f;
+    for (int c = 0; c < channels; c++) norm += axis[c] * axis[c];
+    norm = norm > 0.0f ? 1.0f / sqrtf (norm) : 0.0f;
+
+    float t_min = 0.0f;
+    float t_max = 0.0f;
+    for (int i = 0; i < BC_BLOCK_TEXELS; i++) {
+        float t = 0.0f;
+        for (int c = 0; c < channels; c++)
+            t += (rgba[i * 4 + c] - mean[c]) * axis[c] * norm;
+        t_min = SDL_min (t_min, t);
+        t_max = SDL_max (t_max, t);
+    }
+    for (int c = 0; c < channels; c++) {
+        lo[c] = SDL_clamp (mean[c] + axis[c] * norm * t_min, 0.0f, 255.0f);
+        hi[c] = SDL_clamp (mean[c] + axis[c] * norm * t_max, 0.0f, 255.0f);
+    }
+}
+
+// least-squares endpoints for the given interpolation weights (0..1 per
+// texel); leaves lo and hi alone when the weights are degenerate
+static void refine_endpoints (
+    const Uint8* rgba,
+    int channels,
+    const float* weights,
+    float lo[4],
+    float hi[4]
+) {
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[4] = {0}, bx[4] = {0};
+    for (int i = 0; i < BC_BLOCK_TEXELS; i++) {
+        float b = weights[i];
+        float a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < channels; c++) {
+            ax[c] += a * rgba[i * 4 + c];
+            bx[c] += b * rgba[i * 4 + c];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (fabsf (det) < 1e-6f) return;
+    for (int c = 0; c < channels; c++) {
+        lo[c] = SDL_clamp ((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+        hi[c] = SDL_clamp ((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+    }
+}
+
+static int texel_error (const Uint8* texel, const int* colour, int channels) {
+    int error = 0;
+    for (int c = 0; c < channels; c++) {
+        int d = texel[c] - colour[c];
+        error += d * d;
+    }
+    return error;
+}
+
+// BC1 / BC3 colour
+
+static Uint16 pack_565 (const float* rgb) {
+    int r = (int) (rgb[0] * 31.0f / 255.0f + 0.5f);
+    int g = (int) (rgb[1] * 63.0f / 255.0f + 0.5f);
+    int b = (int) (rgb[2] * 31.0f / 255.0f + 0.5f);
+    return (Uint16) ((r << 11) | (g << 5) | b);
+}
+
+static void unpack_565 (Uint16 c, int* rgb) {
+    int r = (c >> 11) & 31;
+    int g = (c >> 5) & 63;
+    int b = c & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Returns the total squared error
+static int colour_indices (
+    const Uint8* rgba,
+    Uint16 c0,
+    Uint16 c1,
+    Uint32* out
+) {
+    int palette[4][3];
+    unpack_565 (c0, palette[0]);
+    unpack_565 (c1, palette[1]);
+    for (int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    Uint32 indices = 0;
+    int total = 0;
+    for (int i = 0; i < BC_BLOCK_TEXELS; i++) {
+        int best = 0;
+        int best_error = texel_error (&rgba[i * 4], palette[0], 3);
+        for (int p = 1; p < 4; p++) {
+            int error = texel_error (&rgba[i * 4], palette[p], 3);
+            if (error < best_error) {
+                best = p;
+                best_error = error;
+            }
+        }
+        indices |= (Uint32) best << (i * 2);
+        total += best_error;
+    }
+    *out = indices;
+    return total;
+}
+
+// four-colour mode needs c0 > c1, which also reads as four-colour in BC3
+static void write_colour_block (
+    const float* lo,
+    const float* hi,
+    const Uint8* rgba,
+    Uint8 out[8]
+) {
+    Uint16 c0 = pack_565 (hi);
+    Uint16 c1 = pack_565 (lo);
+    Uint32 indices = 0;
+    if (c0 < c1) {
+        Uint16 tmp = c0;
+        c0 = c1;
+        c1 = tmp;
+    }
+    if (c0 != c1) colour_indices (rgba, c0, c1, &indices);
+
+    out[0] = (Uint8) c0;
+    out[1] = (Uint8) (c0 >> 8);
+    out[2] = (Uint8) c1;
+    out[3] = (Uint8) (c1 >> 8);
+    for (int i = 0; i < 4; i++) out[4 + i] = (Uint8) (indices >> (i * 8));
+}
+
+static void encode_colour (const Uint8* rgba, Uint8 out[8]) {
+    static const float colour_weights[4] =
+        {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+    float lo[4];
+    float hi[4];
+    fit_endpoints (rgba, 3, lo, hi);
+    write_colour_block (lo, hi, rgba, out);
+
+    // refit to the chosen indices and keep whichever block is closer
+    Uint16 c0 = (Uint16) (out[0] | out[1] << 8);
+    Uint16 c1 = (Uint16) (out[2] | out[3] << 8);
+    if (c0 == c1) return;
+    Uint32 indices;
+    int error = colour_indices (rgba, c0, c1, &indices);
+    float weights[BC_BLOCK_TEXELS];
+    for (int i = 0; i < BC_BLOCK_TEXELS; i++)
+        weights[i] = colour_weights[(indices >> (i * 2)) & 3];
+    float refined_lo[4];
+    float refined_hi[4];
+    int palette[3];
+    unpack_565 (c0, palette);
+    for (int c = 0; c < 3; c++) refined_lo[c] = (float) palette[c];
+    unpack_565 (c1, palette);
+    for (int c = 0; c < 3; c++) refined_hi[c] = (float) palette[c];
+    refine_endpoints (rgba, 3, weights, refined_lo, refined_hi);
+
+    Uint8 refined[8];
+    write_colour_block (refined_hi, refined_lo, rgba, refined);
+    Uint16 r0 = (Uint16) (refined[0] | refined[1] << 8);
+    Uint16 r1 = (Uint16) (refined[2] | refined[3] << 8);
+    if (r0 != r1 && colour_indices (rgba, r0, r1, &indices) < error)
+        memcpy (out, refined, 8);
+}
+
+void encode_bc1_block (const Uint8 rgba[BC_BLOCK_TEXELS * 4], Uint8 out[8]) {
+    encode_colour (rgba, out);
+}
+
+// BC3 alpha
+
+static void encode_alpha (const Uint8* rgba, Uint8 out[8]) {
+    int a0 = 0;
+    int a1 = 255;
+    for (int i = 0; i < BC_BLOCK_TEXELS; i++) {
+        a0 = SDL_max (a0, rgba[i * 4 + 3]);
+        a1 = SDL_min (a1, rgba[i * 4 + 3]);
+    }
+    out[0] = (Uint8) a0;
+    out[1] = (Uint8) a1;
+
+    // eight-value mode (a0 > a1): a0, a1, then six steps from a0 to a1
+    int palette[8] = {a0, a1};
+    for (int p = 1; p < 7; p++) palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+
+    Uint64 indices = 0;
+    for (int i = 0; i < BC_BLOCK_TEXELS && a0 != a1; i++) {
+        int alpha = rgba[i * 4 + 3];
+        int best = 0;
+        for (int p = 1; p < 8; p++)
+            if (SDL_abs (alpha - palette[p]) < SDL_abs (alpha - palette[best]))
+                best = p;
+        indices |= (Uint64) best << (i * 3);
+    }
+    for (int i = 0; i < 6; i++) out[2 + i] = (Uint8) (indices >> (i * 8));
+}
+
+void encode_bc3_block (const Uint8 rgba[BC_BLOCK_TEXELS * 4], Uint8 out[16]) {
+    encode_alpha (rgba, out);
+    encode_colour (rgba, out + 8);
+}
+
+// BC7 mode 6
+
+typedef struct {
+    Uint8 endpoint[2][4]; // 7-bit
+    Uint8 pbit[2];
+    Uint8 indices[BC_BLOCK_TEXELS];
+    int error;
+} Bc7Mode6;
+
+// picks the 7-bit endpoint and p-bit closest to the 8-bit target
+static void quantize_bc7_endpoint (const float* target, Uint8* q, Uint8* p) {
+    int best_error = -1;
+    for (int pbit = 0; pbit < 2; pbit++) {
+        Uint8 candidate[4];
+        int error = 0;
+        for (int c = 0; c < 4; c++) {
+            int v = (int) ((target[c] - pbit) / 2.0f + 0.5f);
+            candidate[c] = (Uint8) SDL_clamp (v, 0, 127);
+            int d = ((candidate[c] << 1) | pbit) - (int) (target[c] + 0.5f);
+            error += d * d;
+        }
+        if (best_error < 0 || error < best_error) {
+            best_error = error;
+            memcpy (q, candidate, 4);
+            *p = (Uint8) pbit;
+        }
+    }
+}
+
+static void bc7_indices (const Uint8* rgba, Bc7Mode6* block) {
+    int e[2][4];
+    for (int s = 0; s < 2; s++)
+        for (int c = 0; c < 4; c++)
+            e[s][c] = (block->endpoint[s][c] << 1) | block->pbit[s];
+
+    int palette[16][4];
+    for (int p = 0; p < 16; p++)
+        for (int c = 0; c < 4; c++)
+            palette[p][c] =
+                ((64 - bc7_weights[p]) * e[0][c] + bc7_weights[p] * e[1][c] +
+                 32) >>
+                6;
+
+    block->error = 0;
+    for (int i = 0; i < BC_BLOCK_TEXELS; i++) {
+        int best = 0;
+        int best_error = texel_error (&rgba[i * 4], palette[0], 4);
+        for (int p = 1; p < 16; p++) {
+            int error = texel_error (&rgba[i * 4], palette[p], 4);
+            if (error < best_error) {
+                best = p;
+                best_error = error;
+            }
+        }
+        block->indices[i] = (Uint8) best;
+        block->error += best_error;
+    }
+}
+
+static void bc7_from_endpoints (
+    const Uint8* rgba,
+    const float* lo,
+    const float* hi,
+    Bc7Mode6* block
+) {
+    quantize_bc7_endpoint (lo, block->endpoint[0], &block->pbit[0]);
+    quantize_bc7_endpoint (hi, block->endpoint[1], &block->pbit[1]);
+    bc7_indices (rgba, block);
+}
+
+// appends count bits of value at *bit, least significant first
+static void put_bits (Uint8* out, int* bit, Uint32 value, int count) {
+    for (int i = 0; i < count; i++, (*bit)++)
+        if (value & (1u << i)) out[*bit >> 3] |= (Uint8) (1u << (*bit & 7));
+}
+
+void encode_bc7_block (const Uint8 rgba[BC_BLOCK_TEXELS * 4], Uint8 out[16]) {
+    float lo[4];
+    float hi[4];
+    fit_endpoints (rgba, 4, lo, hi);
+    Bc7Mode6 block;
+    bc7_from_endpoints (rgba, lo, hi, &block);
+
+    float weights[BC_BLOCK_TEXELS];
+    for (int i = 0; i < BC_BLOCK_TEXELS; i++)
+        weights[i] = bc7_weights[block.indices[i]] / 64.0f;
+    refine_endpoints (rgba, 4, weights, lo, hi);
+    Bc7Mode6 refined;
+    bc7_from_endpoints (rgba, lo, hi, &refined);
+    if (refined.error < block.error) block = refined;
+
+    // the first index is stored without its top bit, so it must be below 8
+    if (block.indices[0] >= 8) {
+        for (int c = 0; c < 4; c++) {
+            Uint8 tmp = block.endpoint[0][c];
+            block.endpoint[0][c] = block.endpoint[1][c];
+            block.endpoint[1][c] = tmp;
+        }
+        Uint8 tmp = block.pbit[0];
+        block.pbit[0] = block.pbit[1];
+        block.pbit[1] = tmp;
+        for (int i = 0; i < BC_BLOCK_TEXELS; i++)
+            block.indices[i] = (Uint8) (15 - block.indices[i]);
+    }
+
+    memset (out, 0, 16);
+    int bit = 0;
+    put_bits (out, &bit, 1u << 6, 7); // mode 6
+    for (int c = 0; c < 4; c++)
+        for (int s = 0; s < 2; s++)
+            put_bits (out, &bit, block.endpoint[s][c], 7);
+    put_bits (out, &bit, block.pbit[0], 1);
+    put_bits (out, &bit, block.pbit[1], 1);
+    put_bits (out, &bit, block.indices[0], 3);
+    for (int i = 1; i < BC_BLOCK_TEXELS; i++)
+        put_bits (out, &bit, block.indices[i], 4);
+}
@@ -0,0 +1,76 @@
+#include <material/depth_prepass.h>
+#include <material/m_common.h>
+
+#define LAYOUT_COUNT (VERTEX_LAYOUT_SEPARATE + 1)
+#define SIDE_COUNT (SIDE_DOUBLE + 1)
+
+static SDL_GPUDevice* prepass_device = NULL;
+static SDL_GPUGraphicsPipeline* pipelines[LAYOUT_COUNT][SIDE_COUNT];
+
+int depth_prepass_init (gpu_renderer* renderer) {
+    if (prepass_device) {
+        SDL_Log ("Depth pre-pass already initialized");
+        return 1;
+    }
+    SDL_GPUDevice* device = renderer->device;
+
+    SDL_GPUShader* vertex_shader = load_shader (
+        device, "shaders/depth_only.vert.spv", SDL_GPU_SHADERSTAGE_VERTEX, 0,
+        1, 0, 0
+    );
+    SDL_GPUShader* fragment_shader = load_shader (
+        device, "shaders/depth_only.frag.spv", SDL_GPU_SHADERSTAGE_FRAGMENT,
+        0, 0, 0, 0
+    );
+    // logging handled in load_shader()
+    SDL_GPUShader* compact_vertex_shader = load_shader (
+        device, "shaders/depth_only_compact.vert.spv",
+        SDL_GPU_SHADERSTAGE_VERTEX, 0, 1, 0, 0
+    );
+
+    if (vertex_shader && fragment_shader) {
+        prepass_device = device;
+        for (int layout = 0; layout < LAYOUT_COUNT; layout++) {
+            SDL_GPUShader* shader = layout == VERTEX_LAYOUT_COMPACT
+                                        ? compact_vertex_shader
+                                        : vertex_shader;
+            if (!shader) continue;
+            for (int side = 0; side < SIDE_COUNT; side++) {
+                // logging handled in create_mesh_pipeline()
+                pipelines[layout][side] = create_mesh_pipeline (
+                    device, shader, fragment_shader, renderer->format,
+                    (VertexLayout) layout,
+                    side_cull_mode ((MaterialSide) side), MESH_DEPTH_ONLY
+                );
+            }
+        }
+    }
+
+    // the pipelines keep what they need
+    if (vertex_shader) SDL_ReleaseGPUShader (device, vertex_shader);
+    if (compact_vertex_shader)
+        SDL_ReleaseGPUShader (device, compact_vertex_shader);
+    if (fragment_shader) SDL_ReleaseGPUShader (device, fragment_shader);
+    if (!prepass_device) return 1; // logging handled in load_shader()
+    return 0;
+}
+
+void depth_prepass_shutdown (void) {
+    if (!prepass_device) return;
+    for (int layout = 0; layout < LAYOUT_COUNT; layout++) {
+        for (int side = 0; side < SIDE_COUNT; side++) {
+            if (pipelines[layout][side])
+                SDL_ReleaseGPUGraphicsPipeline (
+                    prepass_device, pipelines[layout][side]
+                );
+            pipelines[layout][side] = NULL;
+        }
+    }
+    prepass_device = NULL;
+}
+
+SDL_GPUGraphicsPipeline*
+depth_prepass_pipeline (VertexLayout layout, MaterialSide side) {
+    if (layout >= LAYOUT_COUNT || side >= SIDE_COUNT) return NULL;
+    return pipelines[layout][side];
+}
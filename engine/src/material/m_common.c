@@ -3,7 +3,12 @@
 #include <SDL3/SDL_gpu.h>
 #include <SDL3_image/SDL_image.h>
 
+#include <geometry/g_common.h>
 #include <material/m_common.h>
+#include <material/pipeline_cache.h>
+#include <material/texture_array.h>
+#include <material/texture_file.h>
+#include <profiler/profiler.h>
 
 // shader loader helper function
 SDL_GPUShader* load_shader (
@@ -15,6 +20,7 @@ SDL_GPUShader* load_shader (
     Uint32 storage_buffer_count,
     Uint32 storage_texture_count
 ) {
+    PROFILE_ZONE ("load_shader");
     if (!SDL_GetPathInfo (filename, NULL)) {
         SDL_Log ("Couldn't read file %s: %s", filename, SDL_GetError ());
         return NULL;
@@ -51,18 +57,96 @@ SDL_GPUShader* load_shader (
     return shader;
 }
 
+SDL_GPUComputePipeline* load_compute_pipeline (
+    SDL_GPUDevice* device,
+    const char* filename,
+    SDL_GPUComputePipelineCreateInfo info
+) {
+    PROFILE_ZONE ("load_compute_pipeline");
+    Uint64 code_size;
+    void* code = SDL_LoadFile (filename, &code_size);
+    if (code == NULL) {
+        SDL_Log ("Couldn't read file %s: %s", filename, SDL_GetError ());
+        return NULL;
+    }
+
+    info.code = (const Uint8*) code;
+    info.code_size = code_size;
+    info.entrypoint = "main";
+    info.format = SDL_GPU_SHADERFORMAT_SPIRV;
+    SDL_GPUComputePipeline* pipeline =
+        SDL_CreateGPUComputePipeline (device, &info);
+    SDL_free (code);
+    if (pipeline == NULL) {
+        SDL_Log ("Couldn't create compute pipeline: %s", SDL_GetError ());
+        return NULL;
+    }
+    return pipeline;
+}
+
+Uint32 mip_level_count (Uint32 width, Uint32 height) {
+    Uint32 levels = 1;
+    for (Uint32 size = SDL_max (width, height); size > 1; size >>= 1) levels++;
+    return levels;
+}
+
+// blitting the chain down from level 0 needs every level to be a target
+SDL_GPUTextureUsageFlags mip_texture_usage (Uint32 num_levels) {
+    if (num_levels > 1)
+        return SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET;
+    return SDL_GPU_TEXTUREUSAGE_SAMPLER;
+}
+
+// trilinear, repeating sampler for mipmapped textures
+SDL_GPUSampler*
+create_texture_sampler (SDL_GPUDevice* device, float max_anisotropy) {
+    SDL_GPUSamplerCreateInfo sampler_info = {
+        .min_filter = SDL_GPU_FILTER_LINEAR,
+        .mag_filter = SDL_GPU_FILTER_LINEAR,
+        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
+        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
+        .max_lod = TEXTURE_MAX_LOD,
+        .max_anisotropy = SDL_max (max_anisotropy, 1.0f),
+        .enable_anisotropy = max_anisotropy > 1.0f
+    };
+    SDL_GPUSampler* sampler = SDL_CreateGPUSampler (device, &sampler_info);
+    if (!sampler) SDL_Log ("Failed to create sampler: %s", SDL_GetError ());
+    return sampler;
+}
+
 // texture loader helper function
 SDL_GPUTexture*
 load_texture (SDL_GPUDevice* device, const char* bmp_file_path) {
-    // note to self: don't forget to look at texture wrapping, texture
-    // filtering, mipmaps https://learnopengl.com/Getting-started/Textures load
-    // texture
+    return load_texture_with_info (device, bmp_file_path, NULL);
+}
+
+SDL_GPUTexture* load_texture_with_info (
+    SDL_GPUDevice* device,
+    const char* bmp_file_path,
+    SDL_GPUTextureCreateInfo* info
+) {
+    PROFILE_ZONE ("load_texture");
     // does the file exist
     if (!SDL_GetPathInfo (bmp_file_path, NULL)) {
         SDL_Log ("Couldn't read file: %s", SDL_GetError ());
         return NULL;
     }
 
+    // files from texconv are uploaded as stored, blocks and mips included
+    if (is_texture_file_path (bmp_file_path)) {
+        MappedFile file;
+        if (map_file (bmp_file_path, &file)) {
+            SDL_Log ("Failed to open %s", bmp_file_path);
+            return NULL;
+        }
+        SDL_GPUTexture* texture =
+            upload_texture_file (device, &file, bmp_file_path, info);
+        unmap_file (&file);
+        return texture; // logging handled in upload_texture_file()
+    }
+
     // surface
     SDL_Surface* surface = IMG_Load (bmp_file_path);
     if (surface == NULL) {
@@ -76,20 +160,23 @@ load_texture (SDL_GPUDevice* device, const char* bmp_file_path) {
         SDL_Log ("Failed to convert surface format: %s", SDL_GetError ());
         return NULL;
     }
+    Uint32 num_levels =
+        mip_level_count ((Uint32) abgr_surface->w, (Uint32) abgr_surface->h);
     SDL_GPUTextureCreateInfo tex_create_info = {
         .type = SDL_GPU_TEXTURETYPE_2D,
         .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM, // RGBA,
         .width = (Uint32) abgr_surface->w,
         .height = (Uint32) abgr_surface->h,
         .layer_count_or_depth = 1,
-        .num_levels = 1,
-        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER
+        .num_levels = num_levels,
+        .usage = mip_texture_usage (num_levels)
     };
     SDL_GPUTexture* texture = SDL_CreateGPUTexture (device, &tex_create_info);
     if (texture == NULL) {
         SDL_Log ("Failed to create texture: %s", SDL_GetError ());
         return NULL;
     }
+    if (info) *info = tex_create_info;
 
     // create transfer buffer
     SDL_GPUTransferBufferCreateInfo transfer_info = {
@@ -137,6 +224,7 @@ load_texture (SDL_GPUDevice* device, const char* bmp_file_path) {
     };
     SDL_UploadToGPUTexture (copy_pass, &src_info, &dst_region, false);
     SDL_EndGPUCopyPass (copy_pass);
+    if (num_levels > 1) SDL_GenerateMipmapsForGPUTexture (upload_cmd, texture);
     SDL_SubmitGPUCommandBuffer (upload_cmd);
     SDL_ReleaseGPUTransferBuffer (device, transfer_buf);
     SDL_DestroySurface (abgr_surface);
@@ -145,9 +233,10 @@ load_texture (SDL_GPUDevice* device, const char* bmp_file_path) {
 }
 
 // used for solid-color objects
-SDL_GPUTexture* create_white_texture (SDL_GPUDevice* device) {
+static SDL_GPUTexture*
+create_white (SDL_GPUDevice* device, SDL_GPUTextureType type) {
     SDL_GPUTextureCreateInfo tex_info = {
-        .type = SDL_GPU_TEXTURETYPE_2D,
+        .type = type,
         .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
         .width = 1,
         .height = 1,
@@ -228,20 +317,75 @@ SDL_GPUTexture* create_white_texture (SDL_GPUDevice* device) {
     return tex;
 }
 
+SDL_GPUTexture* create_white_texture (SDL_GPUDevice* device) {
+    return create_white (device, SDL_GPU_TEXTURETYPE_2D);
+}
+
+SDL_GPUTexture* create_white_texture_array (SDL_GPUDevice* device) {
+    return create_white (device, SDL_GPU_TEXTURETYPE_2D_ARRAY);
+}
+
+static int build_pipeline (
+    SDL_GPUDevice* device,
+    MaterialComponent* mat,
+    SDL_GPUTextureFormat swapchain_format,
+    VertexLayout layout
+);
+
+static void
+release_shader (SDL_GPUDevice* device, SDL_GPUShader** shader) {
+    if (*shader) pipeline_cache_release_shader (device, *shader);
+    *shader = NULL;
+}
+
+static void
+release_pipeline (SDL_GPUDevice* device, SDL_GPUGraphicsPipeline** pipeline) {
+    if (*pipeline) pipeline_cache_release_pipeline (device, *pipeline);
+    *pipeline = NULL;
+}
+
 // returns 0 on success 1 on failure
 int set_vertex_shader (
     gpu_renderer* renderer,
     MaterialComponent* mat,
     const char* filepath
 ) {
-    mat->vertex_shader = load_shader (
+    release_shader (renderer->device, &mat->vertex_shader);
+    mat->vertex_shader = pipeline_cache_shader (
         renderer->device, filepath, SDL_GPU_SHADERSTAGE_VERTEX, 0, 1, 0, 0
     );
     if (mat->vertex_shader == NULL)
-        return 1; // logging handled in load_shader()
+        return 1; // logging handled in pipeline_cache_shader()
     if (mat->vertex_shader && mat->fragment_shader) {
-        int pipe_failed =
-            build_pipeline (renderer->device, mat, renderer->format);
+        int pipe_failed = build_pipeline (
+            renderer->device, mat, renderer->format, VERTEX_LAYOUT_STANDARD
+        );
+        if (pipe_failed) return 1; // logging handled in build_pipeline()
+        // same shader reading three streams; only those meshes are skipped
+        // without it
+        build_pipeline (
+            renderer->device, mat, renderer->format, VERTEX_LAYOUT_SEPARATE
+        );
+    }
+    return 0;
+}
+
+// returns 0 on success 1 on failure
+int set_compact_vertex_shader (
+    gpu_renderer* renderer,
+    MaterialComponent* mat,
+    const char* filepath
+) {
+    release_shader (renderer->device, &mat->compact_vertex_shader);
+    mat->compact_vertex_shader = pipeline_cache_shader (
+        renderer->device, filepath, SDL_GPU_SHADERSTAGE_VERTEX, 0, 1, 0, 0
+    );
+    if (mat->compact_vertex_shader == NULL)
+        return 1; // logging handled in pipeline_cache_shader()
+    if (mat->compact_vertex_shader && mat->fragment_shader) {
+        int pipe_failed = build_pipeline (
+            renderer->device, mat, renderer->format, VERTEX_LAYOUT_COMPACT
+        );
         if (pipe_failed) return 1; // logging handled in build_pipeline()
     }
     return 0;
@@ -255,101 +399,240 @@ int set_fragment_shader (
     Uint32 sampler_count,
     Uint32 uniform_buffer_count
 ) {
-    mat->fragment_shader = load_shader (
+    release_shader (renderer->device, &mat->fragment_shader);
+    mat->fragment_shader = pipeline_cache_shader (
         renderer->device, filepath, SDL_GPU_SHADERSTAGE_FRAGMENT, sampler_count,
         uniform_buffer_count, 0, 0
     );
     if (mat->fragment_shader == NULL)
-        return 1; // logging handled in load_shader()
+        return 1; // logging handled in pipeline_cache_shader()
     if (mat->vertex_shader && mat->fragment_shader) {
-        int pipe_failed =
-            build_pipeline (renderer->device, mat, renderer->format);
+        int pipe_failed = build_pipeline (
+            renderer->device, mat, renderer->format, VERTEX_LAYOUT_STANDARD
+        );
         if (pipe_failed) return 1; // logging handled in build_pipeline()
+        // same shader reading three streams; only those meshes are skipped
+        // without it
+        build_pipeline (
+            renderer->device, mat, renderer->format, VERTEX_LAYOUT_SEPARATE
+        );
+    }
+    if (mat->compact_vertex_shader && mat->fragment_shader) {
+        // without it only compact meshes are skipped; logging handled inside
+        build_pipeline (
+            renderer->device, mat, renderer->format, VERTEX_LAYOUT_COMPACT
+        );
     }
     return 0;
 }
 
-// returns 0 on success 1 on failure
-static int build_pipeline (
-    SDL_GPUDevice* device,
-    MaterialComponent* mat,
-    SDL_GPUTextureFormat swapchain_format
-) {
-    SDL_GPUCullMode cullmode = SDL_GPU_CULLMODE_BACK; // back culling default
-    switch (mat->side) {
-    case SIDE_FRONT:
-        cullmode = SDL_GPU_CULLMODE_BACK;
-        break;
+SDL_GPUCullMode side_cull_mode (MaterialSide side) {
+    switch (side) {
     case SIDE_BACK:
-        cullmode = SDL_GPU_CULLMODE_FRONT;
-        break;
+        return SDL_GPU_CULLMODE_FRONT;
     case SIDE_DOUBLE:
-        cullmode = SDL_GPU_CULLMODE_NONE;
-        break;
+        return SDL_GPU_CULLMODE_NONE;
+    case SIDE_FRONT:
+    default:
+        return SDL_GPU_CULLMODE_BACK; // back culling default
     }
+}
+
+SDL_GPUGraphicsPipeline* create_mesh_pipeline (
+    SDL_GPUDevice* device,
+    SDL_GPUShader* vertex_shader,
+    SDL_GPUShader* fragment_shader,
+    SDL_GPUTextureFormat target_format,
+    VertexLayout layout,
+    SDL_GPUCullMode cull_mode,
+    MeshDepthMode depth_mode
+) {
+    PROFILE_ZONE ("create_mesh_pipeline");
+    // per-draw ObjectData follows the mesh's own streams
+    SDL_GPUVertexAttribute
+        attributes[VERTEX_ATTRIBUTE_COUNT + OBJECT_ATTRIBUTE_COUNT];
+    SDL_GPUVertexBufferDescription buffers[VERTEX_ATTRIBUTE_COUNT + 1];
+    Uint32 num_buffers = get_vertex_layout (layout, attributes, buffers);
+    get_object_layout (
+        num_buffers, attributes + VERTEX_ATTRIBUTE_COUNT, &buffers[num_buffers]
+    );
+    num_buffers++;
+
+    // the pre-pass shares the render pass, so keeps its color target but
+    // masks every channel
+    SDL_GPUColorTargetDescription color_target = {.format = target_format};
+    if (depth_mode == MESH_DEPTH_ONLY) {
+        color_target.blend_state = (SDL_GPUColorTargetBlendState) {
+            .color_write_mask = 0, .enable_color_write_mask = true
+        };
+    } else if (depth_mode == MESH_DEPTH_BLENDED) {
+        color_target.blend_state = (SDL_GPUColorTargetBlendState) {
+            .enable_blend = true,
+            .src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA,
+            .dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+            .color_blend_op = SDL_GPU_BLENDOP_ADD,
+            .src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE,
+            .dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+            .alpha_blend_op = SDL_GPU_BLENDOP_ADD
+        };
+    }
+
     SDL_GPUGraphicsPipelineCreateInfo pipe_info = {
         .target_info =
             {
                 .num_color_targets = 1,
-                .color_target_descriptions =
-                    (SDL_GPUColorTargetDescription[]) {
-                        {.format = swapchain_format}
-                    },
+                .color_target_descriptions = &color_target,
                 .has_depth_stencil_target = true,
                 .depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D24_UNORM,
             },
         .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
-        .vertex_shader = mat->vertex_shader,
-        .fragment_shader = mat->fragment_shader,
+        .vertex_shader = vertex_shader,
+        .fragment_shader = fragment_shader,
 
         .vertex_input_state =
             {
-                .vertex_buffer_descriptions =
-                    (SDL_GPUVertexBufferDescription[]) {
-                        {.slot = 0,
-                         .pitch = 8 * sizeof (float),
-                         .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
-                         .instance_step_rate = 0}
-                    },
-                .num_vertex_buffers = 1,
-                .num_vertex_attributes = 3,
-                .vertex_attributes =
-                    (SDL_GPUVertexAttribute[]) {
-                        {// pos
-                         .location = 0,
-                         .buffer_slot = 0,
-                         .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-                         .offset = 0
-                        },
-                        {// normals
-                         .location = 1,
-                         .buffer_slot = 0,
-                         .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3,
-                         .offset = 3 * sizeof (float)
-                        },
-                        {// texcoord
-                         .location = 2,
-                         .buffer_slot = 0,
-                         .format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2,
-                         .offset = 6 * sizeof (float)
-                        },
-                    },
+                .vertex_buffer_descriptions = buffers,
+                .num_vertex_buffers = num_buffers,
+                .num_vertex_attributes =
+                    VERTEX_ATTRIBUTE_COUNT + OBJECT_ATTRIBUTE_COUNT,
+                .vertex_attributes = attributes,
             },
         .rasterizer_state =
             {.fill_mode = SDL_GPU_FILLMODE_FILL,
-             .cull_mode = cullmode,
+             .cull_mode = cull_mode,
              .front_face = SDL_GPU_FRONTFACE_CLOCKWISE},
         .depth_stencil_state = {
             .enable_depth_test = true,
-            .enable_depth_write = true,
-            .compare_op = SDL_GPU_COMPAREOP_LESS,
+            // after a pre-pass the depth is final; only the surface that
+            // laid it down passes. Blended surfaces hide nothing
+            .enable_depth_write = depth_mode == MESH_DEPTH_LESS ||
+                                  depth_mode == MESH_DEPTH_ONLY,
+            .compare_op = depth_mode == MESH_DEPTH_EQUAL
+                              ? SDL_GPU_COMPAREOP_EQUAL
+                              : SDL_GPU_COMPAREOP_LESS,
             .enable_stencil_test = false
         }
     };
-    mat->pipeline = SDL_CreateGPUGraphicsPipeline (device, &pipe_info);
-    if (!mat->pipeline) {
-        SDL_Log ("Failed to create material pipeline: %s", SDL_GetError ());
+    SDL_GPUGraphicsPipeline* pipeline =
+        SDL_CreateGPUGraphicsPipeline (device, &pipe_info);
+    if (!pipeline)
+        SDL_Log ("Failed to create mesh pipeline: %s", SDL_GetError ());
+    return pipeline;
+}
+
+// returns 0 on success 1 on failure
+// materials with the same shaders, side and blending get the same cached
+// pipelines, so their draws batch together
+static int build_pipeline (
+    SDL_GPUDevice* device,
+    MaterialComponent* mat,
+    SDL_GPUTextureFormat swapchain_format,
+    VertexLayout layout
+) {
+    PROFILE_ZONE ("build_pipeline");
+    SDL_GPUGraphicsPipeline** pipeline = &mat->pipeline;
+    SDL_GPUGraphicsPipeline** equal_pipeline = &mat->equal_pipeline;
+    if (layout == VERTEX_LAYOUT_COMPACT) {
+        pipeline = &mat->compact_pipeline;
+        equal_pipeline = &mat->equal_compact_pipeline;
+    } else if (layout == VERTEX_LAYOUT_SEPARATE) {
+        pipeline = &mat->separate_pipeline;
+        equal_pipeline = &mat->equal_separate_pipeline;
+    }
+    release_pipeline (device, pipeline);
+    release_pipeline (device, equal_pipeline);
+
+    // compact meshes are decoded by the *_compact.vert shaders
+    SDL_GPUShader* vertex_shader = layout == VERTEX_LAYOUT_COMPACT
+                                       ? mat->compact_vertex_shader
+                                       : mat->vertex_shader;
+    SDL_GPUCullMode cull_mode = side_cull_mode (mat->side);
+    *pipeline = pipeline_cache_pipeline (
+        device, vertex_shader, mat->fragment_shader, swapchain_format, layout,
+        cull_mode, mat->blended ? MESH_DEPTH_BLENDED : MESH_DEPTH_LESS
+    );
+    if (!*pipeline) return 1; // logging handled in pipeline_cache_pipeline()
+    // without it the material just sits out the depth pre-pass; logging
+    // handled in pipeline_cache_pipeline()
+    if (!mat->blended) {
+        *equal_pipeline = pipeline_cache_pipeline (
+            device, vertex_shader, mat->fragment_shader, swapchain_format,
+            layout, cull_mode, MESH_DEPTH_EQUAL
+        );
+    }
+    return 0;
+}
+
+int set_material_blended (
+    gpu_renderer* renderer,
+    MaterialComponent* mat,
+    bool blended
+) {
+    render_pipeline_invalidate (); // the frame built ahead may use these
+    mat->blended = blended;
+    release_pipeline (renderer->device, &mat->pipeline);
+    release_pipeline (renderer->device, &mat->compact_pipeline);
+    release_pipeline (renderer->device, &mat->separate_pipeline);
+    release_pipeline (renderer->device, &mat->equal_pipeline);
+    release_pipeline (renderer->device, &mat->equal_compact_pipeline);
+    release_pipeline (renderer->device, &mat->equal_separate_pipeline);
+    if (!mat->fragment_shader) return 0; // built once the shaders are set
+
+    if (mat->vertex_shader) {
+        int pipe_failed = build_pipeline (
+            renderer->device, mat, renderer->format, VERTEX_LAYOUT_STANDARD
+        );
+        if (pipe_failed) return 1; // logging handled in build_pipeline()
+        build_pipeline (
+            renderer->device, mat, renderer->format, VERTEX_LAYOUT_SEPARATE
+        );
+    }
+    if (mat->compact_vertex_shader) {
+        build_pipeline (
+            renderer->device, mat, renderer->format, VERTEX_LAYOUT_COMPACT
+        );
+    }
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+int share_material (
+    const MaterialComponent* mat,
+    vec3 color,
+    MaterialComponent* out
+) {
+    if (mat->texture_array) {
+        SDL_Log ("Textured materials own their layer and cannot be shared");
         return 1;
     }
+    *out = *mat;
+    out->color = color;
+    SDL_GPUShader* shaders[] = {
+        out->vertex_shader, out->compact_vertex_shader, out->fragment_shader
+    };
+    for (Uint32 i = 0; i < SDL_arraysize (shaders); i++)
+        if (shaders[i]) pipeline_cache_retain_shader (shaders[i]);
+    SDL_GPUGraphicsPipeline* pipelines[] = {
+        out->pipeline, out->compact_pipeline, out->separate_pipeline,
+        out->equal_pipeline, out->equal_compact_pipeline,
+        out->equal_separate_pipeline
+    };
+    for (Uint32 i = 0; i < SDL_arraysize (pipelines); i++)
+        if (pipelines[i]) pipeline_cache_retain_pipeline (pipelines[i]);
     return 0;
-}
\ No newline at end of file
+}
+
+void release_material (SDL_GPUDevice* device, MaterialComponent* mat) {
+    if (mat->texture_array)
+        remove_texture_layer (device, mat->texture_array, mat->texture_layer);
+    mat->texture_array = NULL;
+    release_pipeline (device, &mat->pipeline);
+    release_pipeline (device, &mat->compact_pipeline);
+    release_pipeline (device, &mat->separate_pipeline);
+    release_pipeline (device, &mat->equal_pipeline);
+    release_pipeline (device, &mat->equal_compact_pipeline);
+    release_pipeline (device, &mat->equal_separate_pipeline);
+    release_shader (device, &mat->vertex_shader);
+    release_shader (device, &mat->compact_vertex_shader);
+    release_shader (device, &mat->fragment_shader);
+}
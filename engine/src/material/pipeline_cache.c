@@ -0,0 +1,220 @@
+#include <stdlib.h>
+
+#include <material/pipeline_cache.h>
+
+typedef struct {
+    char* filename;
+    SDL_GPUShaderStage stage;
+    Uint32 counts[4]; // samplers, uniform, storage buffers, storage textures
+    SDL_GPUShader* shader;
+    Uint32 refs;
+} CachedShader;
+
+typedef struct {
+    SDL_GPUShader* vertex_shader;
+    SDL_GPUShader* fragment_shader;
+    SDL_GPUTextureFormat target_format;
+    VertexLayout layout;
+    SDL_GPUCullMode cull_mode;
+    MeshDepthMode depth_mode;
+    SDL_GPUGraphicsPipeline* pipeline;
+    Uint32 refs;
+} CachedPipeline;
+
+// few enough distinct entries that a linear search is the cheap part
+static CachedShader* shaders = NULL;
+static Uint32 shader_count = 0;
+static Uint32 shader_capacity = 0;
+static CachedPipeline* pipelines = NULL;
+static Uint32 pipeline_count = 0;
+static Uint32 pipeline_capacity = 0;
+
+// Returns 0 on success, 1 on failure
+// room for one more entry of size bytes in *entries
+static int grow (void** entries, Uint32 count, Uint32* capacity, size_t size) {
+    if (count < *capacity) return 0;
+    Uint32 grown_capacity = *capacity ? *capacity * 2 : 16;
+    void* grown = realloc (*entries, grown_capacity * size);
+    if (!grown) {
+        SDL_Log ("Failed to grow the pipeline cache");
+        return 1;
+    }
+    *entries = grown;
+    *capacity = grown_capacity;
+    return 0;
+}
+
+static CachedShader* find_shader (const SDL_GPUShader* shader) {
+    for (Uint32 i = 0; i < shader_count; i++)
+        if (shaders[i].shader == shader) return &shaders[i];
+    return NULL;
+}
+
+static CachedPipeline*
+find_pipeline (const SDL_GPUGraphicsPipeline* pipeline) {
+    for (Uint32 i = 0; i < pipeline_count; i++)
+        if (pipelines[i].pipeline == pipeline) return &pipelines[i];
+    return NULL;
+}
+
+// Returns NULL on failure
+SDL_GPUShader* pipeline_cache_shader (
+    SDL_GPUDevice* device,
+    const char* filename,
+    SDL_GPUShaderStage stage,
+    Uint32 sampler_count,
+    Uint32 uniform_buffer_count,
+    Uint32 storage_buffer_count,
+    Uint32 storage_texture_count
+) {
+    Uint32 counts[4] = {
+        sampler_count, uniform_buffer_count, storage_buffer_count,
+        storage_texture_count
+    };
+    for (Uint32 i = 0; i < shader_count; i++) {
+        CachedShader* entry = &shaders[i];
+        if (entry->stage == stage &&
+            !SDL_memcmp (entry->counts, counts, sizeof (counts)) &&
+            !SDL_strcmp (entry->filename, filename)) {
+            entry->refs++;
+            return entry->shader;
+        }
+    }
+
+    if (grow (
+            (void**) &shaders, shader_count, &shader_capacity,
+            sizeof (CachedShader)
+        ))
+        return NULL; // logging handled in grow()
+    char* name = SDL_strdup (filename);
+    if (!name) {
+        SDL_Log ("Failed to allocate shader cache entry");
+        return NULL;
+    }
+    SDL_GPUShader* shader = load_shader (
+        device, filename, stage, sampler_count, uniform_buffer_count,
+        storage_buffer_count, storage_texture_count
+    );
+    if (!shader) {
+        SDL_free (name);
+        return NULL; // logging handled in load_shader()
+    }
+    CachedShader* entry = &shaders[shader_count++];
+    *entry = (CachedShader) {
+        .filename = name, .stage = stage, .shader = shader, .refs = 1
+    };
+    SDL_memcpy (entry->counts, counts, sizeof (counts));
+    return shader;
+}
+
+void pipeline_cache_retain_shader (SDL_GPUShader* shader) {
+    CachedShader* entry = find_shader (shader);
+    if (!entry) {
+        SDL_Log ("Shader is not in the pipeline cache");
+        return;
+    }
+    entry->refs++;
+}
+
+void pipeline_cache_release_shader (
+    SDL_GPUDevice* device,
+    SDL_GPUShader* shader
+) {
+    CachedShader* entry = find_shader (shader);
+    if (!entry) {
+        SDL_Log ("Shader is not in the pipeline cache");
+        return;
+    }
+    if (--entry->refs > 0) return;
+    SDL_ReleaseGPUShader (device, entry->shader);
+    SDL_free (entry->filename);
+    *entry = shaders[--shader_count];
+    if (shader_count == 0) {
+        free (shaders);
+        shaders = NULL;
+        shader_capacity = 0;
+    }
+}
+
+// Returns NULL on failure
+SDL_GPUGraphicsPipeline* pipeline_cache_pipeline (
+    SDL_GPUDevice* device,
+    SDL_GPUShader* vertex_shader,
+    SDL_GPUShader* fragment_shader,
+    SDL_GPUTextureFormat target_format,
+    VertexLayout layout,
+    SDL_GPUCullMode cull_mode,
+    MeshDepthMode depth_mode
+) {
+    for (Uint32 i = 0; i < pipeline_count; i++) {
+        CachedPipeline* entry = &pipelines[i];
+        if (entry->vertex_shader == vertex_shader &&
+            entry->fragment_shader == fragment_shader &&
+            entry->target_format == target_format &&
+            entry->layout == layout && entry->cull_mode == cull_mode &&
+            entry->depth_mode == depth_mode) {
+            entry->refs++;
+            return entry->pipeline;
+        }
+    }
+
+    if (grow (
+            (void**) &pipelines, pipeline_count, &pipeline_capacity,
+            sizeof (CachedPipeline)
+        ))
+        return NULL; // logging handled in grow()
+    SDL_GPUGraphicsPipeline* pipeline = create_mesh_pipeline (
+        device, vertex_shader, fragment_shader, target_format, layout,
+        cull_mode, depth_mode
+    );
+    if (!pipeline) return NULL; // logging handled in create_mesh_pipeline()
+    pipeline_cache_retain_shader (vertex_shader);
+    pipeline_cache_retain_shader (fragment_shader);
+    pipelines[pipeline_count++] = (CachedPipeline) {
+        .vertex_shader = vertex_shader,
+        .fragment_shader = fragment_shader,
+        .target_format = target_format,
+        .layout = layout,
+        .cull_mode = cull_mode,
+        .depth_mode = depth_mode,
+        .pipeline = pipeline,
+        .refs = 1
+    };
+    return pipeline;
+}
+
+void pipeline_cache_retain_pipeline (SDL_GPUGraphicsPipeline* pipeline) {
+    CachedPipeline* entry = find_pipeline (pipeline);
+    if (!entry) {
+        SDL_Log ("Pipeline is not in the pipeline cache");
+        return;
+    }
+    entry->refs++;
+}
+
+void pipeline_cache_release_pipeline (
+    SDL_GPUDevice* device,
+    SDL_GPUGraphicsPipeline* pipeline
+) {
+    CachedPipeline* entry = find_pipeline (pipeline);
+    if (!entry) {
+        SDL_Log ("Pipeline is not in the pipeline cache");
+        return;
+    }
+    if (--entry->refs > 0) return;
+    SDL_ReleaseGPUGraphicsPipeline (device, entry->pipeline);
+    SDL_GPUShader* vertex_shader = entry->vertex_shader;
+    SDL_GPUShader* fragment_shader = entry->fragment_shader;
+    *entry = pipelines[--pipeline_count];
+    if (pipeline_count == 0) {
+        free (pipelines);
+        pipelines = NULL;
+        pipeline_capacity = 0;
+    }
+    pipeline_cache_release_shader (device, vertex_shader);
+    pipeline_cache_release_shader (device, fragment_shader);
+}
+
+Uint32 pipeline_cache_pipeline_count (void) {
+    return pipeline_count;
+}
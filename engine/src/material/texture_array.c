@@ -0,0 +1,233 @@
+#include <stdlib.h>
+
+#include <material/m_common.h>
+#include <material/texture_array.h>
+#include <profiler/profiler.h>
+
+static TextureArray** arrays = NULL;
+static Uint32 array_count = 0;
+static Uint32 array_capacity = 0;
+
+static Uint32 level_extent (Uint32 size, Uint32 level) {
+    return SDL_max (size >> level, 1u);
+}
+
+static bool array_matches (
+    const TextureArray* array,
+    const SDL_GPUTextureCreateInfo* info
+) {
+    return array->format == info->format && array->width == info->width &&
+           array->height == info->height &&
+           array->num_levels == info->num_levels &&
+           array->live < TEXTURE_ARRAY_MAX_LAYERS;
+}
+
+// Returns NULL on failure
+static SDL_GPUTexture* create_array_texture (
+    SDL_GPUDevice* device,
+    const TextureArray* array,
+    Uint32 capacity
+) {
+    SDL_GPUTextureCreateInfo tex_info = {
+        .type = SDL_GPU_TEXTURETYPE_2D_ARRAY,
+        .format = array->format,
+        .width = array->width,
+        .height = array->height,
+        .layer_count_or_depth = capacity,
+        .num_levels = array->num_levels,
+        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER
+    };
+    SDL_GPUTexture* texture = SDL_CreateGPUTexture (device, &tex_info);
+    if (!texture)
+        SDL_Log ("Failed to create texture array: %s", SDL_GetError ());
+    return texture;
+}
+
+// every level of one layer; a non-array source is layer 0
+static void copy_layer (
+    SDL_GPUCopyPass* copy_pass,
+    const TextureArray* array,
+    SDL_GPUTexture* src,
+    Uint32 src_layer,
+    SDL_GPUTexture* dst,
+    Uint32 dst_layer
+) {
+    for (Uint32 level = 0; level < array->num_levels; level++) {
+        SDL_GPUTextureLocation from = {
+            .texture = src, .mip_level = level, .layer = src_layer
+        };
+        SDL_GPUTextureLocation to = {
+            .texture = dst, .mip_level = level, .layer = dst_layer
+        };
+        SDL_CopyGPUTextureToTexture (
+            copy_pass, &from, &to, level_extent (array->width, level),
+            level_extent (array->height, level), 1, false
+        );
+    }
+}
+
+// Returns NULL on failure
+static TextureArray*
+create_array (SDL_GPUDevice* device, const SDL_GPUTextureCreateInfo* info) {
+    if (array_count == array_capacity) {
+        Uint32 capacity = array_capacity ? array_capacity * 2 : 8;
+        TextureArray** grown = (TextureArray**) realloc (
+            arrays, capacity * sizeof (TextureArray*)
+        );
+        if (!grown) {
+            SDL_Log ("Failed to grow texture array list");
+            return NULL;
+        }
+        arrays = grown;
+        array_capacity = capacity;
+    }
+
+    TextureArray* array = (TextureArray*) calloc (1, sizeof (TextureArray));
+    bool* used = (bool*) calloc (TEXTURE_ARRAY_MIN_LAYERS, sizeof (bool));
+    if (!array || !used) {
+        SDL_Log ("Failed to allocate texture array");
+        free (array);
+        free (used);
+        return NULL;
+    }
+    array->format = info->format;
+    array->width = info->width;
+    array->height = info->height;
+    array->num_levels = info->num_levels;
+    array->capacity = TEXTURE_ARRAY_MIN_LAYERS;
+    array->used = used;
+    array->texture =
+        create_array_texture (device, array, TEXTURE_ARRAY_MIN_LAYERS);
+    if (!array->texture) {
+        free (used);
+        free (array);
+        return NULL; // logging handled in create_array_texture()
+    }
+    arrays[array_count++] = array;
+    return array;
+}
+
+// Returns 0 on success, 1 on failure
+// doubles the layer count; the used layers are copied across in copy_pass
+static int grow_array (
+    SDL_GPUDevice* device,
+    SDL_GPUCopyPass* copy_pass,
+    TextureArray* array
+) {
+    Uint32 capacity =
+        SDL_min (array->capacity * 2, (Uint32) TEXTURE_ARRAY_MAX_LAYERS);
+    bool* used = (bool*) realloc (array->used, capacity * sizeof (bool));
+    if (!used) {
+        SDL_Log ("Failed to grow texture array");
+        return 1;
+    }
+    memset (used + array->capacity, 0, (capacity - array->capacity));
+    array->used = used;
+
+    SDL_GPUTexture* texture = create_array_texture (device, array, capacity);
+    if (!texture) return 1; // logging handled in create_array_texture()
+    for (Uint32 i = 0; i < array->capacity; i++)
+        if (array->used[i])
+            copy_layer (copy_pass, array, array->texture, i, texture, i);
+
+    // released once the copies above have executed, and never drawn from
+    // by the frame built ahead
+    render_pipeline_invalidate ();
+    SDL_ReleaseGPUTexture (device, array->texture);
+    array->texture = texture;
+    array->capacity = capacity;
+    return 0;
+}
+
+int add_texture_layer (
+    SDL_GPUDevice* device,
+    SDL_GPUTexture* texture,
+    const SDL_GPUTextureCreateInfo* info,
+    MaterialComponent* mat
+) {
+    PROFILE_ZONE ("add_texture_layer");
+    if (info->type != SDL_GPU_TEXTURETYPE_2D ||
+        info->layer_count_or_depth != 1) {
+        SDL_Log ("Only single 2D textures can be added to texture arrays");
+        SDL_ReleaseGPUTexture (device, texture);
+        return 1;
+    }
+
+    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (device);
+    if (!cmd) {
+        SDL_Log ("Failed to acquire command buffer: %s", SDL_GetError ());
+        SDL_ReleaseGPUTexture (device, texture);
+        return 1;
+    }
+    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass (cmd);
+    if (!copy_pass) {
+        SDL_Log ("Failed to begin copy pass: %s", SDL_GetError ());
+        SDL_SubmitGPUCommandBuffer (cmd);
+        SDL_ReleaseGPUTexture (device, texture);
+        return 1;
+    }
+
+    TextureArray* array = NULL;
+    for (Uint32 i = 0; i < array_count && !array; i++)
+        if (array_matches (arrays[i], info)) array = arrays[i];
+    if (!array) array = create_array (device, info);
+    if (!array || (array->live == array->capacity &&
+                   grow_array (device, copy_pass, array))) {
+        SDL_EndGPUCopyPass (copy_pass);
+        SDL_SubmitGPUCommandBuffer (cmd);
+        SDL_ReleaseGPUTexture (device, texture);
+        return 1; // logging handled in create_array() or grow_array()
+    }
+    Uint32 layer = 0;
+    while (array->used[layer]) layer++;
+    copy_layer (copy_pass, array, texture, 0, array->texture, layer);
+    SDL_EndGPUCopyPass (copy_pass);
+    SDL_SubmitGPUCommandBuffer (cmd);
+    SDL_ReleaseGPUTexture (device, texture);
+
+    array->used[layer] = true;
+    array->live++;
+    if (mat->texture_array)
+        remove_texture_layer (device, mat->texture_array, mat->texture_layer);
+    mat->texture_array = array;
+    mat->texture_layer = layer;
+    return 0;
+}
+
+void remove_texture_layer (
+    SDL_GPUDevice* device,
+    TextureArray* array,
+    Uint32 layer
+) {
+    if (array->used[layer]) {
+        array->used[layer] = false;
+        array->live--;
+    }
+    if (array->live > 0) return;
+
+    render_pipeline_invalidate (); // the frame built ahead may sample it
+    for (Uint32 i = 0; i < array_count; i++) {
+        if (arrays[i] != array) continue;
+        arrays[i] = arrays[--array_count];
+        break;
+    }
+    SDL_ReleaseGPUTexture (device, array->texture);
+    free (array->used);
+    free (array);
+    if (array_count == 0) {
+        free (arrays);
+        arrays = NULL;
+        array_capacity = 0;
+    }
+}
+
+int load_material_texture (
+    SDL_GPUDevice* device,
+    MaterialComponent* mat,
+    const char* path
+) {
+    SDL_GPUTextureCreateInfo info;
+    SDL_GPUTexture* texture = load_texture_with_info (device, path, &info);
+    if (!texture) return 1; // logging handled in load_texture()
+    return add_texture_layer (device, texture, &info, mat);
+}
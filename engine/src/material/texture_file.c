@@ -0,0 +1,421 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_gpu.h>
+
+#include <jobs/jobs.h>
+#include <material/bc_encode.h>
+#include <material/texture_file.h>
+#include <profiler/profiler.h>
+
+#define ATEX_ALIGN_UP(x) (((x) + ATEX_ALIGN - 1) & ~(Uint64) (ATEX_ALIGN - 1))
+#define ENCODE_MIN_BATCH 4 // block rows per job batch
+
+static const SDL_GPUTextureFormat gpu_formats[TEXTURE_FILE_FORMAT_COUNT] = {
+    SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+    SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM,
+    SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM,
+    SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM,
+};
+
+static Uint32 level_extent (Uint32 size, Uint32 level) {
+    return SDL_max (size >> level, 1u);
+}
+
+Uint64 texture_level_size (
+    TextureFileFormat format,
+    Uint32 width,
+    Uint32 height
+) {
+    if (format == TEXTURE_FILE_RGBA8) return (Uint64) width * height * 4;
+    Uint64 blocks = (Uint64) ((width + 3) / 4) * ((height + 3) / 4);
+    return blocks * (format == TEXTURE_FILE_BC1 ? 8 : 16);
+}
+
+bool is_texture_file (const MappedFile* file) {
+    Uint32 magic;
+    if (file->size < sizeof (ATexHeader)) return false;
+    memcpy (&magic, file->data, sizeof (magic));
+    return magic == ATEX_MAGIC;
+}
+
+bool is_texture_file_path (const char* path) {
+    SDL_IOStream* io = SDL_IOFromFile (path, "rb");
+    if (!io) return false;
+    Uint32 magic = 0;
+    bool read = SDL_ReadIO (io, &magic, sizeof (magic)) == sizeof (magic);
+    SDL_CloseIO (io);
+    return read && magic == ATEX_MAGIC;
+}
+
+// ---- loading ----
+
+// Returns 0 if the header and level table describe a complete texture
+static int check_texture_file (const MappedFile* file) {
+    const ATexHeader* header = (const ATexHeader*) file->data;
+    if (header->version != ATEX_VERSION) return 1;
+    if (header->format >= TEXTURE_FILE_FORMAT_COUNT) return 1;
+    if (header->width == 0 || header->height == 0) return 1;
+    if (header->level_count == 0 || header->level_count > ATEX_MAX_LEVELS)
+        return 1;
+    Uint32 largest = SDL_max (header->width, header->height);
+    if (header->level_count > 1 && largest >> (header->level_count - 1) == 0)
+        return 1; // more levels than the chain has
+
+    Uint64 levels_end = sizeof (ATexHeader) +
+                        (Uint64) header->level_count * sizeof (ATexLevel);
+    if (levels_end > file->size) return 1;
+
+    const ATexLevel* levels =
+        (const ATexLevel*) (file->data + sizeof (ATexHeader));
+    for (Uint32 i = 0; i < header->level_count; i++) {
+        Uint64 expected = texture_level_size (
+            (TextureFileFormat) header->format,
+            level_extent (header->width, i), level_extent (header->height, i)
+        );
+        if (levels[i].size != expected || levels[i].offset % ATEX_ALIGN ||
+            levels[i].offset < levels_end || levels[i].offset > file->size ||
+            levels[i].size > file->size - levels[i].offset)
+            return 1;
+    }
+    return 0;
+}
+
+// Returns NULL on failure
+SDL_GPUTexture* upload_texture_file (
+    SDL_GPUDevice* device,
+    const MappedFile* file,
+    const char* name,
+    SDL_GPUTextureCreateInfo* info
+) {
+#if SDL_BYTEORDER != SDL_LIL_ENDIAN
+    (void) device;
+    (void) file;
+    (void) info;
+    SDL_Log ("Texture files are little-endian only: %s", name);
+    return NULL;
+#else
+    PROFILE_ZONE ("upload_texture_file");
+    if (!is_texture_file (file) || check_texture_file (file)) {
+        SDL_Log ("Invalid texture file %s", name);
+        return NULL;
+    }
+    const ATexHeader* header = (const ATexHeader*) file->data;
+    const ATexLevel* levels =
+        (const ATexLevel*) (file->data + sizeof (ATexHeader));
+
+    SDL_GPUTextureFormat format = gpu_formats[header->format];
+    if (!SDL_GPUTextureSupportsFormat (
+            device, format, SDL_GPU_TEXTURETYPE_2D,
+            SDL_GPU_TEXTUREUSAGE_SAMPLER
+        )) {
+        SDL_Log ("The GPU cannot sample the format of %s", name);
+        return NULL;
+    }
+
+    // the levels sit back to back after the level table
+    Uint64 start = UINT64_MAX;
+    Uint64 end = 0;
+    for (Uint32 i = 0; i < header->level_count; i++) {
+        start = SDL_min (start, levels[i].offset);
+        end = SDL_max (end, levels[i].offset + levels[i].size);
+    }
+    if (end - start > SDL_MAX_UINT32) {
+        SDL_Log ("Texture file %s is too large", name);
+        return NULL;
+    }
+
+    SDL_GPUTextureCreateInfo tex_info = {
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = format,
+        .width = header->width,
+        .height = header->height,
+        .layer_count_or_depth = 1,
+        .num_levels = header->level_count,
+        .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER
+    };
+    SDL_GPUTexture* texture = SDL_CreateGPUTexture (device, &tex_info);
+    if (!texture) {
+        SDL_Log ("Failed to create texture: %s", SDL_GetError ());
+        return NULL;
+    }
+    if (info) *info = tex_info;
+
+    SDL_GPUTransferBufferCreateInfo trans_info = {
+        .size = (Uint32) (end - start),
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
+    };
+    SDL_GPUTransferBuffer* trans_buf =
+        SDL_CreateGPUTransferBuffer (device, &trans_info);
+    if (!trans_buf) {
+        SDL_Log ("Failed to create transfer buffer: %s", SDL_GetError ());
+        SDL_ReleaseGPUTexture (device, texture);
+        return NULL;
+    }
+
+    void* data = SDL_MapGPUTransferBuffer (device, trans_buf, false);
+    if (!data) {
+        SDL_Log ("Failed to map transfer buffer: %s", SDL_GetError ());
+        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+        SDL_ReleaseGPUTexture (device, texture);
+        return NULL;
+    }
+    memcpy (data, file->data + start, (size_t) (end - start));
+    SDL_UnmapGPUTransferBuffer (device, trans_buf);
+
+    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (device);
+    if (!cmd) {
+        SDL_Log ("Failed to acquire command buffer: %s", SDL_GetError ());
+        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+        SDL_ReleaseGPUTexture (device, texture);
+        return NULL;
+    }
+
+    SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass (cmd);
+    if (!copy_pass) {
+        SDL_Log ("Failed to begin copy pass: %s", SDL_GetError ());
+        SDL_SubmitGPUCommandBuffer (cmd);
+        SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+        SDL_ReleaseGPUTexture (device, texture);
+        return NULL;
+    }
+
+    for (Uint32 i = 0; i < header->level_count; i++) {
+        // zero pitches mean tightly packed rows of texels or blocks
+        SDL_GPUTextureTransferInfo src_info = {
+            .transfer_buffer = trans_buf,
+            .offset = (Uint32) (levels[i].offset - start),
+        };
+        SDL_GPUTextureRegion dst_region = {
+            .texture = texture,
+            .mip_level = i,
+            .w = level_extent (header->width, i),
+            .h = level_extent (header->height, i),
+            .d = 1,
+        };
+        SDL_UploadToGPUTexture (copy_pass, &src_info, &dst_region, false);
+    }
+    SDL_EndGPUCopyPass (copy_pass);
+    SDL_SubmitGPUCommandBuffer (cmd);
+
+    SDL_ReleaseGPUTransferBuffer (device, trans_buf);
+    return texture;
+#endif
+}
+
+// ---- writing ----
+
+typedef struct {
+    TextureFileFormat format;
+    const Uint8* rgba;
+    Uint32 width;
+    Uint32 height;
+    Uint8* out;
+} EncodeJob;
+
+// encodes block rows [start, end); edge blocks repeat the last row and column
+static void encode_rows_job (void* data, Uint32 start, Uint32 end) {
+    const EncodeJob* job = (const EncodeJob*) data;
+    Uint32 blocks_x = (job->width + 3) / 4;
+    Uint32 block_size = job->format == TEXTURE_FILE_BC1 ? 8 : 16;
+    Uint8 block[BC_BLOCK_TEXELS * 4];
+
+    for (Uint32 by = start; by < end; by++) {
+        for (Uint32 bx = 0; bx < blocks_x; bx++) {
+            for (Uint32 y = 0; y < 4; y++) {
+                Uint32 sy = SDL_min (by * 4 + y, job->height - 1);
+                for (Uint32 x = 0; x < 4; x++) {
+                    Uint32 sx = SDL_min (bx * 4 + x, job->width - 1);
+                    memcpy (
+                        &block[(y * 4 + x) * 4],
+                        &job->rgba[((size_t) sy * job->width + sx) * 4], 4
+                    );
+                }
+            }
+
+            Uint8* out =
+                job->out + ((size_t) by * blocks_x + bx) * block_size;
+            if (job->format == TEXTURE_FILE_BC1)
+                encode_bc1_block (block, out);
+            else if (job->format == TEXTURE_FILE_BC3)
+                encode_bc3_block (block, out);
+            else
+                encode_bc7_block (block, out);
+        }
+    }
+}
+
+// Returns NULL on failure
+// 2x2 box filter; odd edges repeat their last texel
+static Uint8* downsample (const Uint8* rgba, Uint32 width, Uint32 height) {
+    Uint32 out_w = level_extent (width, 1);
+    Uint32 out_h = level_extent (height, 1);
+    Uint8* out = (Uint8*) malloc ((size_t) out_w * out_h * 4);
+    if (!out) return NULL;
+
+    for (Uint32 y = 0; y < out_h; y++) {
+        Uint32 y0 = SDL_min (y * 2, height - 1);
+        Uint32 y1 = SDL_min (y * 2 + 1, height - 1);
+        for (Uint32 x = 0; x < out_w; x++) {
+            Uint32 x0 = SDL_min (x * 2, width - 1);
+            Uint32 x1 = SDL_min (x * 2 + 1, width - 1);
+            for (int c = 0; c < 4; c++) {
+                Uint32 sum = rgba[((size_t) y0 * width + x0) * 4 + c] +
+                             rgba[((size_t) y0 * width + x1) * 4 + c] +
+                             rgba[((size_t) y1 * width + x0) * 4 + c] +
+                             rgba[((size_t) y1 * width + x1) * 4 + c];
+                out[((size_t) y * out_w + x) * 4 + c] = (Uint8) ((sum + 2) / 4);
+            }
+        }
+    }
+    return out;
+}
+
+// Returns 0 on success, 1 on failure
+static int write_padded (SDL_IOStream* io, const void* data, Uint64 size) {
+    static const Uint8 zeros[ATEX_ALIGN] = {0};
+    if (SDL_WriteIO (io, data, (size_t) size) != size) return 1;
+    Uint64 padding = ATEX_ALIGN_UP (size) - size;
+    if (padding && SDL_WriteIO (io, zeros, (size_t) padding) != padding)
+        return 1;
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+static int write_levels (
+    const char* path,
+    const ATexHeader* header,
+    Uint8* const* blobs
+) {
+    ATexLevel levels[ATEX_MAX_LEVELS];
+    Uint64 offset = ATEX_ALIGN_UP (
+        sizeof (ATexHeader) + (Uint64) header->level_count * sizeof (ATexLevel)
+    );
+    for (Uint32 i = 0; i < header->level_count; i++) {
+        levels[i].offset = offset;
+        levels[i].size = texture_level_size (
+            (TextureFileFormat) header->format,
+            level_extent (header->width, i), level_extent (header->height, i)
+        );
+        offset += ATEX_ALIGN_UP (levels[i].size);
+    }
+
+    // written beside the target and renamed so readers never see half a file
+    char temp_path[1024];
+    if (SDL_snprintf (temp_path, sizeof (temp_path), "%s.tmp", path) >=
+        (int) sizeof (temp_path)) {
+        SDL_Log ("Texture file path is too long: %s", path);
+        return 1;
+    }
+    SDL_IOStream* io = SDL_IOFromFile (temp_path, "wb");
+    if (!io) {
+        SDL_Log ("Failed to open %s: %s", temp_path, SDL_GetError ());
+        return 1;
+    }
+
+    int failed = SDL_WriteIO (io, header, sizeof (*header)) != sizeof (*header);
+    if (!failed)
+        failed = write_padded (
+            io, levels, (Uint64) header->level_count * sizeof (ATexLevel)
+        );
+    for (Uint32 i = 0; i < header->level_count && !failed; i++)
+        failed = write_padded (io, blobs[i], levels[i].size);
+
+    if (!SDL_CloseIO (io)) failed = 1;
+    if (!failed && !SDL_RenamePath (temp_path, path)) failed = 1;
+    if (failed) {
+        SDL_Log ("Failed to write %s: %s", path, SDL_GetError ());
+        SDL_RemovePath (temp_path);
+        return 1;
+    }
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+int write_texture_file (
+    const char* path,
+    TextureFileFormat format,
+    const Uint8* rgba,
+    Uint32 width,
+    Uint32 height,
+    bool mips
+) {
+#if SDL_BYTEORDER != SDL_LIL_ENDIAN
+    (void) format;
+    (void) rgba;
+    (void) width;
+    (void) height;
+    (void) mips;
+    SDL_Log ("Texture files are little-endian only: %s", path);
+    return 1;
+#else
+    PROFILE_ZONE ("write_texture_file");
+    if (format >= TEXTURE_FILE_FORMAT_COUNT || width == 0 || height == 0) {
+        SDL_Log ("Invalid texture for %s", path);
+        return 1;
+    }
+
+    ATexHeader header = {
+        .magic = ATEX_MAGIC,
+        .version = ATEX_VERSION,
+        .format = (Uint32) format,
+        .width = width,
+        .height = height,
+        .level_count = 1
+    };
+    if (mips) {
+        Uint32 largest = SDL_max (width, height);
+        while (largest >> header.level_count &&
+               header.level_count < ATEX_MAX_LEVELS)
+            header.level_count++;
+    }
+
+    Uint8* blobs[ATEX_MAX_LEVELS] = {0};
+    const Uint8* level = rgba;
+    Uint8* owned = NULL; // the current level once it is a downsampled copy
+    int failed = 0;
+    for (Uint32 i = 0; i < header.level_count && !failed; i++) {
+        Uint32 w = level_extent (width, i);
+        Uint32 h = level_extent (height, i);
+        if (i > 0) {
+            Uint8* next = downsample (
+                level, level_extent (width, i - 1),
+                level_extent (height, i - 1)
+            );
+            free (owned);
+            owned = next;
+            level = next;
+            if (!next) {
+                SDL_Log ("Failed to allocate mip level for %s", path);
+                failed = 1;
+                break;
+            }
+        }
+
+        blobs[i] = (Uint8*) malloc (texture_level_size (format, w, h));
+        if (!blobs[i]) {
+            SDL_Log ("Failed to allocate encoded level for %s", path);
+            failed = 1;
+            break;
+        }
+        if (format == TEXTURE_FILE_RGBA8) {
+            memcpy (blobs[i], level, (size_t) w * h * 4);
+            continue;
+        }
+        EncodeJob job = {
+            .format = format, .rgba = level, .width = w, .height = h,
+            .out = blobs[i]
+        };
+        jobs_parallel_for (
+            (h + 3) / 4, ENCODE_MIN_BATCH, encode_rows_job, &job
+        );
+    }
+    free (owned);
+
+    if (!failed)
+        failed = write_levels (path, &header, blobs); // logging handled inside
+    for (Uint32 i = 0; i < header.level_count; i++) free (blobs[i]);
+    return failed;
+#endif
+}
@@ -0,0 +1,126 @@
+#include <profiler/gpu_timer.h>
+#include <profiler/profiler.h>
+
+#ifdef PROFILER_ENABLED
+
+typedef struct {
+    SDL_GPUFence* fence;
+    const char* name;
+    Uint64 submit;
+} GPUTimerEntry;
+
+static SDL_GPUDevice* timer_device = NULL;
+static SDL_Thread* watcher = NULL;
+static SDL_Semaphore* pending = NULL;
+static SDL_AtomicInt running;
+
+// main thread writes head, the watcher writes waited
+static GPUTimerEntry entries[GPU_TIMER_QUEUE_SIZE];
+static SDL_AtomicU32 head;
+static SDL_AtomicU32 waited;
+static Uint32 released = 0;
+
+static int SDLCALL gpu_timer_thread (void* data) {
+    (void) data;
+    profiler_register_thread ("GPU");
+
+    Uint64 last_complete = 0;
+    for (;;) {
+        SDL_WaitSemaphore (pending);
+        if (!SDL_GetAtomicInt (&running)) break;
+
+        Uint32 index = SDL_GetAtomicU32 (&waited);
+        GPUTimerEntry* entry = &entries[index & (GPU_TIMER_QUEUE_SIZE - 1)];
+        SDL_WaitForGPUFences (timer_device, true, &entry->fence, 1);
+        Uint64 complete = SDL_GetTicksNS ();
+
+        // the queue may still have been busy with the previous submission
+        Uint64 start =
+            entry->submit > last_complete ? entry->submit : last_complete;
+        profiler_record_zone (entry->name, start, complete);
+        last_complete = complete;
+
+        SDL_SetAtomicU32 (&waited, index + 1);
+    }
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+int gpu_timer_init (SDL_GPUDevice* device) {
+    timer_device = device;
+    pending = SDL_CreateSemaphore (0);
+    if (!pending) {
+        SDL_Log ("Failed to create GPU timer semaphore: %s", SDL_GetError ());
+        return 1;
+    }
+
+    SDL_SetAtomicInt (&running, 1);
+    watcher = SDL_CreateThread (gpu_timer_thread, "gpu_timer", NULL);
+    if (!watcher) {
+        SDL_Log ("Failed to create GPU timer thread: %s", SDL_GetError ());
+        SDL_DestroySemaphore (pending);
+        pending = NULL;
+        return 1;
+    }
+    return 0;
+}
+
+// release fences the watcher is done with
+static void gpu_timer_collect (void) {
+    Uint32 done = SDL_GetAtomicU32 (&waited);
+    for (; released != done; released++) {
+        GPUTimerEntry* entry = &entries[released & (GPU_TIMER_QUEUE_SIZE - 1)];
+        SDL_ReleaseGPUFence (timer_device, entry->fence);
+        entry->fence = NULL;
+    }
+}
+
+void gpu_timer_shutdown (void) {
+    if (!watcher) return;
+
+    SDL_SetAtomicInt (&running, 0);
+    SDL_SignalSemaphore (pending);
+    SDL_WaitThread (watcher, NULL);
+    watcher = NULL;
+
+    // whatever the watcher did not get to
+    gpu_timer_collect ();
+    Uint32 end = SDL_GetAtomicU32 (&head);
+    for (; released != end; released++) {
+        GPUTimerEntry* entry = &entries[released & (GPU_TIMER_QUEUE_SIZE - 1)];
+        SDL_WaitForGPUFences (timer_device, true, &entry->fence, 1);
+        SDL_ReleaseGPUFence (timer_device, entry->fence);
+        entry->fence = NULL;
+    }
+    SDL_SetAtomicU32 (&waited, end);
+
+    SDL_DestroySemaphore (pending);
+    pending = NULL;
+    timer_device = NULL;
+}
+
+bool gpu_timer_submit (SDL_GPUCommandBuffer* cmd, const char* name) {
+    if (!watcher) return SDL_SubmitGPUCommandBuffer (cmd);
+
+    gpu_timer_collect ();
+    Uint32 index = SDL_GetAtomicU32 (&head);
+    if (index - released >= GPU_TIMER_QUEUE_SIZE) {
+        // the GPU is far behind; skip timing rather than stall
+        return SDL_SubmitGPUCommandBuffer (cmd);
+    }
+
+    Uint64 submit = SDL_GetTicksNS ();
+    SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence (cmd);
+    if (!fence) return false;
+
+    entries[index & (GPU_TIMER_QUEUE_SIZE - 1)] = (GPUTimerEntry) {
+        .fence = fence,
+        .name = name,
+        .submit = submit
+    };
+    SDL_SetAtomicU32 (&head, index + 1);
+    SDL_SignalSemaphore (pending);
+    return true;
+}
+
+#endif
@@ -0,0 +1,508 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include <profiler/profiler.h>
+
+#ifdef PROFILER_ENABLED
+
+typedef struct {
+    const char* name;
+    const char* parent;
+    Uint64 start;
+    Uint64 end;
+    Uint32 depth;
+} ProfilerEvent;
+
+// single producer (the owning thread), single consumer (profiler_frame_end)
+typedef struct {
+    ProfilerEvent events[PROFILER_RING_SIZE];
+    SDL_AtomicU32 head;
+    SDL_AtomicU32 tail;
+    const char* stack[PROFILER_MAX_DEPTH];
+    Uint64 stack_start[PROFILER_MAX_DEPTH];
+    Uint32 depth;
+    Uint32 dropped;
+    Uint32 index;
+    char name[32];
+} ProfilerThread;
+
+typedef struct {
+    const char* name;
+    const char* parent;
+    Uint32 depth;
+    Uint32 thread;
+    Uint64 frame_ns;
+    Uint32 frame_calls;
+    Uint32 last_calls;
+    Uint64 history[PROFILER_HISTORY];
+    Uint32 history_count;
+    Uint32 history_next;
+} ProfilerZone;
+
+// raw events kept past aggregation for trace export
+typedef struct {
+    const char* name;
+    Uint64 start;
+    Uint64 end;
+    Uint32 thread;
+} TraceEvent;
+
+static ProfilerThread* threads[PROFILER_MAX_THREADS];
+static SDL_AtomicU32 thread_count;
+static SDL_SpinLock thread_lock = 0;
+static _Thread_local ProfilerThread* local_thread = NULL;
+
+static ProfilerZone zones[PROFILER_MAX_ZONES];
+static Uint32 zone_count = 0;
+static Uint64 last_frame = 0;
+
+static TraceEvent trace[PROFILER_TRACE_EVENTS];
+static Uint32 trace_head = 0;
+static Uint32 trace_frame_start[PROFILER_TRACE_FRAMES];
+static Uint64 frame_index = 0;
+static Uint64 trace_threshold_ns = 0;
+static Uint64 next_dump_frame = 0;
+static char trace_prefix[256];
+
+static ProfilerZoneStats stats[PROFILER_MAX_ZONES];
+static Uint32 stats_count = 0;
+static bool stats_dirty = true;
+
+static ProfilerThread* get_local_thread (void) {
+    if (local_thread) return local_thread;
+
+    ProfilerThread* thread = (ProfilerThread*) calloc (1, sizeof (ProfilerThread));
+    if (!thread) {
+        SDL_Log ("Failed to allocate profiler thread buffer");
+        return NULL;
+    }
+
+    SDL_LockSpinlock (&thread_lock);
+    Uint32 count = SDL_GetAtomicU32 (&thread_count);
+    if (count >= PROFILER_MAX_THREADS) {
+        SDL_UnlockSpinlock (&thread_lock);
+        free (thread);
+        return NULL;
+    }
+    thread->index = count;
+    SDL_snprintf (thread->name, sizeof (thread->name), "Thread %u", count);
+    threads[count] = thread;
+    SDL_SetAtomicU32 (&thread_count, count + 1);
+    SDL_UnlockSpinlock (&thread_lock);
+
+    local_thread = thread;
+    return thread;
+}
+
+void profiler_init (void) {
+    // the thread that initializes the profiler owns the frame
+    profiler_register_thread ("Main");
+    last_frame = SDL_GetTicksNS ();
+}
+
+void profiler_shutdown (void) {
+    // other threads must have stopped recording before this is called
+    Uint32 count = SDL_GetAtomicU32 (&thread_count);
+    for (Uint32 i = 0; i < count; i++) {
+        free (threads[i]);
+        threads[i] = NULL;
+    }
+    SDL_SetAtomicU32 (&thread_count, 0);
+    local_thread = NULL;
+    zone_count = 0;
+    stats_count = 0;
+    stats_dirty = true;
+    trace_head = 0;
+    frame_index = 0;
+    next_dump_frame = 0;
+    trace_threshold_ns = 0;
+}
+
+void profiler_reset (void) {
+    Uint32 count = SDL_GetAtomicU32 (&thread_count);
+    for (Uint32 i = 0; i < count; i++) {
+        ProfilerThread* thread = threads[i];
+        SDL_SetAtomicU32 (&thread->tail, SDL_GetAtomicU32 (&thread->head));
+        thread->dropped = 0;
+    }
+    zone_count = 0;
+    stats_count = 0;
+    stats_dirty = true;
+    last_frame = SDL_GetTicksNS ();
+}
+
+void profiler_register_thread (const char* name) {
+    ProfilerThread* thread = get_local_thread ();
+    if (!thread) return;
+    SDL_strlcpy (thread->name, name, sizeof (thread->name));
+}
+
+const char* profiler_thread_name (Uint32 thread) {
+    if (thread >= SDL_GetAtomicU32 (&thread_count)) return "";
+    return threads[thread]->name;
+}
+
+void profiler_begin_zone (const char* name) {
+    ProfilerThread* thread = get_local_thread ();
+    if (!thread) return;
+    if (thread->depth < PROFILER_MAX_DEPTH) {
+        thread->stack[thread->depth] = name;
+        thread->stack_start[thread->depth] = SDL_GetTicksNS ();
+    }
+    thread->depth++;
+}
+
+static void push_event (
+    ProfilerThread* thread,
+    const char* name,
+    const char* parent,
+    Uint32 depth,
+    Uint64 start,
+    Uint64 end
+) {
+    Uint32 head = SDL_GetAtomicU32 (&thread->head);
+    Uint32 tail = SDL_GetAtomicU32 (&thread->tail);
+    if (head - tail >= PROFILER_RING_SIZE) {
+        thread->dropped++;
+        return;
+    }
+    ProfilerEvent* event = &thread->events[head & (PROFILER_RING_SIZE - 1)];
+    event->name = name;
+    event->parent = parent;
+    event->depth = depth;
+    event->start = start;
+    event->end = end;
+    SDL_SetAtomicU32 (&thread->head, head + 1);
+}
+
+void profiler_end_zone (void) {
+    ProfilerThread* thread = local_thread;
+    if (!thread || thread->depth == 0) return;
+    Uint32 depth = --thread->depth;
+    if (depth >= PROFILER_MAX_DEPTH) return;
+
+    push_event (
+        thread, thread->stack[depth], depth ? thread->stack[depth - 1] : NULL,
+        depth, thread->stack_start[depth], SDL_GetTicksNS ()
+    );
+}
+
+void profiler_record_zone (const char* name, Uint64 start_ns, Uint64 end_ns) {
+    ProfilerThread* thread = get_local_thread ();
+    if (!thread || thread->depth >= PROFILER_MAX_DEPTH) return;
+    Uint32 depth = thread->depth;
+
+    push_event (
+        thread, name, depth ? thread->stack[depth - 1] : NULL, depth, start_ns,
+        end_ns
+    );
+}
+
+static bool same_name (const char* a, const char* b) {
+    if (a == b) return true;
+    if (!a || !b) return false;
+    return SDL_strcmp (a, b) == 0;
+}
+
+static ProfilerZone* find_zone (
+    const char* name,
+    const char* parent,
+    Uint32 depth,
+    Uint32 thread
+) {
+    for (Uint32 i = 0; i < zone_count; i++) {
+        ProfilerZone* zone = &zones[i];
+        if (zone->thread == thread && zone->depth == depth &&
+            same_name (zone->name, name) && same_name (zone->parent, parent)) {
+            return zone;
+        }
+    }
+    if (zone_count >= PROFILER_MAX_ZONES) return NULL;
+    ProfilerZone* zone = &zones[zone_count++];
+    *zone = (ProfilerZone) {
+        .name = name,
+        .parent = parent,
+        .depth = depth,
+        .thread = thread
+    };
+    return zone;
+}
+
+static void push_trace (const char* name, Uint64 start, Uint64 end, Uint32 t) {
+    trace[trace_head & (PROFILER_TRACE_EVENTS - 1)] = (TraceEvent) {
+        .name = name,
+        .start = start,
+        .end = end,
+        .thread = t
+    };
+    trace_head++;
+}
+
+void profiler_frame_end (void) {
+    Uint64 now = SDL_GetTicksNS ();
+    Uint64 frame_ns = last_frame ? now - last_frame : 0;
+    trace_frame_start[frame_index % PROFILER_TRACE_FRAMES] = trace_head;
+
+    // the frame itself is the first root zone of the calling thread
+    ProfilerThread* self = get_local_thread ();
+    if (self && last_frame) {
+        ProfilerZone* frame = find_zone ("Frame", NULL, 0, self->index);
+        if (frame) {
+            frame->frame_ns += frame_ns;
+            frame->frame_calls++;
+        }
+        push_trace ("Frame", last_frame, now, self->index);
+    }
+    last_frame = now;
+
+    Uint32 count = SDL_GetAtomicU32 (&thread_count);
+    for (Uint32 t = 0; t < count; t++) {
+        ProfilerThread* thread = threads[t];
+        Uint32 head = SDL_GetAtomicU32 (&thread->head);
+        Uint32 tail = SDL_GetAtomicU32 (&thread->tail);
+        ProfilerZone* last = NULL;
+        for (; tail != head; tail++) {
+            ProfilerEvent* event =
+                &thread->events[tail & (PROFILER_RING_SIZE - 1)];
+            push_trace (event->name, event->start, event->end, t);
+            ProfilerZone* zone = last;
+            if (!zone || zone->name != event->name ||
+                zone->parent != event->parent || zone->depth != event->depth) {
+                zone = find_zone (event->name, event->parent, event->depth, t);
+            }
+            if (!zone) continue;
+            zone->frame_ns += event->end - event->start;
+            zone->frame_calls++;
+            last = zone;
+        }
+        SDL_SetAtomicU32 (&thread->tail, tail);
+    }
+
+    // zones that did not run this frame keep their previous window
+    for (Uint32 i = 0; i < zone_count; i++) {
+        ProfilerZone* zone = &zones[i];
+        if (zone->frame_calls == 0) continue;
+        zone->history[zone->history_next] = zone->frame_ns;
+        zone->history_next = (zone->history_next + 1) % PROFILER_HISTORY;
+        if (zone->history_count < PROFILER_HISTORY) zone->history_count++;
+        zone->last_calls = zone->frame_calls;
+        zone->frame_ns = 0;
+        zone->frame_calls = 0;
+    }
+    stats_dirty = true;
+
+    frame_index++;
+
+    // hitch capture, at most once per window so a slow stretch is one file
+    Uint64 finished = frame_index - 1;
+    if (trace_threshold_ns && frame_ns > trace_threshold_ns &&
+        finished >= next_dump_frame) {
+        char path[300];
+        SDL_snprintf (
+            path, sizeof (path), "%s_%llu.json", trace_prefix,
+            (unsigned long long) finished
+        );
+        SDL_Log (
+            "Frame %llu took %.2f ms, writing %s",
+            (unsigned long long) finished, (double) frame_ns / 1e6, path
+        );
+        profiler_dump_trace (path);
+        next_dump_frame = finished + PROFILER_TRACE_FRAMES;
+    }
+}
+
+static void write_json_string (SDL_IOStream* io, const char* str) {
+    SDL_WriteU8 (io, '"');
+    for (const char* c = str ? str : ""; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            SDL_IOprintf (io, "\\%c", *c);
+        } else if ((unsigned char) *c < 0x20) {
+            SDL_IOprintf (io, "\\u%04x", (unsigned char) *c);
+        } else {
+            SDL_WriteU8 (io, (Uint8) *c);
+        }
+    }
+    SDL_WriteU8 (io, '"');
+}
+
+// Returns 0 on success, 1 on failure
+int profiler_dump_trace (const char* path) {
+    SDL_IOStream* io = SDL_IOFromFile (path, "w");
+    if (!io) {
+        SDL_Log ("Failed to open trace file %s: %s", path, SDL_GetError ());
+        return 1;
+    }
+
+    // oldest retained frame (frame_end records where each one starts),
+    // bounded by what the ring still holds
+    Uint32 first = 0;
+    if (frame_index >= PROFILER_TRACE_FRAMES) {
+        first = trace_frame_start[frame_index % PROFILER_TRACE_FRAMES];
+    }
+    if (trace_head - first > PROFILER_TRACE_EVENTS) {
+        first = trace_head - PROFILER_TRACE_EVENTS;
+    }
+
+    SDL_IOprintf (io, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    Uint32 count = SDL_GetAtomicU32 (&thread_count);
+    for (Uint32 t = 0; t < count; t++) {
+        SDL_IOprintf (
+            io,
+            "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\","
+            "\"args\":{\"name\":",
+            t
+        );
+        write_json_string (io, threads[t]->name);
+        SDL_IOprintf (io, ",\"dropped_events\":%u}},\n", threads[t]->dropped);
+        // a full ring loses zones, so the trace would be missing them
+        if (threads[t]->dropped)
+            SDL_Log (
+                "Profiler dropped %u events on thread %s",
+                threads[t]->dropped, threads[t]->name
+            );
+    }
+    for (Uint32 i = first; i != trace_head; i++) {
+        const TraceEvent* event = &trace[i & (PROFILER_TRACE_EVENTS - 1)];
+        SDL_IOprintf (
+            io, "{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"name\":",
+            event->thread
+        );
+        write_json_string (io, event->name);
+        SDL_IOprintf (
+            io, ",\"ts\":%.3f,\"dur\":%.3f},\n", (double) event->start / 1e3,
+            (double) (event->end - event->start) / 1e3
+        );
+    }
+    // trailing marker keeps every event line comma-terminated
+    SDL_IOprintf (io, "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",");
+    SDL_IOprintf (io, "\"args\":{\"name\":\"Asmadi Engine\"}}\n]}\n");
+
+    if (!SDL_CloseIO (io)) {
+        SDL_Log ("Failed to write trace file %s: %s", path, SDL_GetError ());
+        return 1;
+    }
+    return 0;
+}
+
+void profiler_set_trace_threshold (float threshold_ms, const char* path_prefix) {
+    trace_threshold_ns = threshold_ms > 0.0f ? (Uint64) (threshold_ms * 1e6f) : 0;
+    SDL_strlcpy (
+        trace_prefix, path_prefix ? path_prefix : "trace", sizeof (trace_prefix)
+    );
+}
+
+static int compare_u64 (const void* a, const void* b) {
+    Uint64 x = *(const Uint64*) a;
+    Uint64 y = *(const Uint64*) b;
+    return (x > y) - (x < y);
+}
+
+static void compute_stats (const ProfilerZone* zone, ProfilerZoneStats* out) {
+    Uint64 sorted[PROFILER_HISTORY];
+    Uint32 n = zone->history_count;
+    Uint64 sum = 0;
+    for (Uint32 i = 0; i < n; i++) {
+        sorted[i] = zone->history[i];
+        sum += sorted[i];
+    }
+    qsort (sorted, n, sizeof (Uint64), compare_u64);
+
+    Uint32 last = (zone->history_next + PROFILER_HISTORY - 1) % PROFILER_HISTORY;
+    Uint32 p99 = (Uint32) ceilf ((float) n * 0.99f);
+    p99 = p99 ? p99 - 1 : 0;
+
+    *out = (ProfilerZoneStats) {
+        .name = zone->name,
+        .parent = zone->parent,
+        .depth = zone->depth,
+        .thread = zone->thread,
+        .calls = zone->last_calls,
+        .frames = n,
+        .last_ms = n ? (float) zone->history[last] / 1e6f : 0.0f,
+        .min_ms = n ? (float) sorted[0] / 1e6f : 0.0f,
+        .avg_ms = n ? (float) ((double) sum / (double) n / 1e6) : 0.0f,
+        .max_ms = n ? (float) sorted[n - 1] / 1e6f : 0.0f,
+        .p99_ms = n ? (float) sorted[p99] / 1e6f : 0.0f
+    };
+}
+
+// depth-first so children follow their parent
+static void emit_children (
+    bool* emitted,
+    Uint32 thread,
+    const char* parent,
+    Uint32 depth
+) {
+    if (depth >= PROFILER_MAX_DEPTH) return;
+    for (Uint32 i = 0; i < zone_count; i++) {
+        ProfilerZone* zone = &zones[i];
+        if (emitted[i] || zone->thread != thread || zone->depth != depth ||
+            !same_name (zone->parent, parent) || zone->history_count == 0) {
+            continue;
+        }
+        emitted[i] = true;
+        compute_stats (zone, &stats[stats_count++]);
+        emit_children (emitted, thread, zone->name, depth + 1);
+    }
+}
+
+Uint32 profiler_get_stats (const ProfilerZoneStats** out) {
+    if (stats_dirty) {
+        bool emitted[PROFILER_MAX_ZONES] = {0};
+        stats_count = 0;
+        Uint32 count = SDL_GetAtomicU32 (&thread_count);
+        for (Uint32 t = 0; t < count; t++) {
+            emit_children (emitted, t, NULL, 0);
+        }
+        // zones whose parent has not closed yet
+        for (Uint32 i = 0; i < zone_count; i++) {
+            if (emitted[i] || zones[i].history_count == 0) continue;
+            compute_stats (&zones[i], &stats[stats_count++]);
+        }
+        stats_dirty = false;
+    }
+    *out = stats;
+    return stats_count;
+}
+
+void profiler_draw_ui (mu_Context* ctx) {
+    const ProfilerZoneStats* zone_stats;
+    Uint32 count = profiler_get_stats (&zone_stats);
+
+    if (!mu_begin_window (ctx, "Profiler", mu_rect (10, 60, 460, 320))) return;
+
+    char buffer[96];
+    mu_layout_row (ctx, 5, (int[]) {200, 55, 55, 55, 55}, 0);
+    mu_label (ctx, "zone (ms)");
+    mu_label (ctx, "avg");
+    mu_label (ctx, "min");
+    mu_label (ctx, "max");
+    mu_label (ctx, "p99");
+
+    Uint32 thread = ~0u;
+    for (Uint32 i = 0; i < count; i++) {
+        const ProfilerZoneStats* s = &zone_stats[i];
+        if (s->thread != thread) {
+            thread = s->thread;
+            mu_layout_row (ctx, 1, (int[]) {-1}, 0);
+            mu_label (ctx, profiler_thread_name (thread));
+            mu_layout_row (ctx, 5, (int[]) {200, 55, 55, 55, 55}, 0);
+        }
+        SDL_snprintf (
+            buffer, sizeof (buffer), "%*s%s", (int) s->depth * 2, "", s->name
+        );
+        mu_label (ctx, buffer);
+        SDL_snprintf (buffer, sizeof (buffer), "%.3f", s->avg_ms);
+        mu_label (ctx, buffer);
+        SDL_snprintf (buffer, sizeof (buffer), "%.3f", s->min_ms);
+        mu_label (ctx, buffer);
+        SDL_snprintf (buffer, sizeof (buffer), "%.3f", s->max_ms);
+        mu_label (ctx, buffer);
+        SDL_snprintf (buffer, sizeof (buffer), "%.3f", s->p99_ms);
+        mu_label (ctx, buffer);
+    }
+
+    mu_end_window (ctx);
+}
+
+#endif
@@ -7,6 +7,8 @@
 
 #include <microui.h>
 
+#include <gpu/staging_ring.h>
+#include <profiler/profiler.h>
 #include <ui/ui.h>
 
 // 0 length for null terminated string
@@ -90,6 +92,7 @@ UIComponent* create_ui_component (
     const char* font_path,
     const float ptsize
 ) {
+    PROFILE_ZONE ("create_ui_component");
     UIComponent* ui = malloc (sizeof (UIComponent));
     if (ui == NULL) {
         SDL_Log ("Failed to allocate UI component");
@@ -312,6 +315,7 @@ void draw_rectangle (
     ui->rects[ui->rect_count].rect = (SDL_FRect) {x, y, w, h};
     ui->rects[ui->rect_count].color = (SDL_FColor) {r, g, b, a};
     ui->rects[ui->rect_count].texture = ui->white_texture;
+    ui->rects[ui->rect_count].clip = (SDL_Rect) {0};
     ui->rect_count++;
 }
 
@@ -331,40 +335,22 @@ ui_create_text_texture (SDL_GPUDevice* device, SDL_Surface* abgr) {
         SDL_Log ("UI text texture create failed: %s", SDL_GetError ());
         return NULL;
     }
-    SDL_GPUTransferBufferCreateInfo tbinfo = {
-        .size = (Uint32) (abgr->pitch * abgr->h),
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD
-    };
-    SDL_GPUTransferBuffer* tbuf = SDL_CreateGPUTransferBuffer (device, &tbinfo);
-    if (!tbuf) {
-        SDL_ReleaseGPUTexture (device, tex);
-        SDL_Log ("UI text transfer buffer create failed: %s", SDL_GetError ());
-        return NULL;
-    }
-    void* map = SDL_MapGPUTransferBuffer (device, tbuf, false);
+    // uploaded with the rest of the frame's UI by staging_ring_flush()
+    SDL_GPUTextureRegion dst =
+        {.texture = tex, .w = (Uint32) abgr->w, .h = (Uint32) abgr->h, .d = 1};
+    size_t row_size = (size_t) abgr->w * 4;
+    Uint8* map = (Uint8*) staging_upload_texture (
+        &dst, (Uint32) (row_size * (size_t) abgr->h)
+    );
     if (!map) {
-        SDL_ReleaseGPUTransferBuffer (device, tbuf);
         SDL_ReleaseGPUTexture (device, tex);
-        SDL_Log ("UI text transfer buffer map failed: %s", SDL_GetError ());
-        return NULL;
+        return NULL; // logging handled in staging_upload_texture()
     }
-    memcpy (map, abgr->pixels, tbinfo.size);
-    SDL_UnmapGPUTransferBuffer (device, tbuf);
-
-    SDL_GPUCommandBuffer* cmd = SDL_AcquireGPUCommandBuffer (device);
-    SDL_GPUCopyPass* copy = SDL_BeginGPUCopyPass (cmd);
-    SDL_GPUTextureTransferInfo src = {
-        .transfer_buffer = tbuf,
-        .offset = 0,
-        .pixels_per_row = (Uint32) abgr->w,
-        .rows_per_layer = (Uint32) abgr->h
-    };
-    SDL_GPUTextureRegion dst =
-        {.texture = tex, .w = (Uint32) abgr->w, .h = (Uint32) abgr->h, .d = 1};
-    SDL_UploadToGPUTexture (copy, &src, &dst, false);
-    SDL_EndGPUCopyPass (copy);
-    SDL_SubmitGPUCommandBuffer (cmd);
-    SDL_ReleaseGPUTransferBuffer (device, tbuf);
+    for (int y = 0; y < abgr->h; y++)
+        memcpy (
+            map + y * row_size,
+            (const Uint8*) abgr->pixels + (size_t) y * abgr->pitch, row_size
+        );
     return tex;
 }
 
@@ -379,6 +365,7 @@ int draw_text (
     float b,
     float a
 ) {
+    PROFILE_ZONE ("draw_text");
     if (!ui || !ui->font || !utf8) return 0;
     if (ui->rect_count >= ui->max_rects) return 0;
 
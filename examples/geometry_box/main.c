@@ -9,6 +9,7 @@
 #include <geometry/box.h>
 #include <material/m_common.h>
 #include <material/phong_material.h>
+#include <material/texture_array.h>
 
 #define STARTING_WIDTH 640
 #define STARTING_HEIGHT 480
@@ -103,26 +104,15 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
     state->dheight = state->height;
 
     // load texture
-    state->white_texture = create_white_texture (state->device);
+    state->white_texture = create_white_texture_array (state->device);
     if (!state->white_texture)
         return SDL_APP_FAILURE; // logging handled inside load_texture()
 
     // create sampler
-    SDL_GPUSamplerCreateInfo sampler_info = {
-        .min_filter = SDL_GPU_FILTER_LINEAR,
-        .mag_filter = SDL_GPU_FILTER_LINEAR,
-        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
-        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .max_anisotropy = 1.0f,
-        .enable_anisotropy = false
-    };
-    state->sampler = SDL_CreateGPUSampler (state->device, &sampler_info);
-    if (!state->sampler) {
-        SDL_Log ("Failed to create sampler: %s", SDL_GetError ());
-        return SDL_APP_FAILURE;
-    }
+    state->sampler =
+        create_texture_sampler (state->device, TEXTURE_ANISOTROPY);
+    if (!state->sampler)
+        return SDL_APP_FAILURE; // logging handled inside
 
     // create box entity
     box = create_entity ();
@@ -151,8 +141,10 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
     // textured box material
     MaterialComponent tbox_material =
         create_phong_material ((vec3) {1.0f, 1.0f, 1.0f}, SIDE_FRONT, state);
-    tbox_material.texture = load_texture (state->device, "assets/test.png");
-    if (tbox_material.texture == NULL) return SDL_APP_FAILURE;
+    if (load_material_texture (
+            state->device, &tbox_material, "assets/test.png"
+        ))
+        return SDL_APP_FAILURE; // logging handled in load_material_texture()
     add_material (tbox, tbox_material);
     // textured box transform
     add_transform (
@@ -103,26 +103,15 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
     state->dheight = state->height;
 
     // load texture
-    state->white_texture = create_white_texture (state->device);
+    state->white_texture = create_white_texture_array (state->device);
     if (!state->white_texture)
         return SDL_APP_FAILURE; // logging handled inside load_texture()
 
     // create sampler
-    SDL_GPUSamplerCreateInfo sampler_info = {
-        .min_filter = SDL_GPU_FILTER_LINEAR,
-        .mag_filter = SDL_GPU_FILTER_LINEAR,
-        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
-        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .max_anisotropy = 1.0f,
-        .enable_anisotropy = false
-    };
-    state->sampler = SDL_CreateGPUSampler (state->device, &sampler_info);
-    if (!state->sampler) {
-        SDL_Log ("Failed to create sampler: %s", SDL_GetError ());
-        return SDL_APP_FAILURE;
-    }
+    state->sampler =
+        create_texture_sampler (state->device, TEXTURE_ANISOTROPY);
+    if (!state->sampler)
+        return SDL_APP_FAILURE; // logging handled inside
 
     // circle
     circle = create_entity ();
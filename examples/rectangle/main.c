@@ -8,8 +8,17 @@
 
 #include <microui.h>
 
+#include <assets/asset_loader.h>
+#include <geometry/gltf.h>
+#include <geometry/mesh_cache.h>
 #include <geometry/torus.h>
+#include <gpu/draw_list.h>
+#include <gpu/staging_ring.h>
+#include <jobs/jobs.h>
+#include <material/depth_prepass.h>
 #include <material/phong_material.h>
+#include <profiler/gpu_timer.h>
+#include <profiler/profiler.h>
 #include <ui/ui.h>
 
 #define STARTING_WIDTH 1280
@@ -17,6 +26,8 @@
 #define STARTING_FOV 70.0
 #define MOUSE_SENSE 1.0f / 100.0f
 #define MOVEMENT_SPEED 3.0f
+#define TORUS_LODS 2 // coarser levels below the full torus
+#define MESH_CACHE_DIR "cache"
 
 
 typedef struct {
@@ -24,6 +35,7 @@ typedef struct {
     gpu_renderer renderer;
     Entity player;
     Entity torus;
+    Entity cached_torus;
     Uint64 last_time;
     Uint64 prerender;
     Uint64 preui;
@@ -33,6 +45,80 @@ typedef struct {
     bool relative_mouse;
 } AppState;
 
+typedef struct {
+    float radius;
+    float tube_radius;
+    int radial_segments;
+    int tubular_segments;
+    float arc;
+    int lod_count;
+} TorusParams;
+
+static const TorusParams torus_params = {
+    0.5f, 0.2f, 16, 32, (float) M_PI * 2.0f, TORUS_LODS
+};
+
+// loads the torus from the mesh cache, generating and caching it on a miss
+static MeshComponent load_torus (SDL_GPUDevice* device) {
+    TorusParams params = torus_params;
+
+    char path[512];
+    mesh_cache_path (
+        path, sizeof (path), MESH_CACHE_DIR, "torus", &params, sizeof (params)
+    );
+    MeshComponent mesh;
+    if (!load_mesh_cache (device, path, &mesh)) return mesh;
+
+    MeshData levels[TORUS_LODS + 1];
+    Uint32 count = build_torus_mesh_lods (
+        params.radius, params.tube_radius, params.radial_segments,
+        params.tubular_segments, params.arc, params.lod_count, levels
+    );
+    mesh = upload_mesh_levels (device, levels, count);
+    // a failed write only costs the next startup a regeneration
+    SDL_CreateDirectory (MESH_CACHE_DIR);
+    if (mesh.vertex_buffer) write_mesh_cache (path, levels, count);
+    for (Uint32 i = 0; i < count; i++) free_mesh_data (&levels[i]);
+    return mesh;
+}
+
+// Returns 0 on success, 1 on failure
+// an entity per primitive of the .glb at path, moved by offset
+static int
+add_glb_model (gpu_renderer* renderer, const char* path, vec3 offset) {
+    GltfModel model;
+    if (load_glb (renderer->device, path, &model))
+        return 1; // logging handled in load_glb()
+    for (Uint32 i = 0; i < model.primitive_count; i++) {
+        const GltfPrimitive* primitive = &model.primitives[i];
+        Entity e = create_entity ();
+        add_mesh (e, primitive->mesh);
+        add_material (
+            e, create_phong_material (
+                   (vec3) {0.8f, 0.4f, 0.1f}, SIDE_FRONT, renderer
+               )
+        );
+        add_transform (
+            e, (vec3) {0.0f, 0.0f, 0.0f}, (vec3) {0.0f, 0.0f, 0.0f},
+            (vec3) {1.0f, 1.0f, 1.0f}
+        );
+        TransformComponent* trans = get_transform (e);
+        *trans = primitive->transform;
+        trans->position = vec3_add (trans->position, offset);
+    }
+    free_gltf_model (&model);
+    return 0;
+}
+
+// MeshBuilder for the asset loader; the async torus has no coarser levels
+static int build_torus (const void* params, MeshData* out) {
+    const TorusParams* torus = (const TorusParams*) params;
+    return build_torus_mesh (
+        torus->radius, torus->tube_radius, torus->radial_segments,
+        torus->tubular_segments, torus->arc, out
+    ); // logging handled in build_torus_mesh()
+}
+
 SDL_AppResult SDL_AppEvent (void* appstate, SDL_Event* event) {
     AppState* state = (AppState*) appstate;
 
@@ -49,6 +135,9 @@ SDL_AppResult SDL_AppEvent (void* appstate, SDL_Event* event) {
             state->relative_mouse = !state->relative_mouse;
             SDL_SetWindowRelativeMouseMode (state->renderer.window, state->relative_mouse);
         }
+        if (event->key.key == SDLK_F2) profiler_dump_trace ("trace.json");
+        if (event->key.key == SDLK_F3)
+            state->renderer.depth_prepass = !state->renderer.depth_prepass;
         break;
     }
 
@@ -131,26 +220,16 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
     state->renderer.dheight = state->renderer.height;
 
     // load texture
-    state->renderer.white_texture = create_white_texture (state->renderer.device);
+    state->renderer.white_texture =
+        create_white_texture_array (state->renderer.device);
     if (!state->renderer.white_texture)
         return SDL_APP_FAILURE; // logging handled inside load_texture()
 
     // create sampler
-    SDL_GPUSamplerCreateInfo sampler_info = {
-        .min_filter = SDL_GPU_FILTER_LINEAR,
-        .mag_filter = SDL_GPU_FILTER_LINEAR,
-        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
-        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .max_anisotropy = 1.0f,
-        .enable_anisotropy = false
-    };
-    state->renderer.sampler = SDL_CreateGPUSampler (state->renderer.device, &sampler_info);
-    if (!state->renderer.sampler) {
-        SDL_Log ("Failed to create sampler: %s", SDL_GetError ());
-        return SDL_APP_FAILURE;
-    }
+    state->renderer.sampler =
+        create_texture_sampler (state->renderer.device, TEXTURE_ANISOTROPY);
+    if (!state->renderer.sampler)
+        return SDL_APP_FAILURE; // logging handled inside
 
     // player
     state->player = create_entity ();
@@ -173,13 +252,23 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
     // ui->context.style->title_height = 30;
     // ui->context.style->padding = 6;
 
-    // torus
+    // worker threads for mesh generation
+    if (jobs_init (0)) {
+        return SDL_APP_FAILURE; // logging handled in jobs_init
+    }
+
+    // meshes and textures generated and decoded off the main thread
+    if (asset_loader_init (0)) {
+        return SDL_APP_FAILURE; // logging handled in asset_loader_init
+    }
+
+    // torus, drawn from the first frame its mesh is uploaded
     state->torus = create_entity ();
-    MeshComponent torus_mesh = create_torus_mesh (
-        0.5f, 0.2f, 16, 32, (float) M_PI * 2.0f, state->renderer.device
-    );
-    if (torus_mesh.vertex_buffer == NULL) return SDL_APP_FAILURE;
-    add_mesh (state->torus, torus_mesh);
+    if (load_mesh_async (
+            state->torus, build_torus, &torus_params, sizeof (torus_params)
+        )) {
+        return SDL_APP_FAILURE; // logging handled in load_mesh_async
+    }
     // torus material
     MaterialComponent torus_material =
         create_phong_material ((vec3) {0.0f, 1.0f, 0.0f}, SIDE_FRONT, &state->renderer);
@@ -190,6 +279,29 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
         (vec3) {1.0f, 1.0f, 1.0f}
     );
 
+    // the same torus with levels of detail, through the mesh cache
+    state->cached_torus = create_entity ();
+    MeshComponent cached_mesh = load_torus (state->renderer.device);
+    if (cached_mesh.vertex_buffer == NULL) return SDL_APP_FAILURE;
+    add_mesh (state->cached_torus, cached_mesh);
+    add_material (
+        state->cached_torus,
+        create_phong_material (
+            (vec3) {0.2f, 0.4f, 1.0f}, SIDE_FRONT, &state->renderer
+        )
+    );
+    add_transform (
+        state->cached_torus, (vec3) {-1.5f, 0.0f, 0.0f},
+        (vec3) {0.0f, 0.0f, 0.0f}, (vec3) {1.0f, 1.0f, 1.0f}
+    );
+
+    // a glTF model beside it
+    if (add_glb_model (
+            &state->renderer, "./assets/cube.glb", (vec3) {1.5f, 0.0f, 0.0f}
+        )) {
+        return SDL_APP_FAILURE; // logging handled in add_glb_model
+    }
+
     // ambient light
     Entity ambient_light = create_entity ();
     add_ambient_light (ambient_light, (vec3) {1.0f, 1.0f, 1.0f}, 0.1f);
@@ -202,6 +314,23 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
         (vec3) {1.0f, 1.0f, 1.0f}
     );
 
+    profiler_init ();
+    profiler_set_trace_threshold (50.0f, "hitch");
+    if (gpu_timer_init (state->renderer.device)) {
+        return SDL_APP_FAILURE; // logging handled in gpu_timer_init
+    }
+    if (staging_ring_init (state->renderer.device)) {
+        return SDL_APP_FAILURE; // logging handled in staging_ring_init
+    }
+    if (draw_list_init (state->renderer.device)) {
+        return SDL_APP_FAILURE; // logging handled in draw_list_init
+    }
+    // F3 toggles it; without it materials just shade as they draw
+    depth_prepass_init (&state->renderer); // logging handled inside
+    // build each frame's draws while the previous one is submitted
+    if (render_pipeline_init (&state->renderer, 2)) {
+        return SDL_APP_FAILURE; // logging handled in render_pipeline_init
+    }
     state->last_time = SDL_GetPerformanceCounter ();
 
     *appstate = state;
@@ -223,9 +352,6 @@ SDL_AppResult SDL_AppIterate (void* appstate) {
                (float) (SDL_GetPerformanceFrequency ());
     state->last_time = now;
 
-    float render_time_ms = (float) (state->postrender - state->prerender) / 1e6;
-    float mesh_time_ms = (float) (state->preui - state->prerender) / 1e6;
-    float ui_time_ms = (float) (state->postrender - state->preui) / 1e6;
     state->frame_count++;
 
     // draw ui
@@ -236,21 +362,16 @@ SDL_AppResult SDL_AppIterate (void* appstate) {
         mu_label (&ui->context, "Test label");
         mu_end_window (&ui->context);
     }
+    profiler_draw_ui (&ui->context);
     mu_end (&ui->context);
     // ui_render (state, ui);
 
     char buffer[64];
-    sprintf (buffer, "Mesh render: %.1f", mesh_time_ms);
-    draw_text (ui, state->renderer.device, buffer, 5.0f, 5.0f, 1.0f, 1.0f, 1.0f, 1.0f);
-    sprintf (buffer, "UI render: %.1f", ui_time_ms);
-    draw_text (ui, state->renderer.device, buffer, 5.0f, 17.0f, 1.0f, 1.0f, 1.0f, 1.0f);
-    sprintf (buffer, "Total render: %.1f", render_time_ms);
-    draw_text (ui, state->renderer.device, buffer, 5.0f, 29.0f, 1.0f, 1.0f, 1.0f, 1.0f);
-    if (state->frame_count % 60 == 0) {
-        state->frame_rate = 1000.0f / render_time_ms;
+    if (state->frame_count % 60 == 0 && dt > 0.0f) {
+        state->frame_rate = 1.0f / dt;
     }
     sprintf (buffer, "Framerate: %.3f", state->frame_rate);
-    draw_text (ui, state->renderer.device, buffer, 5.0f, 41.0f, 1.0f, 1.0f, 1.0f, 1.0f);
+    draw_text (ui, state->renderer.device, buffer, 5.0f, 5.0f, 1.0f, 1.0f, 1.0f, 1.0f);
 
     TransformComponent transform = *get_transform (state->torus);
     vec3 rotation = euler_from_quat (transform.rotation);
@@ -262,8 +383,12 @@ SDL_AppResult SDL_AppIterate (void* appstate) {
     // camera forward vector
     fps_controller_update_system (dt);
 
+    // attach whatever the loader threads have finished
+    asset_loader_update (state->renderer.device);
+
     render_system (&state->renderer, cam, &state->prerender, &state->preui, &state->postrender);
 
+    PROFILE_FRAME_END ();
     return SDL_APP_CONTINUE;
 }
 
@@ -278,7 +403,15 @@ void SDL_AppQuit (void* appstate, SDL_AppResult result) {
     if (ui.fragment) SDL_ReleaseGPUShader (state->renderer.device, ui.fragment);
     if (ui.vertex) SDL_ReleaseGPUShader (state->renderer.device, ui.vertex);
 
+    render_pipeline_shutdown ();
+    gpu_timer_shutdown ();
+    staging_ring_shutdown ();
+    draw_list_shutdown ();
+    depth_prepass_shutdown ();
+    asset_loader_shutdown ();
     free_pools (state->renderer.device);
+    jobs_shutdown ();
+    profiler_shutdown ();
     if (state->renderer.white_texture) {
         SDL_ReleaseGPUTexture (state->renderer.device, state->renderer.white_texture);
     }
@@ -288,4 +421,7 @@ void SDL_AppQuit (void* appstate, SDL_AppResult result) {
     if (state->renderer.depth_texture) {
         SDL_ReleaseGPUTexture (state->renderer.device, state->renderer.depth_texture);
     }
+    if (state->renderer.color_texture) {
+        SDL_ReleaseGPUTexture (state->renderer.device, state->renderer.color_texture);
+    }
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include <SDL3/SDL_main.h>
 
 #include <ecs/ecs.h>
+#include <geometry/g_common.h>
 #include <geometry/icosahedron.h>
 #include <material/m_common.h>
 #include <material/phong_material.h>
@@ -112,26 +113,15 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
     state->dheight = state->height;
 
     // load texture
-    state->white_texture = create_white_texture (state->device);
+    state->white_texture = create_white_texture_array (state->device);
     if (!state->white_texture)
         return SDL_APP_FAILURE; // logging handled inside load_texture()
 
     // create sampler
-    SDL_GPUSamplerCreateInfo sampler_info = {
-        .min_filter = SDL_GPU_FILTER_LINEAR,
-        .mag_filter = SDL_GPU_FILTER_LINEAR,
-        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR,
-        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT,
-        .max_anisotropy = 1.0f,
-        .enable_anisotropy = false
-    };
-    state->sampler = SDL_CreateGPUSampler (state->device, &sampler_info);
-    if (!state->sampler) {
-        SDL_Log ("Failed to create sampler: %s", SDL_GetError ());
-        return SDL_APP_FAILURE;
-    }
+    state->sampler =
+        create_texture_sampler (state->device, TEXTURE_ANISOTROPY);
+    if (!state->sampler)
+        return SDL_APP_FAILURE; // logging handled inside
 
     // spawn 8k icosahedrons
     // we want to be able to handle way more (e.g., ~1000000)
@@ -141,25 +131,31 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
     // TODO: fix that
     // also it'd be nice to be able to initialize the entity pool to some
     // starting number if we know ahead of time that we need a lot.
+    // every icosahedron shares one mesh and one material, keeping only its
+    // color, so they all draw in a single batch
+    MeshComponent icosahedron_mesh =
+        create_icosahedron_mesh (0.5, state->device);
+    if (icosahedron_mesh.vertex_buffer == NULL) return SDL_APP_FAILURE;
+    MaterialComponent icosahedron_material =
+        create_phong_material ((vec3) {1.0f, 1.0f, 1.0f}, SIDE_FRONT, state);
+    if (icosahedron_material.vertex_shader == NULL) return SDL_APP_FAILURE;
     for (int i = -10; i < 10; i++) {
         for (int j = -10; j < 10; j++) {
             for (int k = -10; k < 10; k++) {
                 Entity ico = create_entity ();
                 icosahedrons[(i + 10) * 400 + (j + 10) * 20 + (k + 10)] = ico;
-                MeshComponent icosahedron_mesh =
-                    create_icosahedron_mesh (0.5, state->device);
-                if (icosahedron_mesh.vertex_buffer == NULL)
+                MeshComponent mesh;
+                if (share_mesh (&icosahedron_mesh, &mesh))
                     return SDL_APP_FAILURE;
-                add_mesh (ico, icosahedron_mesh);
+                add_mesh (ico, mesh);
 
                 vec3 color = {
                     random_float (), random_float (), random_float ()
                 };
-                MaterialComponent icosahedron_material =
-                    create_phong_material (color, SIDE_FRONT, state);
-                if (icosahedron_material.vertex_shader == NULL)
+                MaterialComponent material;
+                if (share_material (&icosahedron_material, color, &material))
                     return SDL_APP_FAILURE;
-                add_material (ico, icosahedron_material);
+                add_material (ico, material);
                 vec3 position = {
                     2.0f * (float) i, 2.0f * (float) j, 2.0f * (float) k
                 };
@@ -175,6 +171,9 @@ SDL_AppResult SDL_AppInit (void** appstate, int argc, char** argv) {
         }
         printf ("spawned %d icos\n", (i + 11) * 400);
     }
+    // the entities hold their own references now
+    release_mesh (state->device, &icosahedron_mesh);
+    release_material (state->device, &icosahedron_material);
 
     // ambient light
     Entity ambient_light = create_entity ();
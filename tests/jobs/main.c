@@ -0,0 +1,116 @@
+#include <stdio.h>
+
+#include <SDL3/SDL.h>
+
+#include <jobs/jobs.h>
+
+// Job system checks: every item of a loop runs exactly once, including when
+// a job body issues a loop of its own, and a loop submitted while another
+// thread's loop is in flight still gets workers. Exits non-zero on the first
+// failure.
+
+#define OUTER_COUNT 64
+#define INNER_COUNT 4096
+#define WAIT_MS 5000
+
+static SDL_AtomicInt visits[OUTER_COUNT][INNER_COUNT];
+
+// the held loop stays in flight until the second loop has finished
+static SDL_AtomicInt held_started;
+static SDL_AtomicInt second_helped;
+static SDL_AtomicInt second_done;
+static SDL_ThreadID second_submitter;
+
+static void inner_job (void* data, Uint32 start, Uint32 end) {
+    SDL_AtomicInt* row = (SDL_AtomicInt*) data;
+    for (Uint32 i = start; i < end; i++) SDL_AddAtomicInt (&row[i], 1);
+}
+
+static void outer_job (void* data, Uint32 start, Uint32 end) {
+    (void) data;
+    for (Uint32 i = start; i < end; i++)
+        jobs_parallel_for (INNER_COUNT, 64, inner_job, visits[i]);
+}
+
+// false once WAIT_MS passes with flag still clear
+static bool wait_for (SDL_AtomicInt* flag) {
+    Uint64 deadline = SDL_GetTicks () + WAIT_MS;
+    while (!SDL_GetAtomicInt (flag)) {
+        if (SDL_GetTicks () > deadline) return false;
+        SDL_Delay (1);
+    }
+    return true;
+}
+
+static void held_job (void* data, Uint32 start, Uint32 end) {
+    (void) data, (void) start, (void) end;
+    SDL_SetAtomicInt (&held_started, 1);
+    wait_for (&second_done);
+}
+
+// every batch waits for one run by a worker, so a loop left to its
+// submitter alone times out
+static void helped_job (void* data, Uint32 start, Uint32 end) {
+    (void) data, (void) start, (void) end;
+    if (SDL_GetCurrentThreadID () != second_submitter)
+        SDL_SetAtomicInt (&second_helped, 1);
+    wait_for (&second_helped);
+}
+
+static int SDLCALL submit_held (void* data) {
+    (void) data;
+    jobs_parallel_for (2, 1, held_job, NULL);
+    return 0;
+}
+
+// Returns 0 on success, 1 on failure
+static int check_concurrent (void) {
+    SDL_Thread* thread = SDL_CreateThread (submit_held, "submitter", NULL);
+    if (!thread) {
+        SDL_Log ("Failed to create submitter: %s", SDL_GetError ());
+        return 1;
+    }
+    bool failed = !wait_for (&held_started);
+    second_submitter = SDL_GetCurrentThreadID ();
+    if (!failed) jobs_parallel_for (8, 1, helped_job, NULL);
+    failed = failed || !SDL_GetAtomicInt (&second_helped);
+    SDL_SetAtomicInt (&second_done, 1);
+    SDL_WaitThread (thread, NULL);
+    if (failed) SDL_Log ("concurrent: the second loop got no workers");
+    return failed;
+}
+
+// Returns 0 on success, 1 on failure
+static int check_visits (const char* name, int expected) {
+    for (Uint32 o = 0; o < OUTER_COUNT; o++) {
+        for (Uint32 i = 0; i < INNER_COUNT; i++) {
+            int count = SDL_GetAtomicInt (&visits[o][i]);
+            if (count != expected) {
+                SDL_Log (
+                    "%s: item %u of loop %u ran %d times, not %d", name, i, o,
+                    count, expected
+                );
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main (void) {
+    if (jobs_init (4)) return 1; // logging handled in jobs_init()
+
+    // a flat loop per row, then the same rows again from nested loops
+    for (Uint32 o = 0; o < OUTER_COUNT; o++)
+        jobs_parallel_for (INNER_COUNT, 64, inner_job, visits[o]);
+    int failed = check_visits ("flat", 1);
+    for (int r = 0; r < 16 && !failed; r++) {
+        jobs_parallel_for (OUTER_COUNT, 1, outer_job, NULL);
+        failed = check_visits ("nested", r + 2);
+    }
+    if (!failed) failed = check_concurrent ();
+
+    jobs_shutdown ();
+    printf ("jobs: %s\n", failed ? "FAILED" : "ok");
+    return failed;
+}
@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+
+#include <jobs/jobs.h>
+#include <material/texture_file.h>
+
+// Converts any image SDL_image can read into an .atex file for
+// load_texture(): block compressed with a precomputed mip chain. Without a
+// format flag, opaque images become BC1 and the rest BC7.
+
+static void usage (const char* argv0) {
+    SDL_Log (
+        "usage: %s [--bc1 | --bc3 | --bc7 | --rgba8] [--no-mips] INPUT OUTPUT",
+        argv0
+    );
+}
+
+static bool is_opaque (const SDL_Surface* surface) {
+    for (int y = 0; y < surface->h; y++) {
+        const Uint8* row = (const Uint8*) surface->pixels + y * surface->pitch;
+        for (int x = 0; x < surface->w; x++)
+            if (row[x * 4 + 3] != 255) return false;
+    }
+    return true;
+}
+
+int main (int argc, char** argv) {
+    int format = -1; // chosen from the image
+    bool mips = true;
+    const char* input = NULL;
+    const char* output = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (SDL_strcmp (argv[i], "--bc1") == 0) {
+            format = TEXTURE_FILE_BC1;
+        } else if (SDL_strcmp (argv[i], "--bc3") == 0) {
+            format = TEXTURE_FILE_BC3;
+        } else if (SDL_strcmp (argv[i], "--bc7") == 0) {
+            format = TEXTURE_FILE_BC7;
+        } else if (SDL_strcmp (argv[i], "--rgba8") == 0) {
+            format = TEXTURE_FILE_RGBA8;
+        } else if (SDL_strcmp (argv[i], "--no-mips") == 0) {
+            mips = false;
+        } else if (!input) {
+            input = argv[i];
+        } else if (!output) {
+            output = argv[i];
+        } else {
+            usage (argv[0]);
+            return 1;
+        }
+    }
+    if (!input || !output) {
+        usage (argv[0]);
+        return 1;
+    }
+
+    SDL_Surface* loaded = IMG_Load (input);
+    if (!loaded) {
+        SDL_Log ("Failed to load %s: %s", input, SDL_GetError ());
+        return 1;
+    }
+    SDL_Surface* surface =
+        SDL_ConvertSurface (loaded, SDL_PIXELFORMAT_ABGR8888);
+    SDL_DestroySurface (loaded);
+    if (!surface) {
+        SDL_Log ("Failed to convert surface format: %s", SDL_GetError ());
+        return 1;
+    }
+
+    // the writer wants tightly packed rows
+    Uint32 width = (Uint32) surface->w;
+    Uint32 height = (Uint32) surface->h;
+    Uint8* rgba = (Uint8*) malloc ((size_t) width * height * 4);
+    if (!rgba) {
+        SDL_Log ("Failed to allocate %ux%u image", width, height);
+        SDL_DestroySurface (surface);
+        return 1;
+    }
+    for (Uint32 y = 0; y < height; y++)
+        SDL_memcpy (
+            rgba + (size_t) y * width * 4,
+            (const Uint8*) surface->pixels + (size_t) y * surface->pitch,
+            (size_t) width * 4
+        );
+    if (format < 0)
+        format = is_opaque (surface) ? TEXTURE_FILE_BC1 : TEXTURE_FILE_BC7;
+    SDL_DestroySurface (surface);
+
+    if (jobs_init (0)) return 1; // logging handled in jobs_init()
+    Uint64 start = SDL_GetTicksNS ();
+    int failed = write_texture_file (
+        output, (TextureFileFormat) format, rgba, width, height, mips
+    );
+    Uint64 elapsed = SDL_GetTicksNS () - start;
+    jobs_shutdown ();
+    free (rgba);
+    if (failed) return 1; // logging handled in write_texture_file()
+
+    static const char* names[TEXTURE_FILE_FORMAT_COUNT] =
+        {"RGBA8", "BC1", "BC3", "BC7"};
+    Uint64 size =
+        texture_level_size ((TextureFileFormat) format, width, height);
+    printf (
+        "%s: %ux%u %s, level 0 %llu bytes (%.1fx smaller than RGBA8), "
+        "%.1f ms\n",
+        output, width, height, names[format], (unsigned long long) size,
+        (double) width * height * 4 / (double) size, (double) elapsed / 1e6
+    );
+    return 0;
+}